@@ -0,0 +1,54 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESAllocStats.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef GLES_ALLOC_STATS
+
+// 计数器按线程保存, 渲染线程的统计不受其他线程影响, 也不需要原子操作
+static thread_local uint64_t tAllocCount = 0;
+static thread_local uint64_t tAllocBytes = 0;
+
+// 替换全局operator new/delete, 数组版本和nothrow版本默认都会转到这里
+void *operator new(std::size_t size) {
+    ++tAllocCount;
+    tAllocBytes += size;
+    void *p = malloc(size ? size : 1);
+    if (!p) { throw std::bad_alloc(); }
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    free(p);
+}
+
+GLESAllocCounters getAllocCounters() {
+    GLESAllocCounters counters;
+    counters.allocCount = tAllocCount;
+    counters.allocBytes = tAllocBytes;
+    return counters;
+}
+
+bool isAllocStatsEnabled() {
+    return true;
+}
+
+#else
+
+GLESAllocCounters getAllocCounters() {
+    return GLESAllocCounters();
+}
+
+bool isAllocStatsEnabled() {
+    return false;
+}
+
+#endif
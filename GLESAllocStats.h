@@ -0,0 +1,21 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESALLOCSTATS_H
+#define GLES_DEMO_GLESALLOCSTATS_H
+
+#include <cstdint>
+
+// 当前线程累计的堆分配次数和字节数, 未开启GLES_ALLOC_STATS时恒为0
+struct GLESAllocCounters {
+    uint64_t allocCount = 0;
+    uint64_t allocBytes = 0;
+};
+
+GLESAllocCounters getAllocCounters();
+
+bool isAllocStatsEnabled();
+
+
+#endif //GLES_DEMO_GLESALLOCSTATS_H
@@ -0,0 +1,292 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESCompositor.h"
+#include "GLESTrace.h"
+#include "GLESThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GLES_COMPOSITOR_X86 1
+#include <immintrin.h>
+#endif
+
+// 每次收集多少个像素交给混合核, 收集缓冲放在栈上
+static const int GATHER_PIXELS = 64;
+
+/* 标量参考实现, SIMD版本必须与之逐位一致: 运算顺序相同, 都不用FMA */
+
+static void blendScalar(const unsigned char *first, const unsigned char *second, const float *weights,
+                        unsigned char *dst, size_t pixels) {
+    const float inv255 = 1.0f / 255.0f;
+    for (size_t i = 0; i < pixels; ++i) {
+        float w = weights[i];
+        float keep = 1.0f - w;
+        for (size_t c = i * 4; c < i * 4 + 4; ++c) {
+            float value = (first[c] * inv255) * keep + (second[c] * inv255) * w;
+            dst[c] = (unsigned char) (int) (value * 255.0f + 0.5f);
+        }
+    }
+}
+
+#ifdef GLES_COMPOSITOR_X86
+
+/* SSE2: 每次4个像素, 每个像素的4个通道放在一个向量里 */
+
+__attribute__((target("sse2")))
+static inline __m128 blendPixelSse2(__m128i pixelsA, __m128i pixelsB, __m128 w) {
+    const __m128 inv255 = _mm_set1_ps(1.0f / 255.0f);
+    __m128 a = _mm_mul_ps(_mm_cvtepi32_ps(pixelsA), inv255);
+    __m128 b = _mm_mul_ps(_mm_cvtepi32_ps(pixelsB), inv255);
+    __m128 value = _mm_add_ps(_mm_mul_ps(a, _mm_sub_ps(_mm_set1_ps(1.0f), w)), _mm_mul_ps(b, w));
+    return _mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
+}
+
+__attribute__((target("sse2")))
+static void blendSse2(const unsigned char *first, const unsigned char *second, const float *weights,
+                      unsigned char *dst, size_t pixels) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t blocks = pixels / 4;
+    for (size_t i = 0; i < blocks; ++i) {
+        __m128i a = _mm_loadu_si128((const __m128i *) (first + i * 16));
+        __m128i b = _mm_loadu_si128((const __m128i *) (second + i * 16));
+        __m128 w = _mm_loadu_ps(weights + i * 4);
+        __m128i a16[2] = {_mm_unpacklo_epi8(a, zero), _mm_unpackhi_epi8(a, zero)};
+        __m128i b16[2] = {_mm_unpacklo_epi8(b, zero), _mm_unpackhi_epi8(b, zero)};
+        __m128i out[4];
+        out[0] = _mm_cvttps_epi32(blendPixelSse2(_mm_unpacklo_epi16(a16[0], zero), _mm_unpacklo_epi16(b16[0], zero),
+                                                 _mm_shuffle_ps(w, w, 0x00)));
+        out[1] = _mm_cvttps_epi32(blendPixelSse2(_mm_unpackhi_epi16(a16[0], zero), _mm_unpackhi_epi16(b16[0], zero),
+                                                 _mm_shuffle_ps(w, w, 0x55)));
+        out[2] = _mm_cvttps_epi32(blendPixelSse2(_mm_unpacklo_epi16(a16[1], zero), _mm_unpacklo_epi16(b16[1], zero),
+                                                 _mm_shuffle_ps(w, w, 0xAA)));
+        out[3] = _mm_cvttps_epi32(blendPixelSse2(_mm_unpackhi_epi16(a16[1], zero), _mm_unpackhi_epi16(b16[1], zero),
+                                                 _mm_shuffle_ps(w, w, 0xFF)));
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(out[0], out[1]), _mm_packs_epi32(out[2], out[3]));
+        _mm_storeu_si128((__m128i *) (dst + i * 16), packed);
+    }
+    blendScalar(first + blocks * 16, second + blocks * 16, weights + blocks * 4, dst + blocks * 16,
+                pixels - blocks * 4);
+}
+
+/* AVX2: 每次8个像素; unpack按128位通道进行, 第k个向量是像素k和k + 4, 权重相应地用permute广播 */
+
+__attribute__((target("avx2")))
+static inline __m256i blendPixelAvx2(__m256i pixelsA, __m256i pixelsB, __m256 w) {
+    const __m256 inv255 = _mm256_set1_ps(1.0f / 255.0f);
+    __m256 a = _mm256_mul_ps(_mm256_cvtepi32_ps(pixelsA), inv255);
+    __m256 b = _mm256_mul_ps(_mm256_cvtepi32_ps(pixelsB), inv255);
+    __m256 value = _mm256_add_ps(_mm256_mul_ps(a, _mm256_sub_ps(_mm256_set1_ps(1.0f), w)), _mm256_mul_ps(b, w));
+    return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+}
+
+__attribute__((target("avx2")))
+static void blendAvx2(const unsigned char *first, const unsigned char *second, const float *weights,
+                      unsigned char *dst, size_t pixels) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i broadcast[4] = {_mm256_setr_epi32(0, 0, 0, 0, 4, 4, 4, 4), _mm256_setr_epi32(1, 1, 1, 1, 5, 5, 5, 5),
+                                  _mm256_setr_epi32(2, 2, 2, 2, 6, 6, 6, 6), _mm256_setr_epi32(3, 3, 3, 3, 7, 7, 7, 7)};
+    size_t blocks = pixels / 8;
+    for (size_t i = 0; i < blocks; ++i) {
+        __m256i a = _mm256_loadu_si256((const __m256i *) (first + i * 32));
+        __m256i b = _mm256_loadu_si256((const __m256i *) (second + i * 32));
+        __m256 w = _mm256_loadu_ps(weights + i * 8);
+        __m256i a16[2] = {_mm256_unpacklo_epi8(a, zero), _mm256_unpackhi_epi8(a, zero)};
+        __m256i b16[2] = {_mm256_unpacklo_epi8(b, zero), _mm256_unpackhi_epi8(b, zero)};
+        __m256i out[4];
+        for (int k = 0; k < 4; ++k) {
+            __m256i pixelsA = k % 2 ? _mm256_unpackhi_epi16(a16[k / 2], zero) : _mm256_unpacklo_epi16(a16[k / 2], zero);
+            __m256i pixelsB = k % 2 ? _mm256_unpackhi_epi16(b16[k / 2], zero) : _mm256_unpacklo_epi16(b16[k / 2], zero);
+            out[k] = blendPixelAvx2(pixelsA, pixelsB, _mm256_permutevar8x32_ps(w, broadcast[k]));
+        }
+        // pack同样按通道进行, 像素顺序恢复为0~3和4~7
+        __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(out[0], out[1]), _mm256_packs_epi32(out[2], out[3]));
+        _mm256_storeu_si256((__m256i *) (dst + i * 32), packed);
+    }
+    blendScalar(first + blocks * 32, second + blocks * 32, weights + blocks * 8, dst + blocks * 32,
+                pixels - blocks * 8);
+}
+
+#endif
+
+// [指令集], NULL表示该指令集没有专门实现
+static const GLESCompositor::BlendKernel kernelTable[GLESPixelConvert::ISA_COUNT] = {
+#ifdef GLES_COMPOSITOR_X86
+        blendScalar, blendSse2, NULL, blendAvx2
+#else
+        blendScalar, NULL, NULL, NULL
+#endif
+};
+
+// 最近邻采样: 输出第i个像素中心(i + 0.5) / count处的源像素, 与光栅化插值出的纹理坐标一致
+static void buildSampleTable(std::vector<size_t> &table, int count, int sourceCount, size_t stride) {
+    table.resize((size_t) count);
+    for (int i = 0; i < count; ++i) {
+        auto source = (int) (((float) i + 0.5f) / (float) count * (float) sourceCount);
+        table[i] = (size_t) std::min(std::max(source, 0), sourceCount - 1) * stride;
+    }
+}
+
+GLESCompositor::GLESCompositor(GLESThreadPool *pool) : _pool(pool) {
+}
+
+bool GLESCompositor::getEffectForShader(const std::string &fshPath, Effect &effect) {
+    size_t slash = fshPath.rfind('/');
+    std::string name = slash == std::string::npos ? fshPath : fshPath.substr(slash + 1);
+    if (name == "fsh.frag") {
+        effect = EFFECT_MIX;
+    } else if (name == "wipe.frag") {
+        effect = EFFECT_WIPE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *GLESCompositor::getEffectName(Effect effect) {
+    return effect == EFFECT_WIPE ? "wipe" : "mix";
+}
+
+bool GLESCompositor::parseEasing(const std::string &name, int &easing) {
+    if (name == "linear") {
+        easing = EASING_LINEAR;
+    } else if (name == "pow5") {
+        easing = EASING_POW5;
+    } else if (name == "smoothstep") {
+        easing = EASING_SMOOTHSTEP;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+float GLESCompositor::ease(int easing, float t) {
+    switch (easing) {
+        case EASING_LINEAR:
+            return t;
+        case EASING_SMOOTHSTEP:
+            return t * t * (3.0f - 2.0f * t);
+        default:
+            return powf(t, 5.0f);
+    }
+}
+
+GLESCompositor::BlendKernel GLESCompositor::getKernel(GLESPixelConvert::Isa isa, GLESPixelConvert::Isa *actualIsa) {
+    int level = std::min((int) isa, (int) GLESPixelConvert::detectIsa());
+    for (; level > GLESPixelConvert::ISA_SCALAR; --level) {
+        if (kernelTable[level]) {
+            break;
+        }
+    }
+    if (actualIsa) { *actualIsa = (GLESPixelConvert::Isa) level; }
+    return kernelTable[level];
+}
+
+void GLESCompositor::setThreadPool(GLESThreadPool *pool) {
+    _pool = pool;
+}
+
+void GLESCompositor::setIsa(GLESPixelConvert::Isa isa) {
+    _isa = isa;
+}
+
+void GLESCompositor::setTileSize(int width, int height) {
+    _tileWidth = std::max(1, width);
+    _tileHeight = std::max(1, height);
+}
+
+/**
+ * @MethodName: composite
+ * @Return: 参数是否有效
+ * @Description: 先建好采样表和每列的权重, 再把画面切成图块并行合成.
+ *               MIX为mix(first, second, easedTransition);
+ *               WIPE为mix(second, first, smoothstep(edge - 0.1, edge + 0.1, u)), edge = transition * 1.2 - 0.1
+ */
+bool GLESCompositor::composite(Effect effect, const GLESImage &first, const GLESImage &second, float transition,
+                               float easedTransition, unsigned char *dst, int width, int height) {
+    GLES_TRACE_SCOPE("composite");
+    if (!dst || width <= 0 || height <= 0 || first.pixels.empty() || second.pixels.empty() ||
+        first.width <= 0 || first.height <= 0 || second.width <= 0 || second.height <= 0) {
+        return false;
+    }
+    _kernel = getKernel(_isa);
+    buildSampleTable(_firstColumns, width, first.width, (size_t) first.bytesPerPixel());
+    buildSampleTable(_secondColumns, width, second.width, (size_t) second.bytesPerPixel());
+    buildSampleTable(_firstRows, height, first.height, (size_t) first.width * first.bytesPerPixel());
+    buildSampleTable(_secondRows, height, second.height, (size_t) second.width * second.bytesPerPixel());
+
+    _weights.resize((size_t) width);
+    if (effect == EFFECT_WIPE) {
+        float edge = transition * 1.2f - 0.1f;
+        float low = edge - 0.1f, high = edge + 0.1f;
+        for (int x = 0; x < width; ++x) {
+            float u = ((float) x + 0.5f) / (float) width;
+            float t = std::min(std::max((u - low) / (high - low), 0.0f), 1.0f);
+            _weights[x] = t * t * (3.0f - 2.0f * t);
+        }
+    } else {
+        std::fill(_weights.begin(), _weights.end(), easedTransition);
+    }
+
+    int tilesX = (width + _tileWidth - 1) / _tileWidth;
+    int tilesY = (height + _tileHeight - 1) / _tileHeight;
+    bool swap = effect == EFFECT_WIPE;
+    auto compositeTiles = [&](int begin, int end) {
+        for (int tile = begin; tile < end; ++tile) {
+            int x0 = tile % tilesX * _tileWidth;
+            int y0 = tile / tilesX * _tileHeight;
+            compositeTile(first, second, swap, dst, width, x0, y0, std::min(x0 + _tileWidth, width),
+                          std::min(y0 + _tileHeight, height));
+        }
+    };
+    int tileCount = tilesX * tilesY;
+    if (!_pool || tileCount < 2) {
+        compositeTiles(0, tileCount);
+        return true;
+    }
+    int tilesPerChunk = std::max(1, tileCount / (int) (_pool->getThreadCount() * 4));
+    _pool->parallelFor(0, tileCount, tilesPerChunk, compositeTiles);
+    return true;
+}
+
+/**
+ * @MethodName: compositeTile
+ * @Description: 逐行按采样表把两张图的像素收集成RGBA, 再交给混合核; swap时交换混合的两端
+ */
+void GLESCompositor::compositeTile(const GLESImage &first, const GLESImage &second, bool swap, unsigned char *dst,
+                                   int width, int x0, int y0, int x1, int y1) const {
+    alignas(32) unsigned char gathered[2][GATHER_PIXELS * 4];
+    const GLESImage *images[2] = {&first, &second};
+    const std::vector<size_t> *columns[2] = {&_firstColumns, &_secondColumns};
+    const std::vector<size_t> *rows[2] = {&_firstRows, &_secondRows};
+
+    for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < x1; x += GATHER_PIXELS) {
+            int count = std::min(GATHER_PIXELS, x1 - x);
+            for (int k = 0; k < 2; ++k) {
+                const unsigned char *row = images[k]->pixels.data() + (*rows[k])[y];
+                const size_t *column = columns[k]->data() + x;
+                unsigned char *out = gathered[k];
+                if (images[k]->format == GL_RGBA) {
+                    for (int i = 0; i < count; ++i, out += 4) {
+                        memcpy(out, row + column[i], 4);
+                    }
+                } else {
+                    for (int i = 0; i < count; ++i, out += 4) {
+                        const unsigned char *pixel = row + column[i];
+                        out[0] = pixel[0];
+                        out[1] = pixel[1];
+                        out[2] = pixel[2];
+                        out[3] = 255;
+                    }
+                }
+            }
+            _kernel(gathered[swap ? 1 : 0], gathered[swap ? 0 : 1], _weights.data() + x,
+                    dst + ((size_t) y * width + x) * 4, (size_t) count);
+        }
+    }
+}
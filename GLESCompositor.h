@@ -0,0 +1,90 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESCOMPOSITOR_H
+#define GLES_DEMO_GLESCOMPOSITOR_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "GLESPixelConvert.h"
+#include "GLESTextureLoader.h"
+
+class GLESThreadPool;
+
+/**
+ * CPU参考合成: 按着色器的算法在CPU上生成过渡画面, 用于没有可用GL驱动时离线渲染, 以及校验GL读回的结果.
+ * 与着色器一致: 全屏四边形、最近邻采样、先归一化再按mix(x, y, a) = x * (1 - a) + y * a混合.
+ * 混合核有标量参考实现和SSE2/AVX2版本, 结果与标量版本逐位一致; 画面按图块分给线程池.
+ * 输出与glReadPixels相同: 自下而上的RGBA行. 同一个实例不能同时在多个线程调用composite.
+ */
+class GLESCompositor {
+public:
+    // 对应的片元着色器: MIX为shader/test/fsh.frag, WIPE为shader/test/wipe.frag
+    enum Effect {
+        EFFECT_MIX = 0,
+        EFFECT_WIPE,
+        EFFECT_COUNT
+    };
+
+    // 缓动曲线, 取值与shader/common/easing.glsl中的EASING_*一致
+    enum Easing {
+        EASING_LINEAR = 0,
+        EASING_POW5,
+        EASING_SMOOTHSTEP
+    };
+
+    // first和second为RGBA, 逐像素按weights[i]混合
+    typedef void (*BlendKernel)(const unsigned char *first, const unsigned char *second, const float *weights,
+                                unsigned char *dst, size_t pixels);
+
+    explicit GLESCompositor(GLESThreadPool *pool = NULL);
+
+    // 按片元着色器的文件名找对应的效果, 没有CPU实现时返回false
+    static bool getEffectForShader(const std::string &fshPath, Effect &effect);
+
+    static const char *getEffectName(Effect effect);
+
+    static bool parseEasing(const std::string &name, int &easing);
+
+    // 与easing.glsl中的ease()相同, 用于在CPU上计算只依赖uniform的缓动
+    static float ease(int easing, float t);
+
+    // 返回不超过isa的最优实现, 以及实际使用的指令集
+    static BlendKernel getKernel(GLESPixelConvert::Isa isa, GLESPixelConvert::Isa *actualIsa = NULL);
+
+    // NULL表示在调用线程里完成
+    void setThreadPool(GLESThreadPool *pool);
+
+    void setIsa(GLESPixelConvert::Isa isa);
+
+    void setTileSize(int width, int height);
+
+    /**
+     * transition和easedTransition与着色器中的同名uniform相同, dst至少width * height * 4字节;
+     * 图片为RGB或RGBA, 尺寸与输出不同时按最近邻缩放
+     */
+    bool composite(Effect effect, const GLESImage &first, const GLESImage &second, float transition,
+                   float easedTransition, unsigned char *dst, int width, int height);
+
+private:
+    void compositeTile(const GLESImage &first, const GLESImage &second, bool swap, unsigned char *dst, int width,
+                       int x0, int y0, int x1, int y1) const;
+
+    GLESThreadPool *_pool;
+    GLESPixelConvert::Isa _isa = GLESPixelConvert::ISA_AVX2;
+    BlendKernel _kernel = NULL;
+    int _tileWidth = 256;
+    int _tileHeight = 64;
+    // 输出的每一列/行对应的源像素字节偏移, 尺寸不变时复用
+    std::vector<size_t> _firstColumns;
+    std::vector<size_t> _secondColumns;
+    std::vector<size_t> _firstRows;
+    std::vector<size_t> _secondRows;
+    // 每一列的混合权重
+    std::vector<float> _weights;
+};
+
+
+#endif //GLES_DEMO_GLESCOMPOSITOR_H
@@ -0,0 +1,221 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESDynamicResolution.h"
+#include "GLESStateCache.h"
+
+#define DYNAMICGLES_NO_NAMESPACE
+#define DYNAMICEGL_NO_NAMESPACE
+
+#include <DynamicGles.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 帧间隔的指数平滑系数
+static const double SMOOTHING = 0.1;
+// 比例按1/32量化, 单次最多调整的幅度
+static const float SCALE_QUANTUM = 1.0f / 32.0f;
+static const float MAX_SCALE_STEP = 0.25f;
+// 调整后跳过的帧数, 让新分辨率下的帧间隔稳定下来
+static const int COOLDOWN_FRAMES = 4;
+
+// 放大用的着色器只有一种写法, 与帧缓冲对象一起放在这里; 用gl_VertexID生成覆盖全屏的三角形, 不需要顶点数据
+static const char *UPSCALE_VSH =
+        "#version 300 es\n"
+        "uniform vec2 scale;\n"
+        "out vec2 v_texCoord;\n"
+        "void main() {\n"
+        "    vec2 position = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0;\n"
+        "    v_texCoord = position * scale;\n"
+        "    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);\n"
+        "}\n";
+static const char *UPSCALE_FSH =
+        "#version 300 es\n"
+        "precision mediump float;\n"
+        "uniform sampler2D s_scene;\n"
+        "uniform vec2 maxTexCoord;\n"
+        "in vec2 v_texCoord;\n"
+        "out vec4 fragColor;\n"
+        "void main() {\n"
+        "    fragColor = texture(s_scene, min(v_texCoord, maxTexCoord));\n"
+        "}\n";
+
+GLESDynamicResolution::GLESDynamicResolution(GLESStateCache &stateCache, GLESRenderTargetPool &pool)
+        : _stateCache(stateCache), _pool(pool) {
+}
+
+void GLESDynamicResolution::setTarget(double frameMs, float minScale, float maxScale, double hysteresis) {
+    _targetMs = frameMs;
+    _maxScale = std::min(std::max(maxScale, SCALE_QUANTUM), 1.0f);
+    _minScale = std::min(std::max(minScale, SCALE_QUANTUM), _maxScale);
+    _hysteresis = std::max(hysteresis, 0.0);
+}
+
+/**
+ * @MethodName: init
+ * @Return: FBO和放大程序是否创建成功
+ * @Description: 颜色纹理按窗口大小分配, 从最高比例开始
+ */
+bool GLESDynamicResolution::init(int width, int height) {
+    release();
+    _width = width;
+    _height = height;
+
+    GLuint vertexShader = GLESProgram::compileShader(GL_VERTEX_SHADER, UPSCALE_VSH);
+    GLuint fragmentShader = GLESProgram::compileShader(GL_FRAGMENT_SHADER, UPSCALE_FSH);
+    bool linked = vertexShader && fragmentShader &&
+                  _program.link(vertexShader, fragmentShader, std::vector<std::pair<GLuint, std::string> >());
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    if (!linked) {
+        release();
+        return false;
+    }
+    _samplerUniform = _program.findUniform("s_scene");
+    _scaleUniform = _program.findUniform("scale");
+    _maxTexCoordUniform = _program.findUniform("maxTexCoord");
+
+    glGenTextures(1, &_colorTexture);
+    _stateCache.bindTextureUnit(TEXTURE_UNIT, GL_TEXTURE_2D, _colorTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glGenFramebuffers(1, &_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _colorTexture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        printf("Dynamic resolution framebuffer incomplete: 0x%x\n", status);
+        release();
+        return false;
+    }
+
+    _smoothedMs = -1.0;
+    _cooldown = 0;
+    setScale(_maxScale);
+    return true;
+}
+
+bool GLESDynamicResolution::isEnabled() const {
+    return _framebuffer != 0;
+}
+
+/**
+ * @MethodName: update
+ * @Return: 比例是否变化
+ * @Description: 平滑后的帧间隔超出[目标 * (1 - 容差), 目标 * (1 + 容差)]时才调整
+ */
+bool GLESDynamicResolution::update(double frameMs) {
+    if (!isEnabled() || frameMs < 0.0) {
+        return false;
+    }
+    _smoothedMs = _smoothedMs < 0.0 ? frameMs : _smoothedMs + SMOOTHING * (frameMs - _smoothedMs);
+    if (_cooldown > 0) {
+        --_cooldown;
+        return false;
+    }
+    bool overBudget = _smoothedMs > _targetMs * (1.0 + _hysteresis) && _scale > _minScale;
+    bool underBudget = _smoothedMs < _targetMs * (1.0 - _hysteresis) && _scale < _maxScale;
+    if (!overBudget && !underBudget) {
+        return false;
+    }
+
+    // 耗时与像素数成正比, 像素数与比例的平方成正比
+    auto desired = (float) (_scale * std::sqrt(_targetMs / std::max(_smoothedMs, 0.001)));
+    desired = std::min(std::max(desired, _scale - MAX_SCALE_STEP), _scale + MAX_SCALE_STEP);
+    // 超出预算时向下取整, 有余量时向上取整, 保证至少变化一档
+    desired = overBudget ? std::floor(desired / SCALE_QUANTUM) * SCALE_QUANTUM
+                         : std::ceil(desired / SCALE_QUANTUM) * SCALE_QUANTUM;
+    desired = std::min(std::max(desired, _minScale), _maxScale);
+    if (desired == _scale) {
+        return false;
+    }
+    setScale(desired);
+    // 旧分辨率下的样本不再有参考价值
+    _smoothedMs = -1.0;
+    _cooldown = COOLDOWN_FRAMES;
+    return true;
+}
+
+bool GLESDynamicResolution::restoreMaxScale() {
+    if (!isEnabled() || _scale == _maxScale) {
+        return false;
+    }
+    setScale(_maxScale);
+    _smoothedMs = -1.0;
+    _cooldown = COOLDOWN_FRAMES;
+    return true;
+}
+
+void GLESDynamicResolution::setScale(float scale) {
+    _scale = scale;
+    _renderWidth = std::max(1, (int) ((float) _width * scale + 0.5f));
+    _renderHeight = std::max(1, (int) ((float) _height * scale + 0.5f));
+}
+
+float GLESDynamicResolution::getScale() const {
+    return _scale;
+}
+
+int GLESDynamicResolution::getRenderWidth() const {
+    return _renderWidth;
+}
+
+int GLESDynamicResolution::getRenderHeight() const {
+    return _renderHeight;
+}
+
+void GLESDynamicResolution::bind(GLuint output) {
+    bool scaled = _scale < 1.0f;
+    glBindFramebuffer(GL_FRAMEBUFFER, scaled ? _framebuffer : output);
+    _stateCache.viewport(0, 0, scaled ? _renderWidth : _width, scaled ? _renderHeight : _height);
+}
+
+/**
+ * @MethodName: resolve
+ * @Description: 线性采样FBO中缩小的区域, 画满整个输出帧缓冲; 放大后FBO的内容不再需要, 告诉驱动不必写回
+ */
+void GLESDynamicResolution::resolve(GLuint output) {
+    if (_scale >= 1.0f) {
+        return;
+    }
+    const GLenum attachment = GL_COLOR_ATTACHMENT0;
+    glBindFramebuffer(GL_FRAMEBUFFER, output);
+    _stateCache.viewport(0, 0, _width, _height);
+
+    GLuint sceneProgram = _stateCache.getProgram();
+    _program.use();
+    _stateCache.bindTextureUnit(TEXTURE_UNIT, GL_TEXTURE_2D, _colorTexture);
+    _program.setUniform1i(_samplerUniform, (GLint) TEXTURE_UNIT);
+    // 采样范围是纹理中实际画到的部分
+    _program.setUniform2f(_scaleUniform, (GLfloat) _renderWidth / (GLfloat) _width,
+                          (GLfloat) _renderHeight / (GLfloat) _height);
+    // 最后一行和一列的采样点落在最后一个纹素中心之外, 线性过滤会混入本帧没有画到的纹素, 限制在中心以内
+    _program.setUniform2f(_maxTexCoordUniform, ((GLfloat) _renderWidth - 0.5f) / (GLfloat) _width,
+                          ((GLfloat) _renderHeight - 0.5f) / (GLfloat) _height);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    _stateCache.useProgram(sceneProgram);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+    _pool.invalidate(1, &attachment);
+    glBindFramebuffer(GL_FRAMEBUFFER, output);
+}
+
+void GLESDynamicResolution::release() {
+    _program.release();
+    _samplerUniform = _scaleUniform = _maxTexCoordUniform = -1;
+    if (_framebuffer) {
+        glDeleteFramebuffers(1, &_framebuffer);
+        _framebuffer = 0;
+    }
+    _stateCache.deleteTextures(1, &_colorTexture);
+    _colorTexture = 0;
+}
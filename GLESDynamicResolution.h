@@ -0,0 +1,84 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESDYNAMICRESOLUTION_H
+#define GLES_DEMO_GLESDYNAMICRESOLUTION_H
+
+#include <GLES3/gl32.h>
+#include "GLESProgram.h"
+#include "GLESRenderTargetPool.h"
+
+/**
+ * 动态分辨率: 场景先画到离屏FBO中按比例缩小的区域, 再用一个全屏三角形线性采样放大到surface.
+ * FBO按窗口大小一次分配, 调整比例只改视口和放大的源区域, 不重新分配显存; 比例为1时直接画到surface, 没有额外开销.
+ * 放大不用glBlitFramebuffer: 软件光栅化下它比一次采样绘制慢数倍.
+ * 比例按测得的帧间隔调整: 帧间隔平滑后超出目标的上下容差带才调整, 像素数与比例的平方成正比,
+ * 新比例按sqrt(目标 / 实测)估计并量化, 调整后等几帧再重新测量, 避免来回抖动. 需要GLES3.
+ */
+class GLESDynamicResolution {
+public:
+    // 放大后丢弃FBO内容时经渲染目标池, 由池统一计数
+    GLESDynamicResolution(GLESStateCache &stateCache, GLESRenderTargetPool &pool);
+
+    // 目标帧耗时(毫秒), 比例范围, 以及容差(相对目标的比例)
+    void setTarget(double frameMs, float minScale, float maxScale, double hysteresis);
+
+    bool init(int width, int height);
+
+    bool isEnabled() const;
+
+    /**
+     * 输入上一帧的帧间隔, 小于0(上一帧没有交换)时忽略
+     * 返回比例是否变化
+     */
+    bool update(double frameMs);
+
+    // 画面静止时有余量, 恢复到最高比例; 返回比例是否变化
+    bool restoreMaxScale();
+
+    float getScale() const;
+
+    int getRenderWidth() const;
+
+    int getRenderHeight() const;
+
+    // 比例小于1时绑定FBO并把视口设为缩小后的区域, 否则直接画到输出帧缓冲(0为默认帧缓冲)
+    void bind(GLuint output = 0);
+
+    // 放大到输出帧缓冲; 之后恢复原来的程序, 下一帧场景不会因为程序切换被当成有变化
+    void resolve(GLuint output = 0);
+
+    void release();
+
+private:
+    void setScale(float scale);
+
+    // 放大时占用的纹理单元, 避开场景使用的单元
+    static const GLuint TEXTURE_UNIT = 15;
+
+    GLESStateCache &_stateCache;
+    GLESRenderTargetPool &_pool;
+    GLESProgram _program{_stateCache};
+    int _samplerUniform = -1;
+    int _scaleUniform = -1;
+    int _maxTexCoordUniform = -1;
+    GLuint _framebuffer = 0;
+    GLuint _colorTexture = 0;
+    int _width = 0;
+    int _height = 0;
+    int _renderWidth = 0;
+    int _renderHeight = 0;
+
+    float _scale = 1.0f;
+    float _minScale = 0.5f;
+    float _maxScale = 1.0f;
+    double _targetMs = 16.7;
+    double _hysteresis = 0.1;
+    // 平滑后的帧间隔, 小于0表示还没有样本
+    double _smoothedMs = -1.0;
+    int _cooldown = 0;
+};
+
+
+#endif //GLES_DEMO_GLESDYNAMICRESOLUTION_H
@@ -0,0 +1,173 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESErrorMonitor.h"
+
+#define DYNAMICGLES_NO_NAMESPACE
+#define DYNAMICEGL_NO_NAMESPACE
+
+#include <DynamicGles.h>
+#include <algorithm>
+#include <cstring>
+
+bool GLESErrorMonitor::parseMode(const std::string &name, Mode &mode) {
+    if (name.empty()) {
+        // 调试构建每个检查点都同步检查, 发布构建不在帧内等待驱动
+#ifdef NDEBUG
+        mode = MODE_CALLBACK;
+#else
+        mode = MODE_STRICT;
+#endif
+    } else if (name == "strict") {
+        mode = MODE_STRICT;
+    } else if (name == "deferred") {
+        mode = MODE_DEFERRED;
+    } else if (name == "callback") {
+        mode = MODE_CALLBACK;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *GLESErrorMonitor::getModeName(Mode mode) {
+    switch (mode) {
+        case MODE_DEFERRED:
+            return "deferred";
+        case MODE_CALLBACK:
+            return "callback";
+        default:
+            return "strict";
+    }
+}
+
+/**
+ * @MethodName: init
+ * @Return: 实际使用的模式
+ * @Description: 回调模式只接收错误和未定义行为两类消息, 不开启同步输出, 驱动可以在自己的线程上回调
+ */
+GLESErrorMonitor::Mode GLESErrorMonitor::init(Mode mode, int interval, bool khrDebug) {
+    release();
+    _mode = mode;
+    _interval = std::max(interval, 1);
+    _frameIndex.store(0);
+    _lastSite.store("init");
+
+    if (_mode == MODE_CALLBACK) {
+        _debugMessageCallback = khrDebug ? (PFNGLDEBUGMESSAGECALLBACKKHRPROC) eglGetProcAddress(
+                "glDebugMessageCallbackKHR") : NULL;
+        auto debugMessageControl = khrDebug ? (PFNGLDEBUGMESSAGECONTROLKHRPROC) eglGetProcAddress(
+                "glDebugMessageControlKHR") : NULL;
+        if (!_debugMessageCallback || !debugMessageControl) {
+            _debugMessageCallback = NULL;
+            _mode = MODE_DEFERRED;
+        } else {
+            // 之前积累的错误不属于任何检查点, 先清掉
+            pollErrors();
+            debugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_FALSE);
+            debugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_ERROR_KHR, GL_DONT_CARE, 0, NULL, GL_TRUE);
+            debugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR_KHR, GL_DONT_CARE, 0, NULL, GL_TRUE);
+            _debugMessageCallback(&GLESErrorMonitor::debugCallback, this);
+            glEnable(GL_DEBUG_OUTPUT_KHR);
+            glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS_KHR);
+        }
+    }
+    return _mode;
+}
+
+bool GLESErrorMonitor::check(const char *site) {
+    if (_mode != MODE_STRICT) {
+        _lastSite.store(site, std::memory_order_relaxed);
+        return true;
+    }
+    GLenum lastError = glGetError();
+    if (lastError == GL_NO_ERROR) {
+        return true;
+    }
+    record(lastError, site, NULL);
+    return false;
+}
+
+void GLESErrorMonitor::endFrame() {
+    uint64_t frameIndex = _frameIndex.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (_mode == MODE_DEFERRED && frameIndex % (uint64_t) _interval == 0) {
+        pollErrors();
+    }
+}
+
+// glGetError每次只返回一个错误标志, 取到没有错误为止
+void GLESErrorMonitor::pollErrors() {
+    const char *site = _lastSite.load(std::memory_order_relaxed);
+    for (GLenum lastError = glGetError(); lastError != GL_NO_ERROR; lastError = glGetError()) {
+        record(lastError, site, NULL);
+    }
+}
+
+// 已经用debugMessageControl筛选过类型和级别, 消息以'\0'结尾, 不需要长度
+void GL_APIENTRY GLESErrorMonitor::debugCallback(GLenum, GLenum, GLuint id, GLenum, GLsizei, const GLchar *message,
+                                                  const void *userParam) {
+    auto monitor = (GLESErrorMonitor *) userParam;
+    monitor->record(id, monitor->_lastSite.load(std::memory_order_relaxed), message);
+}
+
+void GLESErrorMonitor::record(GLenum code, const char *site, const char *message) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _total++;
+    for (int i = 0; i < _entryCount; ++i) {
+        Entry &entry = _entries[i];
+        if (entry.code == code && entry.site == site) {
+            entry.count++;
+            return;
+        }
+    }
+    // 第一次出现时打印, 表满后只计总数; 非strict模式下只知道出错前最近经过的检查点
+    printf("GL error 0x%x %s %s (%s)%s%s\n", code, _mode == MODE_STRICT ? "at" : "near", site, getModeName(_mode),
+           message ? ": " : "", message ? message : "");
+    if (_entryCount == MAX_ENTRIES) {
+        return;
+    }
+    Entry &entry = _entries[_entryCount++];
+    entry.code = code;
+    entry.site = site;
+    entry.count = 1;
+    entry.firstFrame = _frameIndex.load(std::memory_order_relaxed);
+    entry.message[0] = '\0';
+    if (message) {
+        strncat(entry.message, message, sizeof(entry.message) - 1);
+    }
+}
+
+uint64_t GLESErrorMonitor::getErrorCount() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _total;
+}
+
+GLESErrorMonitor::Mode GLESErrorMonitor::getMode() const {
+    return _mode;
+}
+
+void GLESErrorMonitor::printSummary(FILE *file) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_total == 0) {
+        return;
+    }
+    fprintf(file, "GL errors: %llu (%s)\n", (unsigned long long) _total, getModeName(_mode));
+    for (int i = 0; i < _entryCount; ++i) {
+        const Entry &entry = _entries[i];
+        fprintf(file, "  0x%x %s %s: %llu times, first in frame %llu%s%s\n", entry.code,
+                _mode == MODE_STRICT ? "at" : "near", entry.site, (unsigned long long) entry.count, (unsigned long long) entry.firstFrame,
+                entry.message[0] ? ", " : "", entry.message);
+    }
+}
+
+void GLESErrorMonitor::release() {
+    if (_mode == MODE_DEFERRED) {
+        pollErrors();
+    }
+    if (_debugMessageCallback) {
+        glDisable(GL_DEBUG_OUTPUT_KHR);
+        _debugMessageCallback(NULL, NULL);
+        _debugMessageCallback = NULL;
+    }
+}
@@ -0,0 +1,95 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESERRORMONITOR_H
+#define GLES_DEMO_GLESERRORMONITOR_H
+
+#include <GLES3/gl32.h>
+#include <GLES2/gl2ext.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+/**
+ * GL错误检查策略. glGetError在很多驱动上会等待命令队列执行完, 帧内每次检查都是一个同步点:
+ * strict: 每个检查点都调用glGetError, 出错时中止本帧, 调试构建的默认值
+ * deferred: 检查点只记下位置, 每隔N帧调用一次glGetError, 错误记在最近经过的检查点上
+ * callback: 用GL_KHR_debug的异步回调接收错误, 帧内不调用glGetError; 不支持时退回deferred, 发布构建的默认值
+ * 后两种模式出错不中止帧, 按(错误码, 检查点)汇总次数, 第一次出现时打印, 退出时输出汇总.
+ * 回调可能在驱动线程上调用, 汇总表固定大小并加锁, 不做堆分配.
+ */
+class GLESErrorMonitor {
+public:
+    enum Mode {
+        MODE_STRICT,
+        MODE_DEFERRED,
+        MODE_CALLBACK
+    };
+
+    // 空字符串取构建的默认值
+    static bool parseMode(const std::string &name, Mode &mode);
+
+    static const char *getModeName(Mode mode);
+
+    /**
+     * 需要当前线程有GL上下文; interval为deferred模式下两次glGetError之间的帧数
+     * khrDebug为驱动是否支持GL_KHR_debug, 返回实际使用的模式
+     */
+    Mode init(Mode mode, int interval, bool khrDebug);
+
+    /**
+     * 帧内检查点, site必须是字符串常量
+     * strict模式下返回是否没有错误, 其他模式总是返回true
+     */
+    bool check(const char *site);
+
+    // 每帧结束时调用, deferred模式到了间隔就取出所有错误
+    void endFrame();
+
+    uint64_t getErrorCount() const;
+
+    Mode getMode() const;
+
+    // 打印各错误的次数和位置, 没有错误时不输出
+    void printSummary(FILE *file) const;
+
+    // 上下文销毁前调用, 取出剩余的错误并卸下回调
+    void release();
+
+private:
+    // deferred/strict模式下code为glGetError的错误码, 回调模式下为消息id
+    struct Entry {
+        GLenum code;
+        const char *site;
+        uint64_t count;
+        uint64_t firstFrame;
+        char message[128];
+    };
+
+    static void GL_APIENTRY debugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                          const GLchar *message, const void *userParam);
+
+    void record(GLenum code, const char *site, const char *message);
+
+    void pollErrors();
+
+    static const int MAX_ENTRIES = 32;
+
+    Mode _mode = MODE_STRICT;
+    int _interval = 60;
+    std::atomic<uint64_t> _frameIndex{0};
+    PFNGLDEBUGMESSAGECALLBACKKHRPROC _debugMessageCallback = NULL;
+    // 最近经过的检查点, 回调线程读取
+    std::atomic<const char *> _lastSite{"frame"};
+
+    mutable std::mutex _mutex;
+    Entry _entries[MAX_ENTRIES];
+    int _entryCount = 0;
+    uint64_t _total = 0;
+};
+
+
+#endif //GLES_DEMO_GLESERRORMONITOR_H
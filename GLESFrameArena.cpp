@@ -0,0 +1,61 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESFrameArena.h"
+
+#include <cstdint>
+
+GLESFrameArena::GLESFrameArena(size_t capacity) : _buffer(capacity) {
+}
+
+/**
+ * @MethodName: allocate
+ * @Return: 对齐后的内存, 生命周期到下一次reset为止
+ * @Description: 从线性缓冲中分配, 不够时退回堆分配
+ */
+void *GLESFrameArena::allocate(size_t bytes, size_t alignment) {
+    uintptr_t base = reinterpret_cast<uintptr_t>(_buffer.data());
+    uintptr_t aligned = (base + _offset + alignment - 1) & ~(uintptr_t) (alignment - 1);
+    size_t end = aligned - base + bytes;
+    _frameDemand += bytes + alignment;
+
+    if (end <= _buffer.size()) {
+        _offset = end;
+        return reinterpret_cast<void *>(aligned);
+    }
+
+    // 溢出: 本帧先用堆内存应付, reset时再扩容
+    ++_overflowCount;
+    _overflowBlocks.emplace_back(new unsigned char[bytes + alignment]);
+    uintptr_t block = reinterpret_cast<uintptr_t>(_overflowBlocks.back().get());
+    return reinterpret_cast<void *>((block + alignment - 1) & ~(uintptr_t) (alignment - 1));
+}
+
+void GLESFrameArena::reset() {
+    if (_frameDemand > _highWater) {
+        _highWater = _frameDemand;
+    }
+    if (!_overflowBlocks.empty()) {
+        _overflowBlocks.clear();
+        _buffer.resize(_highWater * 2);
+    }
+    _offset = 0;
+    _frameDemand = 0;
+}
+
+size_t GLESFrameArena::getUsed() const {
+    return _offset;
+}
+
+size_t GLESFrameArena::getCapacity() const {
+    return _buffer.size();
+}
+
+size_t GLESFrameArena::getHighWater() const {
+    return _highWater;
+}
+
+size_t GLESFrameArena::getOverflowCount() const {
+    return _overflowCount;
+}
@@ -0,0 +1,48 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESFRAMEARENA_H
+#define GLES_DEMO_GLESFRAMEARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * 帧内临时数据的线性分配器: 分配只是移动偏移, reset时整体回收.
+ * 超出容量时临时向堆申请, 并在下一次reset时按峰值扩容, 稳定后每帧零堆分配.
+ */
+class GLESFrameArena {
+public:
+    explicit GLESFrameArena(size_t capacity = 64 * 1024);
+
+    void *allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    template<typename T>
+    T *allocArray(size_t count) {
+        return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void reset();
+
+    size_t getUsed() const;
+
+    size_t getCapacity() const;
+
+    size_t getHighWater() const;
+
+    size_t getOverflowCount() const;
+
+private:
+    std::vector<unsigned char> _buffer;
+    size_t _offset = 0;
+    // 本帧总需求(含溢出部分), 用于reset时扩容
+    size_t _frameDemand = 0;
+    size_t _highWater = 0;
+    size_t _overflowCount = 0;
+    std::vector<std::unique_ptr<unsigned char[]> > _overflowBlocks;
+};
+
+
+#endif //GLES_DEMO_GLESFRAMEARENA_H
@@ -0,0 +1,481 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESFrameCapture.h"
+#include "GLESTrace.h"
+
+#define DYNAMICGLES_NO_NAMESPACE
+#define DYNAMICEGL_NO_NAMESPACE
+
+#include <DynamicGles.h>
+#include <FreeImage.h>
+#include <algorithm>
+#include <cstring>
+
+GLESFrameCapture::GLESFrameCapture(GLESStateCache &stateCache) : _stateCache(stateCache) {
+}
+
+GLESFrameCapture::~GLESFrameCapture() {
+    // 没有机会调用release时让写线程写完已经取回的帧, PBO随上下文销毁
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_all();
+    if (_writer.joinable()) {
+        _writer.join();
+    }
+    if (_file) {
+        fclose(_file);
+    }
+}
+
+bool GLESFrameCapture::parseFormat(const std::string &name, Format &format) {
+    if (name == "raw") {
+        format = FORMAT_RAW;
+    } else if (name == "png") {
+        format = FORMAT_PNG;
+    } else if (name == "y4m") {
+        format = FORMAT_Y4M;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @MethodName: splitFrameTemplate
+ * @Return: 是否找到序号的位置
+ * @Description: 第一个%d(可带0和宽度, 如%05d)处拆成前缀和后缀, %%以及其他的%都按字面字符保留;
+ *               文件名由写线程手工拼接, 用户给的路径不会被当作printf的格式串
+ */
+static bool splitFrameTemplate(const std::string &path, std::string &prefix, std::string &suffix, int &digits,
+                               bool &zeroPad) {
+    prefix.clear();
+    suffix.clear();
+    bool found = false;
+    for (size_t i = 0; i < path.size(); ++i) {
+        std::string &out = found ? suffix : prefix;
+        if (path[i] != '%') {
+            out += path[i];
+            continue;
+        }
+        if (i + 1 < path.size() && path[i + 1] == '%') {
+            out += '%';
+            ++i;
+            continue;
+        }
+        size_t end = i + 1;
+        bool pad = end < path.size() && path[end] == '0';
+        end += pad ? 1 : 0;
+        int width = 0;
+        while (end < path.size() && path[end] >= '0' && path[end] <= '9' && width < 100) {
+            width = width * 10 + (path[end++] - '0');
+        }
+        if (!found && end < path.size() && path[end] == 'd') {
+            found = true;
+            digits = std::min(width, 20);
+            zeroPad = pad;
+            i = end;
+            continue;
+        }
+        out += '%';
+    }
+    return found;
+}
+
+const char *GLESFrameCapture::getExtension(Format format) {
+    switch (format) {
+        case FORMAT_PNG:
+            return ".png";
+        case FORMAT_Y4M:
+            return ".y4m";
+        default:
+            return ".rgba";
+    }
+}
+
+/**
+ * @MethodName: start
+ * @Return: 是否成功
+ * @Description: 分配ringSize个PBO和queueSize个内存帧, 打开输出文件并启动写线程; ringSize为0时不调用GL
+ */
+bool GLESFrameCapture::start(const std::string &path, Format format, int width, int height, int fps, int ringSize,
+                             int queueSize) {
+    release();
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+    _format = format;
+    _width = width;
+    _height = height;
+    _frameBytes = (size_t) width * height * 4;
+
+    if (format == FORMAT_PNG) {
+        // 没有%d时在扩展名之前加5位序号
+        if (!splitFrameTemplate(path, _pathPrefix, _pathSuffix, _frameDigits, _frameZeroPad)) {
+            _frameDigits = 5;
+            _frameZeroPad = true;
+            size_t extension = _pathPrefix.size() >= 4 ? _pathPrefix.size() - 4 : std::string::npos;
+            if (extension != std::string::npos && _pathPrefix.compare(extension, 4, ".png") == 0) {
+                _pathSuffix = _pathPrefix.substr(extension);
+                _pathPrefix.erase(extension);
+            } else {
+                _pathSuffix = ".png";
+            }
+            _pathPrefix += "_";
+        }
+    } else {
+        _file = fopen(path.c_str(), "wb");
+        if (!_file) {
+            printf("Failed to open capture output: %s\n", path.c_str());
+            return false;
+        }
+        if (format == FORMAT_Y4M) {
+            fprintf(_file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+        }
+    }
+
+    _pixelBuffers = std::vector<PixelBuffer>((size_t) std::max(0, ringSize));
+    for (PixelBuffer &pixelBuffer : _pixelBuffers) {
+        glGenBuffers(1, &pixelBuffer.buffer);
+        _stateCache.bindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr) _frameBytes, NULL, GL_STREAM_READ);
+    }
+    if (!_pixelBuffers.empty()) {
+        _stateCache.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    if (!_pixelBuffers.empty() && glGetError() != GL_NO_ERROR) {
+        printf("Failed to allocate capture buffers\n");
+        release();
+        return false;
+    }
+
+    _frames = std::vector<Frame>((size_t) std::max(1, queueSize));
+    for (Frame &frame : _frames) {
+        frame.pixels.resize(_frameBytes);
+    }
+    _oldest = 0;
+    _inFlight = 0;
+    _queueHead = 0;
+    _frameIndex = 0;
+    _stats = GLESCaptureStats();
+    _stop = false;
+    _writer = std::thread(&GLESFrameCapture::writerLoop, this);
+    return true;
+}
+
+bool GLESFrameCapture::isActive() const {
+    return !_frames.empty();
+}
+
+void GLESFrameCapture::setLossless(bool lossless) {
+    _lossless = lossless;
+}
+
+/**
+ * @MethodName: capture
+ * @Description: 先取回已完成的读回, 再把当前后台缓冲读进下一个空闲PBO; 所有PBO都在途时丢掉这一帧,
+ *               不丢帧模式下改为等待最早的读回
+ */
+void GLESFrameCapture::capture() {
+    GLES_TRACE_SCOPE("capture");
+    if (_pixelBuffers.empty()) {
+        return;
+    }
+    poll();
+    ++_frameIndex;
+
+    auto ringSize = (int) _pixelBuffers.size();
+    if (_inFlight == ringSize && _lossless) {
+        harvestOldest();
+    }
+    if (_inFlight == ringSize) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_stats.droppedGpu;
+        return;
+    }
+    PixelBuffer &pixelBuffer = _pixelBuffers[(_oldest + _inFlight) % ringSize];
+    _stateCache.bindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer.buffer);
+    glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, (void *) 0);
+    _stateCache.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    pixelBuffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pixelBuffer.frameIndex = _frameIndex;
+    ++_inFlight;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_stats.captured;
+}
+
+/**
+ * @MethodName: poll
+ * @Description: 按读回顺序检查栅栏, 遇到第一个未完成的就停止, 不等待
+ */
+void GLESFrameCapture::poll() {
+    while (_inFlight > 0) {
+        PixelBuffer &pixelBuffer = _pixelBuffers[_oldest];
+        GLenum status = glClientWaitSync(pixelBuffer.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+        harvest(pixelBuffer);
+    }
+}
+
+/**
+ * @MethodName: harvest
+ * @Return: 是否交给了写线程
+ * @Description: 映射已完成的PBO拷进空闲内存帧并入队; 内存帧用完时丢掉这一帧(不丢帧模式下等待). 无论如何都归还PBO
+ */
+bool GLESFrameCapture::harvest(PixelBuffer &pixelBuffer) {
+    int slot = acquireFrame();
+    bool queued = false;
+    if (slot >= 0) {
+        _stateCache.bindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer.buffer);
+        void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr) _frameBytes, GL_MAP_READ_BIT);
+        if (mapped) {
+            // 这个内存帧不在队列里, 写线程不会碰它
+            memcpy(_frames[slot].pixels.data(), mapped, _frameBytes);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            queueFrame(slot, pixelBuffer.frameIndex);
+            queued = true;
+        }
+        _stateCache.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    glDeleteSync(pixelBuffer.fence);
+    pixelBuffer.fence = 0;
+    _oldest = (_oldest + 1) % (int) _pixelBuffers.size();
+    --_inFlight;
+    return queued;
+}
+
+int GLESFrameCapture::acquireFrame() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_lossless) {
+        _drainedCondition.wait(lock, [this]() { return _stats.queueDepth < (int) _frames.size(); });
+    }
+    if (_stats.queueDepth < (int) _frames.size()) {
+        return (_queueHead + _stats.queueDepth) % (int) _frames.size();
+    }
+    ++_stats.droppedQueue;
+    return -1;
+}
+
+void GLESFrameCapture::queueFrame(int slot, uint64_t frameIndex) {
+    _frames[slot].frameIndex = frameIndex;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_stats.queueDepth;
+        _stats.maxQueueDepth = std::max(_stats.maxQueueDepth, _stats.queueDepth);
+    }
+    _condition.notify_one();
+}
+
+/**
+ * @MethodName: submit
+ * @Return: 是否交给了写线程
+ * @Description: CPU合成的帧直接拷进空闲内存帧, 与读回的帧走同一个写线程
+ */
+bool GLESFrameCapture::submit(const unsigned char *pixels) {
+    if (_frames.empty() || !_pixelBuffers.empty()) {
+        return false;
+    }
+    ++_frameIndex;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_stats.captured;
+    }
+    int slot = acquireFrame();
+    if (slot < 0) {
+        return false;
+    }
+    memcpy(_frames[slot].pixels.data(), pixels, _frameBytes);
+    queueFrame(slot, _frameIndex);
+    return true;
+}
+
+/**
+ * @MethodName: harvestOldest
+ * @Description: 阻塞等待最早的读回完成, 并等写线程腾出内存帧, 保证这一帧不会被丢掉
+ */
+void GLESFrameCapture::harvestOldest() {
+    PixelBuffer &pixelBuffer = _pixelBuffers[_oldest];
+    glClientWaitSync(pixelBuffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _drainedCondition.wait(lock, [this]() { return _stats.queueDepth < (int) _frames.size(); });
+    }
+    harvest(pixelBuffer);
+}
+
+/**
+ * @MethodName: finish
+ * @Description: 阻塞取回所有在途的读回(等待写线程腾出内存帧, 不丢帧), 再等写线程写完
+ */
+void GLESFrameCapture::finish() {
+    if (_frames.empty()) {
+        return;
+    }
+    while (_inFlight > 0) {
+        harvestOldest();
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    _drainedCondition.wait(lock, [this]() { return _stats.queueDepth == 0; });
+    if (_file) {
+        fflush(_file);
+    }
+}
+
+GLESCaptureStats GLESFrameCapture::getStats() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+/**
+ * @MethodName: writerLoop
+ * @Description: 按顺序写出队首的内存帧, 写完才出队, 这样GL线程不会覆盖正在写的帧; 停止时先把队列写完
+ */
+void GLESFrameCapture::writerLoop() {
+    GLES_TRACE_THREAD_NAME("capture writer");
+    for (;;) {
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]() { return _stop || _stats.queueDepth > 0; });
+            if (_stats.queueDepth == 0) {
+                return;
+            }
+            index = _queueHead;
+        }
+
+        bool written = writeFrame(_frames[index]);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _queueHead = (_queueHead + 1) % (int) _frames.size();
+            --_stats.queueDepth;
+            if (written) {
+                ++_stats.written;
+            } else {
+                ++_stats.writeErrors;
+            }
+        }
+        _drainedCondition.notify_all();
+    }
+}
+
+/**
+ * @MethodName: writeFrame
+ * @Return: 写出是否成功
+ * @Description: 读回的像素自下而上排列; RAW和Y4M翻转成自上而下, PNG借助FreeImage同样自下而上的存储直接逐行转换
+ */
+bool GLESFrameCapture::writeFrame(const Frame &frame) {
+    size_t pitch = (size_t) _width * 4;
+    if (_format == FORMAT_RAW) {
+        for (int y = _height - 1; y >= 0; --y) {
+            if (fwrite(frame.pixels.data() + y * pitch, 1, pitch, _file) != pitch) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (_format == FORMAT_PNG) {
+        FIBITMAP *dib = FreeImage_Allocate(_width, _height, 24);
+        if (!dib) {
+            return false;
+        }
+        for (int y = 0; y < _height; ++y) {
+            const unsigned char *src = frame.pixels.data() + y * pitch;
+            BYTE *dst = FreeImage_GetScanLine(dib, y);
+            for (int x = 0; x < _width; ++x, src += 4, dst += 3) {
+                dst[FI_RGBA_RED] = src[0];
+                dst[FI_RGBA_GREEN] = src[1];
+                dst[FI_RGBA_BLUE] = src[2];
+            }
+        }
+        char fileName[1024];
+        snprintf(fileName, sizeof(fileName), _frameZeroPad ? "%s%0*d%s" : "%s%*d%s", _pathPrefix.c_str(),
+                 _frameDigits, (int) frame.frameIndex, _pathSuffix.c_str());
+        bool saved = FreeImage_Save(FIF_PNG, dib, fileName, 0) != 0;
+        FreeImage_Unload(dib);
+        return saved;
+    }
+
+    // Y4M: 转为有限范围的I420, 色度取2x2平均; 与视频输入一致, 高度不小于720时用BT.709
+    int chromaWidth = (_width + 1) / 2;
+    int chromaHeight = (_height + 1) / 2;
+    _scratch.resize((size_t) _width * _height + (size_t) chromaWidth * chromaHeight * 2);
+    unsigned char *yPlane = _scratch.data();
+    unsigned char *uPlane = yPlane + (size_t) _width * _height;
+    unsigned char *vPlane = uPlane + (size_t) chromaWidth * chromaHeight;
+    float kr = _height >= 720 ? 0.2126f : 0.299f;
+    float kb = _height >= 720 ? 0.0722f : 0.114f;
+    float kg = 1.0f - kr - kb;
+
+    // 自上而下的第row行对应读回数据的第_height - 1 - row行
+    auto pixel = [&](int x, int row) {
+        return frame.pixels.data() + (size_t) (_height - 1 - row) * pitch + (size_t) x * 4;
+    };
+    for (int row = 0; row < _height; ++row) {
+        for (int x = 0; x < _width; ++x) {
+            const unsigned char *p = pixel(x, row);
+            float luma = kr * p[0] + kg * p[1] + kb * p[2];
+            yPlane[(size_t) row * _width + x] = (unsigned char) (16.0f + luma * 219.0f / 255.0f + 0.5f);
+        }
+    }
+    for (int row = 0; row < chromaHeight; ++row) {
+        for (int x = 0; x < chromaWidth; ++x) {
+            float r = 0.0f, g = 0.0f, b = 0.0f;
+            for (int dy = 0; dy < 2; ++dy) {
+                for (int dx = 0; dx < 2; ++dx) {
+                    const unsigned char *p = pixel(std::min(x * 2 + dx, _width - 1),
+                                                   std::min(row * 2 + dy, _height - 1));
+                    r += p[0];
+                    g += p[1];
+                    b += p[2];
+                }
+            }
+            r *= 0.25f;
+            g *= 0.25f;
+            b *= 0.25f;
+            float luma = kr * r + kg * g + kb * b;
+            float u = (b - luma) / (2.0f * (1.0f - kb));
+            float v = (r - luma) / (2.0f * (1.0f - kr));
+            uPlane[(size_t) row * chromaWidth + x] = (unsigned char) (128.0f + u * 224.0f / 255.0f + 0.5f);
+            vPlane[(size_t) row * chromaWidth + x] = (unsigned char) (128.0f + v * 224.0f / 255.0f + 0.5f);
+        }
+    }
+    return fwrite("FRAME\n", 1, 6, _file) == 6 && fwrite(_scratch.data(), 1, _scratch.size(), _file) == _scratch.size();
+}
+
+/**
+ * @MethodName: release
+ * @Description: 丢弃在途的读回, 让写线程写完队列后退出, 关闭输出并删除PBO; 要保留所有帧先调用finish
+ */
+void GLESFrameCapture::release() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_all();
+    if (_writer.joinable()) {
+        _writer.join();
+    }
+    if (_file) {
+        fclose(_file);
+        _file = NULL;
+    }
+    for (PixelBuffer &pixelBuffer : _pixelBuffers) {
+        if (pixelBuffer.fence) {
+            glDeleteSync(pixelBuffer.fence);
+        }
+        _stateCache.deleteBuffers(1, &pixelBuffer.buffer);
+    }
+    _pixelBuffers.clear();
+    _inFlight = 0;
+    _frames.clear();
+    std::vector<unsigned char>().swap(_scratch);
+}
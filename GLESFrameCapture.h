@@ -0,0 +1,139 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESFRAMECAPTURE_H
+#define GLES_DEMO_GLESFRAMECAPTURE_H
+
+#include <GLES3/gl32.h>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GLESStateCache.h"
+
+// 截帧统计: droppedGpu为PBO环全部在途而放弃的帧, droppedQueue为写线程跟不上、内存帧用完而放弃的帧
+struct GLESCaptureStats {
+    uint64_t captured = 0;
+    uint64_t written = 0;
+    uint64_t droppedGpu = 0;
+    uint64_t droppedQueue = 0;
+    uint64_t writeErrors = 0;
+    int queueDepth = 0;
+    int maxQueueDepth = 0;
+};
+
+/**
+ * 异步截帧: glReadPixels读进PBO环并插入栅栏, 之后每帧只检查栅栏, 通过了才映射拷出,
+ * 交给写线程编码和写文件(RAW为连续的自上而下RGBA帧, PNG为每帧一个文件, Y4M为I420视频).
+ * 渲染线程不等待GPU也不等待磁盘, 跟不上时丢帧并计数; 离线生成时可以开启不丢帧模式, 改为等待.
+ * 除getStats外的方法都必须在GL线程调用. ringSize为0时不使用GL, 由submit直接提交内存中的帧(CPU合成).
+ */
+class GLESFrameCapture {
+public:
+    enum Format {
+        FORMAT_RAW = 0,
+        FORMAT_PNG,
+        FORMAT_Y4M
+    };
+
+    explicit GLESFrameCapture(GLESStateCache &stateCache);
+
+    ~GLESFrameCapture();
+
+    GLESFrameCapture(const GLESFrameCapture &) = delete;
+
+    GLESFrameCapture &operator=(const GLESFrameCapture &) = delete;
+
+    static bool parseFormat(const std::string &name, Format &format);
+
+    static const char *getExtension(Format format);
+
+    // PNG时path为带%d(可写成%05d)的文件名模板, 序号之外的%按字面字符处理; 没有%d时在扩展名之前加序号
+    bool start(const std::string &path, Format format, int width, int height, int fps = 60, int ringSize = 3,
+               int queueSize = 4);
+
+    bool isActive() const;
+
+    // 不丢帧: PBO环或内存帧用完时等待而不是丢帧, 用于渲染速度不要紧、每一帧都要输出的离线任务
+    void setLossless(bool lossless);
+
+    // 在交换缓冲之前调用, 读取当前的后台缓冲
+    void capture();
+
+    // 提交自下而上的RGBA帧(与glReadPixels相同), 只用于ringSize为0时; 返回是否交给了写线程
+    bool submit(const unsigned char *pixels);
+
+    // 取回栅栏已通过的读回
+    void poll();
+
+    // 等待所有在途的读回和写文件完成
+    void finish();
+
+    GLESCaptureStats getStats();
+
+    void release();
+
+private:
+    struct PixelBuffer {
+        GLuint buffer = 0;
+        GLsync fence = 0;
+        uint64_t frameIndex = 0;
+    };
+
+    // 写线程的内存帧, GL线程自下而上拷入
+    struct Frame {
+        std::vector<unsigned char> pixels;
+        uint64_t frameIndex = 0;
+    };
+
+    bool harvest(PixelBuffer &pixelBuffer);
+
+    // 取一个空闲内存帧, 用完时返回-1并计为丢帧(不丢帧模式下等待)
+    int acquireFrame();
+
+    void queueFrame(int slot, uint64_t frameIndex);
+
+    void harvestOldest();
+
+    void writerLoop();
+
+    bool writeFrame(const Frame &frame);
+
+    GLESStateCache &_stateCache;
+    Format _format = FORMAT_RAW;
+    // PNG文件名在序号前后的部分, 以及序号的宽度和是否补0
+    std::string _pathPrefix;
+    std::string _pathSuffix;
+    int _frameDigits = 0;
+    bool _frameZeroPad = false;
+    FILE *_file = NULL;
+    int _width = 0;
+    int _height = 0;
+    size_t _frameBytes = 0;
+    uint64_t _frameIndex = 0;
+    bool _lossless = false;
+
+    // PBO环, [_oldest, _oldest + _inFlight)在途
+    std::vector<PixelBuffer> _pixelBuffers;
+    int _oldest = 0;
+    int _inFlight = 0;
+
+    // 内存帧队列, [_queueHead, _queueHead + _stats.queueDepth)等待写出, 由_mutex保护
+    std::vector<Frame> _frames;
+    int _queueHead = 0;
+    GLESCaptureStats _stats;
+    // 写线程的转换缓冲, 反复复用
+    std::vector<unsigned char> _scratch;
+    bool _stop = false;
+    std::thread _writer;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::condition_variable _drainedCondition;
+};
+
+
+#endif //GLES_DEMO_GLESFRAMECAPTURE_H
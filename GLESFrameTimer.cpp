@@ -0,0 +1,320 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESFrameTimer.h"
+
+#define DYNAMICGLES_NO_NAMESPACE
+#define DYNAMICEGL_NO_NAMESPACE
+
+#include <DynamicGles.h>
+#include <algorithm>
+#include <cstdio>
+
+static double toMs(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+GLESFrameTimer::GLESFrameTimer(size_t capacity) : _samples(std::max<size_t>(capacity, 1)) {
+    _startTime = Clock::now();
+    _frameBegin = _lastFrameBegin = _startTime;
+}
+
+void GLESFrameTimer::setUseGpuTimer(bool useGpuTimer) {
+    _useGpuTimer = useGpuTimer;
+}
+
+void GLESFrameTimer::setFixedTimeStep(double seconds) {
+    _fixedTimeStep = seconds;
+}
+
+/**
+ * @MethodName: reset
+ * @Description: 清空样本重新统计(如跳过预热帧), 在途的GPU查询结果作废
+ */
+void GLESFrameTimer::reset() {
+    endGpuFrame();
+    for (GpuQuery &gpuQuery : _gpuQueries) {
+        gpuQuery.frameIndex = UINT64_MAX;
+    }
+    for (GLESFrameSample &sample : _samples) {
+        sample = GLESFrameSample();
+    }
+    _frameCount = 0;
+    _disjointCount = 0;
+}
+
+/**
+ * @MethodName: beginFrame
+ * @Description: 记录帧开始时间, 有空闲的查询对象时开始GPU计时; 查询都在途时本帧不测GPU, 不等待
+ */
+void GLESFrameTimer::beginFrame() {
+    _frameBegin = Clock::now();
+    if (_fixedTimeStep > 0.0) {
+        _frameTime = (double) _frameCount * _fixedTimeStep;
+    } else {
+        _frameTime = std::chrono::duration<double>(_frameBegin - _startTime).count();
+    }
+
+    _current = GLESFrameSample();
+    _current.frameIndex = _frameCount;
+    _current.frameMs = _frameCount > 0 ? (_lastPresented ? toMs(_frameBegin - _lastFrameBegin) : -1.0) : 0.0;
+    _lastFrameBegin = _frameBegin;
+
+    if (!_useGpuTimer) {
+        return;
+    }
+    GpuQuery &gpuQuery = _gpuQueries[_nextGpuQuery];
+    if (gpuQuery.active) {
+        return;
+    }
+    if (!gpuQuery.query) {
+        glGenQueriesEXT(1, &gpuQuery.query);
+    }
+    glBeginQueryEXT(GL_TIME_ELAPSED_EXT, gpuQuery.query);
+    gpuQuery.active = true;
+    gpuQuery.frameIndex = _frameCount;
+    _runningGpuQuery = _nextGpuQuery;
+    _nextGpuQuery = (_nextGpuQuery + 1) % GPU_QUERY_COUNT;
+}
+
+/**
+ * @MethodName: endGpuFrame
+ * @Description: 结束本帧的GPU计时, 应在交换缓冲之前调用; 重复调用无副作用
+ */
+void GLESFrameTimer::endGpuFrame() {
+    if (_runningGpuQuery < 0) {
+        return;
+    }
+    glEndQueryEXT(GL_TIME_ELAPSED_EXT);
+    _runningGpuQuery = -1;
+}
+
+void GLESFrameTimer::setPresented(bool presented) {
+    _current.presented = presented;
+}
+
+void GLESFrameTimer::setScale(double scale) {
+    _current.scale = scale;
+}
+
+double GLESFrameTimer::getFrameInterval() const {
+    return _frameCount > 0 ? _current.frameMs : -1.0;
+}
+
+/**
+ * @MethodName: endFrame
+ * @Description: 记录本帧CPU耗时并写入环形缓冲, 顺便取回已经完成的GPU查询结果
+ */
+void GLESFrameTimer::endFrame() {
+    endGpuFrame();
+    _current.cpuMs = toMs(Clock::now() - _frameBegin);
+    _samples[_frameCount % _samples.size()] = _current;
+    _lastPresented = _current.presented;
+    ++_frameCount;
+
+    if (_useGpuTimer) {
+        pollGpuQueries();
+    }
+}
+
+/**
+ * @MethodName: pollGpuQueries
+ * @Description: 从最早的查询开始检查, 遇到未完成的就停止; 发生disjoint(如GPU降频)时丢弃这批结果
+ */
+void GLESFrameTimer::pollGpuQueries() {
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (disjoint) {
+        ++_disjointCount;
+    }
+
+    for (int i = 0; i < GPU_QUERY_COUNT; ++i) {
+        GpuQuery &gpuQuery = _gpuQueries[(_nextGpuQuery + i) % GPU_QUERY_COUNT];
+        if (!gpuQuery.active) {
+            continue;
+        }
+        GLuint available = 0;
+        glGetQueryObjectuivEXT(gpuQuery.query, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+        if (!available) {
+            break;
+        }
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64vEXT(gpuQuery.query, GL_QUERY_RESULT_EXT, &elapsed);
+        gpuQuery.active = false;
+
+        GLESFrameSample *sample = findSample(gpuQuery.frameIndex);
+        if (sample && !disjoint) {
+            sample->gpuMs = (double) elapsed / 1.0e6;
+        }
+    }
+}
+
+GLESFrameSample *GLESFrameTimer::findSample(uint64_t frameIndex) {
+    GLESFrameSample &sample = _samples[frameIndex % _samples.size()];
+    return sample.frameIndex == frameIndex && frameIndex < _frameCount ? &sample : NULL;
+}
+
+// 距计时器创建的秒数, 动画进度使用
+double GLESFrameTimer::getTime() const {
+    return std::chrono::duration<double>(Clock::now() - _startTime).count();
+}
+
+// 当前帧开始时刻, 同一帧内多次读取保持一致
+double GLESFrameTimer::getFrameTime() const {
+    return _frameTime;
+}
+
+uint64_t GLESFrameTimer::getFrameCount() const {
+    return _frameCount;
+}
+
+const GLESFrameSample &GLESFrameTimer::getLastSample() const {
+    return _samples[(_frameCount + _samples.size() - 1) % _samples.size()];
+}
+
+/**
+ * @MethodName: getSamples
+ * @Return: 环形缓冲中仍保留的样本, 按帧序排列
+ */
+std::vector<GLESFrameSample> GLESFrameTimer::getSamples() const {
+    size_t count = (size_t) std::min<uint64_t>(_frameCount, _samples.size());
+    std::vector<GLESFrameSample> samples;
+    samples.reserve(count);
+    for (uint64_t i = _frameCount - count; i < _frameCount; ++i) {
+        samples.push_back(_samples[i % _samples.size()]);
+    }
+    return samples;
+}
+
+/**
+ * @MethodName: summarize
+ * @Return: 指定字段的均值和分位数, 忽略负值(没有结果的GPU样本、空闲之后的帧间隔)和跳过绘制的帧
+ * @Description: 统计窗口为环形缓冲中保留的最近若干帧
+ */
+GLESTimingSummary GLESFrameTimer::summarize(double GLESFrameSample::*field) const {
+    std::vector<double> values;
+    for (const GLESFrameSample &sample : getSamples()) {
+        // 第一帧没有帧间隔
+        if (sample.presented && sample.*field >= 0.0 && !(field == &GLESFrameSample::frameMs && sample.frameIndex == 0)) {
+            values.push_back(sample.*field);
+        }
+    }
+
+    GLESTimingSummary summary;
+    summary.count = values.size();
+    if (values.empty()) {
+        return summary;
+    }
+    std::sort(values.begin(), values.end());
+    double total = 0.0;
+    for (double value : values) {
+        total += value;
+    }
+    // 最近秩法取分位数
+    auto percentile = [&values](double p) {
+        size_t rank = (size_t) (p * (double) values.size() + 0.999999);
+        return values[std::min(values.size(), std::max<size_t>(rank, 1)) - 1];
+    };
+    summary.mean = total / (double) values.size();
+    summary.p50 = percentile(0.50);
+    summary.p95 = percentile(0.95);
+    summary.p99 = percentile(0.99);
+    summary.max = values.back();
+    return summary;
+}
+
+/**
+ * @MethodName: writeCsv
+ * @Return: 写文件是否成功
+ * @Description: 每帧一行, 没有帧间隔或GPU结果的帧对应列为空
+ */
+bool GLESFrameTimer::writeCsv(const std::string &path) const {
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file) {
+        printf("Failed to write frame times: %s\n", path.c_str());
+        return false;
+    }
+    fprintf(file, "frame,frame_ms,cpu_ms,gpu_ms,presented,scale\n");
+    for (const GLESFrameSample &sample : getSamples()) {
+        fprintf(file, "%llu,", (unsigned long long) sample.frameIndex);
+        if (sample.frameMs >= 0.0) {
+            fprintf(file, "%.4f", sample.frameMs);
+        }
+        fprintf(file, ",%.4f,", sample.cpuMs);
+        if (sample.gpuMs >= 0.0) {
+            fprintf(file, "%.4f", sample.gpuMs);
+        }
+        fprintf(file, ",%d,%.4f\n", sample.presented ? 1 : 0, sample.scale);
+    }
+    return fclose(file) == 0;
+}
+
+// 环形缓冲中跳过绘制的帧数
+size_t GLESFrameTimer::countSkipped() const {
+    size_t skipped = 0;
+    for (const GLESFrameSample &sample : getSamples()) {
+        skipped += sample.presented ? 0 : 1;
+    }
+    return skipped;
+}
+
+static void writeSummaryJson(FILE *file, const char *name, const GLESTimingSummary &summary, bool last) {
+    fprintf(file, "  \"%s\": {\"count\": %zu, \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, "
+                  "\"max\": %.4f}%s\n", name, summary.count, summary.mean, summary.p50, summary.p95, summary.p99,
+            summary.max, last ? "" : ",");
+}
+
+/**
+ * @MethodName: writeJson
+ * @Return: 写文件是否成功
+ * @Description: 输出帧间隔、CPU和GPU耗时以及渲染比例的分位数统计
+ */
+bool GLESFrameTimer::writeJson(const std::string &path) const {
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file) {
+        printf("Failed to write frame stats: %s\n", path.c_str());
+        return false;
+    }
+    fprintf(file, "{\n");
+    fprintf(file, "  \"frames\": %llu,\n", (unsigned long long) _frameCount);
+    fprintf(file, "  \"elapsed_s\": %.3f,\n", getTime());
+    fprintf(file, "  \"gpu_timer\": %s,\n", _useGpuTimer ? "true" : "false");
+    fprintf(file, "  \"gpu_disjoint\": %llu,\n", (unsigned long long) _disjointCount);
+    fprintf(file, "  \"skipped\": %zu,\n", countSkipped());
+    writeSummaryJson(file, "frame_ms", summarize(&GLESFrameSample::frameMs), false);
+    writeSummaryJson(file, "cpu_ms", summarize(&GLESFrameSample::cpuMs), false);
+    writeSummaryJson(file, "gpu_ms", summarize(&GLESFrameSample::gpuMs), false);
+    writeSummaryJson(file, "scale", summarize(&GLESFrameSample::scale), true);
+    fprintf(file, "}\n");
+    return fclose(file) == 0;
+}
+
+void GLESFrameTimer::printSummary() const {
+    GLESTimingSummary frame = summarize(&GLESFrameSample::frameMs);
+    GLESTimingSummary gpu = summarize(&GLESFrameSample::gpuMs);
+    printf("frames: %llu, frame ms p50 %.3f p95 %.3f p99 %.3f max %.3f", (unsigned long long) _frameCount,
+           frame.p50, frame.p95, frame.p99, frame.max);
+    if (gpu.count > 0) {
+        printf(", gpu ms p50 %.3f p99 %.3f", gpu.p50, gpu.p99);
+    }
+    GLESTimingSummary scale = summarize(&GLESFrameSample::scale);
+    if (scale.count > 0 && scale.mean < 1.0) {
+        printf(", scale mean %.3f p50 %.3f", scale.mean, scale.p50);
+    }
+    size_t skipped = countSkipped();
+    if (skipped > 0) {
+        printf(", skipped %zu", skipped);
+    }
+    printf("\n");
+}
+
+void GLESFrameTimer::release() {
+    for (GpuQuery &gpuQuery : _gpuQueries) {
+        if (gpuQuery.query) {
+            glDeleteQueriesEXT(1, &gpuQuery.query);
+        }
+        gpuQuery = GpuQuery();
+    }
+    _runningGpuQuery = -1;
+}
@@ -0,0 +1,124 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESFRAMETIMER_H
+#define GLES_DEMO_GLESFRAMETIMER_H
+
+#include <GLES3/gl32.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 单帧耗时, 单位毫秒; gpuMs小于0表示没有GPU计时结果, frameMs小于0表示上一帧没有交换(帧间隔含空闲等待)
+struct GLESFrameSample {
+    uint64_t frameIndex = 0;
+    double frameMs = 0.0;
+    double cpuMs = 0.0;
+    double gpuMs = -1.0;
+    // 画面没有变化时不绘制也不交换
+    bool presented = true;
+    // 动态分辨率下本帧的渲染比例
+    double scale = 1.0;
+};
+
+// 一组耗时的分位数统计
+struct GLESTimingSummary {
+    size_t count = 0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+/**
+ * 帧计时: 基于steady_clock的墙钟时间, 不受进程CPU时间和系统调时影响.
+ * 支持GL_EXT_disjoint_timer_query时, 用少量查询对象轮转测量GPU耗时, 结果就绪后才读取, 不会阻塞渲染.
+ * 每帧样本写入预分配的环形缓冲, 帧内不做堆分配; 分位数统计和文件导出只在退出时进行.
+ */
+class GLESFrameTimer {
+public:
+    explicit GLESFrameTimer(size_t capacity = 4096);
+
+    void setUseGpuTimer(bool useGpuTimer);
+
+    void setFixedTimeStep(double seconds);
+
+    void reset();
+
+    void beginFrame();
+
+    void endGpuFrame();
+
+    // 标记本帧是否绘制并交换, 在endFrame之前调用
+    void setPresented(bool presented);
+
+    void setScale(double scale);
+
+    // 本帧开始时测得的上一帧的帧间隔, 小于0表示没有
+    double getFrameInterval() const;
+
+    void endFrame();
+
+    double getTime() const;
+
+    double getFrameTime() const;
+
+    uint64_t getFrameCount() const;
+
+    const GLESFrameSample &getLastSample() const;
+
+    std::vector<GLESFrameSample> getSamples() const;
+
+    GLESTimingSummary summarize(double GLESFrameSample::*field) const;
+
+    size_t countSkipped() const;
+
+    bool writeCsv(const std::string &path) const;
+
+    bool writeJson(const std::string &path) const;
+
+    void printSummary() const;
+
+    void release();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    // 同时在途的GPU查询数, 结果通常滞后1~2帧
+    static const int GPU_QUERY_COUNT = 4;
+
+    struct GpuQuery {
+        GLuint query = 0;
+        uint64_t frameIndex = 0;
+        bool active = false;
+    };
+
+    void pollGpuQueries();
+
+    GLESFrameSample *findSample(uint64_t frameIndex);
+
+    Clock::time_point _startTime;
+    Clock::time_point _frameBegin;
+    Clock::time_point _lastFrameBegin;
+    bool _lastPresented = true;
+    double _frameTime = 0.0;
+    // 大于0时动画时间按帧数推进, 与实际耗时无关, 基准测试用来保证画面可复现
+    double _fixedTimeStep = 0.0;
+    uint64_t _frameCount = 0;
+
+    std::vector<GLESFrameSample> _samples;
+    GLESFrameSample _current;
+
+    bool _useGpuTimer = false;
+    GpuQuery _gpuQueries[GPU_QUERY_COUNT];
+    int _nextGpuQuery = 0;
+    // 当前帧是否有正在进行的GPU查询
+    int _runningGpuQuery = -1;
+    uint64_t _disjointCount = 0;
+};
+
+
+#endif //GLES_DEMO_GLESFRAMETIMER_H
@@ -0,0 +1,190 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESGeometry.h"
+
+#define DYNAMICGLES_NO_NAMESPACE
+#define DYNAMICEGL_NO_NAMESPACE
+
+#include <DynamicGles.h>
+#include <cstdio>
+
+GLESGeometry::GLESGeometry(GLESStateCache &stateCache) : _stateCache(stateCache) {
+}
+
+/**
+ * @MethodName: setUseVertexArrays
+ * @Description: GLES3上下文才有VAO, GLES2下每次绑定都重新设置属性指针
+ */
+void GLESGeometry::setUseVertexArrays(bool useVAO) {
+    _useVAO = useVAO;
+}
+
+/**
+ * @MethodName: registerMesh
+ * @Return: 网格id, 失败返回-1
+ * @Description: 把静态顶点和索引一次性上传到VBO/IBO, 之后每帧只需绑定和绘制
+ */
+int GLESGeometry::registerMesh(const std::string &name, const void *vertices, GLsizeiptr verticesBytes, GLsizei stride,
+                               const std::vector<GLESVertexAttrib> &attribs, const GLushort *indices,
+                               GLsizei indexCount) {
+    if (!vertices || verticesBytes <= 0 || !indices || indexCount <= 0) {
+        printf("Invalid mesh data: %s\n", name.c_str());
+        return -1;
+    }
+
+    GLESMesh mesh;
+    mesh.name = name;
+    mesh.stride = stride;
+    mesh.indexCount = indexCount;
+    mesh.attribs = attribs;
+
+    // VAO要在绑定缓冲之前创建, 这样IBO绑定和属性布局都记录在VAO里
+    if (_useVAO) {
+        glGenVertexArrays(1, &mesh.vao);
+        _stateCache.bindVertexArray(mesh.vao);
+    }
+
+    glGenBuffers(1, &mesh.vbo);
+    _stateCache.bindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+    glBufferData(GL_ARRAY_BUFFER, verticesBytes, vertices, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &mesh.ibo);
+    _stateCache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(GLushort), indices, GL_STATIC_DRAW);
+
+    if (_useVAO) {
+        setupAttribs(mesh);
+        _stateCache.bindVertexArray(0);
+    }
+    _stateCache.bindBuffer(GL_ARRAY_BUFFER, 0);
+    _stateCache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    _boundMesh = -1;
+
+    if (glGetError() != GL_NO_ERROR) {
+        printf("Failed to upload mesh: %s\n", name.c_str());
+        return -1;
+    }
+
+    _meshes.push_back(mesh);
+    return (int) _meshes.size() - 1;
+}
+
+int GLESGeometry::findMesh(const std::string &name) const {
+    for (size_t i = 0; i < _meshes.size(); ++i) {
+        if (_meshes[i].name == name) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+const GLESMesh *GLESGeometry::getMesh(int meshID) const {
+    if (meshID < 0 || meshID >= (int) _meshes.size()) {
+        return NULL;
+    }
+    return &_meshes[meshID];
+}
+
+void GLESGeometry::setupAttribs(const GLESMesh &mesh) {
+    for (const GLESVertexAttrib &attrib : mesh.attribs) {
+        glVertexAttribPointer(attrib.index, attrib.size, attrib.type, attrib.normalized, mesh.stride,
+                              (const void *) (size_t) attrib.offset);
+        _stateCache.setVertexAttribArray(attrib.index, true);
+    }
+}
+
+/**
+ * @MethodName: bindMesh
+ * @Description: 绑定网格, 重复的绑定由状态缓存省掉; GLES2下顶点数组缓冲仍是本网格时不再重设属性指针
+ */
+void GLESGeometry::bindMesh(int meshID) {
+    const GLESMesh *mesh = getMesh(meshID);
+    if (!mesh) {
+        return;
+    }
+
+    if (_useVAO) {
+        _stateCache.bindVertexArray(mesh->vao);
+    } else {
+        bool pointersValid = meshID == _boundMesh && _stateCache.getBoundBuffer(GL_ARRAY_BUFFER) == mesh->vbo;
+        _stateCache.bindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+        _stateCache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ibo);
+        if (!pointersValid) {
+            setupAttribs(*mesh);
+        }
+    }
+    _boundMesh = meshID;
+}
+
+void GLESGeometry::drawMesh(int meshID) {
+    const GLESMesh *mesh = getMesh(meshID);
+    if (!mesh) {
+        return;
+    }
+    bindMesh(meshID);
+
+    // 索引来自已绑定的IBO, 最后一个参数是缓冲内偏移而不是客户端指针
+    glDrawElements(mesh->mode, mesh->indexCount, mesh->indexType, (const void *) 0);
+}
+
+/**
+ * @MethodName: setInstanceData
+ * @Return: 是否成功, 没有VAO(GLES2)时不支持实例化
+ * @Description: 上传逐实例数据并把属性记录进网格的VAO, 数据不变时之后每帧只需一次实例化绘制;
+ *               再次调用会整体替换实例数据
+ */
+bool GLESGeometry::setInstanceData(int meshID, const void *data, GLsizeiptr bytes, GLsizei stride,
+                                   const std::vector<GLESVertexAttrib> &attribs, GLsizei instanceCount) {
+    if (meshID < 0 || meshID >= (int) _meshes.size() || !_useVAO || !data || bytes <= 0) {
+        return false;
+    }
+    GLESMesh &mesh = _meshes[meshID];
+
+    _stateCache.bindVertexArray(mesh.vao);
+    if (!mesh.instanceVbo) {
+        glGenBuffers(1, &mesh.instanceVbo);
+    }
+    _stateCache.bindBuffer(GL_ARRAY_BUFFER, mesh.instanceVbo);
+    glBufferData(GL_ARRAY_BUFFER, bytes, data, GL_STATIC_DRAW);
+    for (const GLESVertexAttrib &attrib : attribs) {
+        glVertexAttribPointer(attrib.index, attrib.size, attrib.type, attrib.normalized, stride,
+                              (const void *) (size_t) attrib.offset);
+        glVertexAttribDivisor(attrib.index, 1);
+        _stateCache.setVertexAttribArray(attrib.index, true);
+    }
+    _stateCache.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+    mesh.instanceStride = stride;
+    mesh.instanceCount = instanceCount;
+    mesh.instanceAttribs = attribs;
+    return glGetError() == GL_NO_ERROR;
+}
+
+/**
+ * @MethodName: drawMeshInstanced
+ * @Description: 一次绘制调用画出所有实例, instanceCount小于0时使用setInstanceData设置的个数
+ */
+void GLESGeometry::drawMeshInstanced(int meshID, GLsizei instanceCount) {
+    const GLESMesh *mesh = getMesh(meshID);
+    if (!mesh) {
+        return;
+    }
+    if (instanceCount < 0) {
+        instanceCount = mesh->instanceCount;
+    }
+    bindMesh(meshID);
+    glDrawElementsInstanced(mesh->mode, mesh->indexCount, mesh->indexType, (const void *) 0, instanceCount);
+}
+
+void GLESGeometry::release() {
+    for (GLESMesh &mesh : _meshes) {
+        if (mesh.vao) { _stateCache.deleteVertexArrays(1, &mesh.vao); }
+        if (mesh.instanceVbo) { _stateCache.deleteBuffers(1, &mesh.instanceVbo); }
+        _stateCache.deleteBuffers(1, &mesh.vbo);
+        _stateCache.deleteBuffers(1, &mesh.ibo);
+    }
+    _meshes.clear();
+    _boundMesh = -1;
+}
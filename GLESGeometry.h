@@ -0,0 +1,74 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESGEOMETRY_H
+#define GLES_DEMO_GLESGEOMETRY_H
+
+#include <GLES3/gl32.h>
+#include <string>
+#include <vector>
+#include "GLESStateCache.h"
+
+// 顶点属性描述, offset为在一个顶点内的字节偏移
+struct GLESVertexAttrib {
+    GLuint index;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    GLsizei offset;
+};
+
+// 常驻显存的网格: 顶点/索引只上传一次, GLES3下再用VAO记录属性布局
+struct GLESMesh {
+    std::string name;
+    GLuint vbo = 0;
+    GLuint ibo = 0;
+    GLuint vao = 0;
+    GLsizei stride = 0;
+    GLsizei indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_SHORT;
+    GLenum mode = GL_TRIANGLES;
+    std::vector<GLESVertexAttrib> attribs;
+    // 逐实例数据(divisor为1的属性), 只在GLES3的VAO路径下可用
+    GLuint instanceVbo = 0;
+    GLsizei instanceStride = 0;
+    GLsizei instanceCount = 0;
+    std::vector<GLESVertexAttrib> instanceAttribs;
+};
+
+class GLESGeometry {
+public:
+    explicit GLESGeometry(GLESStateCache &stateCache);
+
+    void setUseVertexArrays(bool useVAO);
+
+    int registerMesh(const std::string &name, const void *vertices, GLsizeiptr verticesBytes, GLsizei stride,
+                     const std::vector<GLESVertexAttrib> &attribs, const GLushort *indices, GLsizei indexCount);
+
+    int findMesh(const std::string &name) const;
+
+    const GLESMesh *getMesh(int meshID) const;
+
+    void bindMesh(int meshID);
+
+    void drawMesh(int meshID);
+
+    bool setInstanceData(int meshID, const void *data, GLsizeiptr bytes, GLsizei stride,
+                         const std::vector<GLESVertexAttrib> &attribs, GLsizei instanceCount);
+
+    void drawMeshInstanced(int meshID, GLsizei instanceCount = -1);
+
+    void release();
+
+private:
+    void setupAttribs(const GLESMesh &mesh);
+
+    GLESStateCache &_stateCache;
+    bool _useVAO = false;
+    int _boundMesh = -1;
+    std::vector<GLESMesh> _meshes;
+};
+
+
+#endif //GLES_DEMO_GLESGEOMETRY_H
@@ -0,0 +1,39 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESHASH_H
+#define GLES_DEMO_GLESHASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// FNV-1a 64位哈希, 用于磁盘缓存的键, 不用于安全相关场合
+const uint64_t GLES_HASH_SEED = 14695981039346656037ULL;
+
+inline uint64_t hashBytes(const void *data, size_t size, uint64_t hash = GLES_HASH_SEED) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+inline uint64_t hashString(const std::string &str, uint64_t hash = GLES_HASH_SEED) {
+    // 带上长度, 避免"ab"+"c"与"a"+"bc"拼接后相同
+    uint64_t length = str.size();
+    hash = hashBytes(&length, sizeof(length), hash);
+    return hashBytes(str.data(), str.size(), hash);
+}
+
+inline std::string hashToHex(uint64_t hash) {
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long) hash);
+    return std::string(buffer);
+}
+
+
+#endif //GLES_DEMO_GLESHASH_H
@@ -0,0 +1,336 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESJobRunner.h"
+#include "GLESUtils.h"
+#include "GLESCompositor.h"
+#include "GLESTrace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+static double nowMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+// 清单中的相对路径相对清单所在目录
+static std::string resolvePath(const std::string &directory, const std::string &path) {
+    if (path.empty() || path[0] == '/' || directory.empty()) {
+        return path;
+    }
+    return directory + "/" + path;
+}
+
+static bool endsWith(const std::string &text, const char *suffix) {
+    size_t length = strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+GLESJobRunner::GLESJobRunner(const GLESSceneConfig &base) : _base(base) {
+}
+
+/**
+ * @MethodName: loadManifest
+ * @Return: 清单是否全部解析成功, 出错时打印行号且不加入任何任务
+ * @Description: 每行一个任务, 未给出的字段用GLESRenderJob的默认值
+ */
+bool GLESJobRunner::loadManifest(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+        printf("Failed to open job manifest: %s\n", path.c_str());
+        return false;
+    }
+    size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "" : path.substr(0, slash);
+
+    std::vector<GLESRenderJob> jobs;
+    std::string line;
+    for (int lineNumber = 1; std::getline(in, line); ++lineNumber) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream tokens(line);
+        std::string token;
+        GLESRenderJob job;
+        bool empty = true;
+        while (tokens >> token) {
+            empty = false;
+            size_t equals = token.find('=');
+            std::string key = token.substr(0, equals);
+            std::string value = equals == std::string::npos ? "" : token.substr(equals + 1);
+            bool valid = !value.empty();
+            if (key == "output") {
+                job.output = resolvePath(directory, value);
+            } else if (key == "images") {
+                std::istringstream images(value);
+                std::string image;
+                while (std::getline(images, image, ',')) {
+                    if (!image.empty()) {
+                        job.images.push_back(resolvePath(directory, image));
+                    }
+                }
+            } else if (key == "shader") {
+                job.shader = resolvePath(directory, value);
+            } else if (key == "easing") {
+                job.easing = value;
+            } else if (key == "duration") {
+                job.duration = atof(value.c_str());
+                valid = job.duration > 0.0;
+            } else if (key == "fps") {
+                job.fps = atoi(value.c_str());
+                valid = job.fps > 0;
+            } else if (key == "size") {
+                valid = sscanf(value.c_str(), "%dx%d", &job.width, &job.height) == 2 && job.width > 0 &&
+                        job.height > 0;
+            } else if (key == "format") {
+                GLESFrameCapture::Format format;
+                job.format = value;
+                valid = GLESFrameCapture::parseFormat(value, format);
+            } else {
+                valid = false;
+            }
+            if (!valid) {
+                printf("%s:%d: invalid field '%s'\n", path.c_str(), lineNumber, token.c_str());
+                return false;
+            }
+        }
+        if (empty) {
+            continue;
+        }
+        if (job.output.empty() || job.images.empty()) {
+            printf("%s:%d: a job needs output= and images=\n", path.c_str(), lineNumber);
+            return false;
+        }
+        jobs.push_back(job);
+    }
+    _jobs.insert(_jobs.end(), jobs.begin(), jobs.end());
+    return true;
+}
+
+void GLESJobRunner::addJob(const GLESRenderJob &job) {
+    _jobs.push_back(job);
+}
+
+const std::vector<GLESRenderJob> &GLESJobRunner::getJobs() const {
+    return _jobs;
+}
+
+void GLESJobRunner::setSoftware(bool software) {
+    _software = software;
+}
+
+/**
+ * @MethodName: run
+ * @Return: 是否所有任务都成功
+ * @Description: 工作线程按顺序领取任务, 每个任务在领取它的线程里创建和销毁自己的GLESUtils
+ */
+bool GLESJobRunner::run(unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    _threads = std::max(1u, std::min(threads, (unsigned) _jobs.size()));
+    _results.assign(_jobs.size(), GLESJobResult());
+
+    double begin = nowMs();
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < _threads; ++i) {
+        workers.emplace_back([this, &next] {
+            GLES_TRACE_THREAD_NAME("job worker");
+            for (size_t index = next++; index < _jobs.size(); index = next++) {
+                _results[index] = runJob(_jobs[index]);
+            }
+        });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    _wallMs = nowMs() - begin;
+
+    bool ok = true;
+    for (const GLESJobResult &result : _results) {
+        ok = ok && result.ok;
+    }
+    return ok;
+}
+
+/**
+ * @MethodName: runJob
+ * @Return: 任务结果
+ * @Description: 固定步长1/fps, 着色器的进度progress * speed在最后一帧恰好到1; 纹理全部上传后才画第一帧
+ */
+GLESJobResult GLESJobRunner::runJob(const GLESRenderJob &job) {
+    GLES_TRACE_SCOPE("renderJob");
+    GLESJobResult result;
+    result.frames = std::max(1, (int) (job.duration * job.fps + 0.5));
+
+    GLESSceneConfig config = _base;
+    if (!job.shader.empty()) {
+        config.fshPath = job.shader;
+    }
+    if (!job.easing.empty()) {
+        config.easing = job.easing;
+    }
+    config.imageFiles = job.images;
+    config.textureSize = (int) job.images.size();
+    config.speed = result.frames > 1 ? (float) job.fps / (float) (result.frames - 1) : 1.0f;
+    config.capturePath = job.output;
+    config.captureFormat = job.format;
+    if (config.captureFormat.empty()) {
+        config.captureFormat = endsWith(job.output, ".y4m") ? "y4m" : endsWith(job.output, ".png") ? "png" : "raw";
+    }
+    config.captureFps = job.fps;
+    config.captureLossless = true;
+    // 任务只渲染图片过渡
+    config.tileColumns = config.tileRows = 0;
+    config.videoPath.clear();
+    config.playlistPaths.clear();
+
+    if (_software) {
+        runJobSoftware(job, config, result);
+        return result;
+    }
+
+    double begin = nowMs();
+    std::unique_ptr<GLESUtils> gles(new GLESUtils());
+    gles->setWindowWH((unsigned) job.width, (unsigned) job.height);
+    gles->setAppName("GLES Job");
+    gles->setOffscreen(true);
+    gles->setSceneConfig(config);
+    if (!gles->initNativeAndEGL()) {
+        printf("%s: failed to create EGL context, rendering on the CPU\n", job.output.c_str());
+        runJobSoftware(job, config, result);
+        return result;
+    }
+    // 直接用源图, 不用有损的ETC2缓存, 同一个任务每次输出完全一致
+    gles->getTextureLoader().setTextureCache(NULL);
+    gles->getFrameTimer().setFixedTimeStep(1.0 / job.fps);
+    if (!gles->initShaders()) {
+        printf("%s: failed to init shaders\n", job.output.c_str());
+        gles->deInitGLState();
+        gles->cleanProc();
+        return result;
+    }
+    gles->getTextureLoader().finish();
+    result.setupMs = nowMs() - begin;
+
+    double renderBegin = nowMs();
+    bool ok = true;
+    for (int i = 0; ok && i < result.frames; ++i) {
+        ok = gles->renderScene();
+    }
+    GLESFrameCapture &capture = gles->getFrameCapture();
+    capture.finish();
+    result.renderMs = nowMs() - renderBegin;
+
+    GLESCaptureStats stats = capture.getStats();
+    result.written = stats.written;
+    result.dropped = stats.droppedGpu + stats.droppedQueue + stats.writeErrors;
+    result.fps = result.renderMs > 0.0 ? result.frames * 1000.0 / result.renderMs : 0.0;
+    result.ok = ok && result.written == (uint64_t) result.frames && result.dropped == 0;
+
+    gles->deInitGLState();
+    gles->cleanProc();
+    return result;
+}
+
+/**
+ * @MethodName: runJobSoftware
+ * @Description: 与GL路径相同的帧时间和过渡参数, 由GLESCompositor逐帧合成后交给截帧的写线程;
+ *               s_texture[0]和s_texture[1]分别对应第一张和第二张图
+ */
+void GLESJobRunner::runJobSoftware(const GLESRenderJob &job, const GLESSceneConfig &config, GLESJobResult &result) {
+    result.software = true;
+    GLESCompositor::Effect effect;
+    int easing;
+    if (!GLESCompositor::getEffectForShader(config.fshPath, effect)) {
+        printf("%s: no CPU implementation of %s\n", job.output.c_str(), config.fshPath.c_str());
+        return;
+    }
+    if (!GLESCompositor::parseEasing(config.easing, easing)) {
+        printf("%s: unknown easing %s\n", job.output.c_str(), config.easing.c_str());
+        return;
+    }
+    GLESFrameCapture::Format format;
+    if (!GLESFrameCapture::parseFormat(config.captureFormat, format)) {
+        printf("%s: unknown capture format %s\n", job.output.c_str(), config.captureFormat.c_str());
+        return;
+    }
+
+    double begin = nowMs();
+    GLESThreadPool pool;
+    GLESImage images[2];
+    for (int i = 0; i < 2; ++i) {
+        const std::string &file = config.imageFiles[i % config.imageFiles.size()];
+        if (!GLESTextureLoader::decodeImage(file, images[i], &pool)) {
+            printf("%s: failed to decode %s\n", job.output.c_str(), file.c_str());
+            return;
+        }
+    }
+    // 没有GL上下文, 状态缓存只是满足截帧的接口, 不会被调用
+    GLESStateCache stateCache;
+    GLESFrameCapture capture(stateCache);
+    if (!capture.start(config.capturePath, format, job.width, job.height, config.captureFps, 0)) {
+        return;
+    }
+    capture.setLossless(true);
+    GLESCompositor compositor(&pool);
+    std::vector<unsigned char> pixels((size_t) job.width * job.height * 4);
+    result.setupMs = nowMs() - begin;
+
+    double renderBegin = nowMs();
+    bool ok = true;
+    for (int i = 0; ok && i < result.frames; ++i) {
+        float transition = std::min(std::max((float) ((double) i / job.fps) * config.speed, 0.0f), 1.0f);
+        ok = compositor.composite(effect, images[0], images[1], transition, GLESCompositor::ease(easing, transition),
+                                  pixels.data(), job.width, job.height) && capture.submit(pixels.data());
+    }
+    capture.finish();
+    result.renderMs = nowMs() - renderBegin;
+
+    GLESCaptureStats stats = capture.getStats();
+    result.written = stats.written;
+    result.dropped = stats.droppedGpu + stats.droppedQueue + stats.writeErrors;
+    result.fps = result.renderMs > 0.0 ? result.frames * 1000.0 / result.renderMs : 0.0;
+    result.ok = ok && result.written == (uint64_t) result.frames && result.dropped == 0;
+    capture.release();
+}
+
+const std::vector<GLESJobResult> &GLESJobRunner::getResults() const {
+    return _results;
+}
+
+double GLESJobRunner::getTotalFps() const {
+    int frames = 0;
+    for (const GLESJobResult &result : _results) {
+        frames += result.ok ? result.frames : 0;
+    }
+    return _wallMs > 0.0 ? frames * 1000.0 / _wallMs : 0.0;
+}
+
+void GLESJobRunner::printReport(FILE *file) const {
+    int frames = 0;
+    for (size_t i = 0; i < _results.size(); ++i) {
+        const GLESRenderJob &job = _jobs[i];
+        const GLESJobResult &result = _results[i];
+        frames += result.ok ? result.frames : 0;
+        fprintf(file, "job %zu/%zu %s %dx%d %d frames | setup %7.1f ms render %8.1f ms | %7.1f fps | "
+                      "written %llu dropped %llu%s%s\n", i + 1, _results.size(), job.output.c_str(), job.width,
+                job.height, result.frames, result.setupMs, result.renderMs, result.fps,
+                (unsigned long long) result.written, (unsigned long long) result.dropped,
+                result.software ? " (cpu)" : "", result.ok ? "" : "  FAILED");
+    }
+    fprintf(file, "%zu jobs, %d frames on %u threads in %.1f ms | %.1f fps total\n", _results.size(), frames,
+            _threads, _wallMs, getTotalFps());
+}
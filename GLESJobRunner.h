@@ -0,0 +1,89 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESJOBRUNNER_H
+#define GLES_DEMO_GLESJOBRUNNER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "GLESSceneConfig.h"
+
+// 一个过渡片段的渲染任务, 帧数为duration * fps
+struct GLESRenderJob {
+    std::string output;
+    std::vector<std::string> images;
+    // 片元着色器, 空表示用基础配置的
+    std::string shader;
+    // 缓动曲线, 空表示用基础配置的
+    std::string easing;
+    double duration = 2.0;
+    int fps = 30;
+    int width = 1280;
+    int height = 720;
+    // raw/png/y4m, 空表示按输出文件扩展名判断
+    std::string format;
+};
+
+struct GLESJobResult {
+    bool ok = false;
+    // 由CPU参考合成渲染
+    bool software = false;
+    int frames = 0;
+    // 创建上下文、编译着色器和加载纹理的耗时
+    double setupMs = 0.0;
+    // 从第一帧到最后一帧写完的耗时
+    double renderMs = 0.0;
+    double fps = 0.0;
+    uint64_t written = 0;
+    uint64_t dropped = 0;
+};
+
+/**
+ * 批量渲染过渡片段: 每个工作线程依次领取任务, 为每个任务创建独立的上下文和离屏surface,
+ * 按帧序号推进动画(第i帧的时间为i / fps, 与墙钟无关), 每一帧经不丢帧的截帧写到输出文件.
+ * 任务清单每行一个任务, 由空白分隔的key=value组成, #开头为注释:
+ *   output=PATH images=A,B[,...] [shader=FRAG] [easing=NAME] [duration=SEC] [fps=N] [size=WxH] [format=raw|png|y4m]
+ * 清单中的相对路径相对清单所在目录.
+ * 创建不了EGL上下文(或开启了setSoftware)时, 有CPU实现的过渡(见GLESCompositor)改由CPU合成, 输出相同的文件.
+ */
+class GLESJobRunner {
+public:
+    // base提供顶点着色器、默认片元着色器和缓存目录
+    explicit GLESJobRunner(const GLESSceneConfig &base);
+
+    bool loadManifest(const std::string &path);
+
+    void addJob(const GLESRenderJob &job);
+
+    const std::vector<GLESRenderJob> &getJobs() const;
+
+    // 不尝试GL, 直接用CPU合成
+    void setSoftware(bool software);
+
+    // threads为0时取硬件线程数, 不超过任务数; 返回是否所有任务都成功
+    bool run(unsigned threads = 0);
+
+    const std::vector<GLESJobResult> &getResults() const;
+
+    // 所有任务帧数之和除以总耗时
+    double getTotalFps() const;
+
+    void printReport(FILE *file) const;
+
+private:
+    GLESJobResult runJob(const GLESRenderJob &job);
+
+    void runJobSoftware(const GLESRenderJob &job, const GLESSceneConfig &config, GLESJobResult &result);
+
+    GLESSceneConfig _base;
+    std::vector<GLESRenderJob> _jobs;
+    std::vector<GLESJobResult> _results;
+    unsigned _threads = 0;
+    bool _software = false;
+    double _wallMs = 0.0;
+};
+
+
+#endif //GLES_DEMO_GLESJOBRUNNER_H
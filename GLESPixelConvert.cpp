@@ -0,0 +1,324 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESPixelConvert.h"
+#include "GLESThreadPool.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GLES_PIXEL_X86 1
+#include <immintrin.h>
+#endif
+
+/* 标量参考实现, SIMD版本必须与之逐位一致 */
+
+static void copyRgbScalar(const unsigned char *src, unsigned char *dst, size_t pixels) {
+    memmove(dst, src, pixels * 3);
+}
+
+static void bgrToRgbScalar(const unsigned char *src, unsigned char *dst, size_t pixels) {
+    for (size_t i = 0; i < pixels; ++i) {
+        unsigned char b = src[i * 3], g = src[i * 3 + 1], r = src[i * 3 + 2];
+        dst[i * 3] = r;
+        dst[i * 3 + 1] = g;
+        dst[i * 3 + 2] = b;
+    }
+}
+
+static void bgrToRgbaScalar(const unsigned char *src, unsigned char *dst, size_t pixels) {
+    for (size_t i = 0; i < pixels; ++i) {
+        dst[i * 4] = src[i * 3 + 2];
+        dst[i * 4 + 1] = src[i * 3 + 1];
+        dst[i * 4 + 2] = src[i * 3];
+        dst[i * 4 + 3] = 255;
+    }
+}
+
+// c * a / 255, 四舍五入, 对所有8位输入都是精确的
+static inline unsigned char mulDiv255(unsigned c, unsigned a) {
+    unsigned t = c * a + 128;
+    return (unsigned char) ((t + (t >> 8)) >> 8);
+}
+
+static void premultiplyRgbaScalar(const unsigned char *src, unsigned char *dst, size_t pixels) {
+    for (size_t i = 0; i < pixels; ++i) {
+        unsigned a = src[i * 4 + 3];
+        dst[i * 4] = mulDiv255(src[i * 4], a);
+        dst[i * 4 + 1] = mulDiv255(src[i * 4 + 1], a);
+        dst[i * 4 + 2] = mulDiv255(src[i * 4 + 2], a);
+        dst[i * 4 + 3] = (unsigned char) a;
+    }
+}
+
+#ifdef GLES_PIXEL_X86
+
+/* SSE2: 没有字节重排指令, 以48字节(16个像素)为一组, 用移位和掩码交换R/B */
+
+struct BgrSwapMasks {
+    // [向量序号][0: 取后2字节, 1: 保持, 2: 取前2字节]
+    alignas(16) unsigned char masks[3][3][16];
+
+    BgrSwapMasks() {
+        for (int k = 0; k < 3; ++k) {
+            for (int p = 0; p < 16; ++p) {
+                int m = (k * 16 + p) % 3;
+                for (int j = 0; j < 3; ++j) {
+                    masks[k][j][p] = (unsigned char) (m == j ? 0xFF : 0);
+                }
+            }
+        }
+    }
+};
+
+__attribute__((target("sse2")))
+static void bgrToRgbSse2(const unsigned char *src, unsigned char *dst, size_t pixels) {
+    static const BgrSwapMasks swapMasks;
+    size_t blocks = pixels / 16;
+    for (size_t i = 0; i < blocks; ++i) {
+        const unsigned char *s = src + i * 48;
+        unsigned char *d = dst + i * 48;
+        __m128i in[3];
+        in[0] = _mm_loadu_si128((const __m128i *) s);
+        in[1] = _mm_loadu_si128((const __m128i *) (s + 16));
+        in[2] = _mm_loadu_si128((const __m128i *) (s + 32));
+
+        __m128i out[3];
+        for (int k = 0; k < 3; ++k) {
+            // forward[p] = stream[p + 2], backward[p] = stream[p - 2]
+            __m128i forward = _mm_srli_si128(in[k], 2);
+            if (k < 2) { forward = _mm_or_si128(forward, _mm_slli_si128(in[k + 1], 14)); }
+            __m128i backward = _mm_slli_si128(in[k], 2);
+            if (k > 0) { backward = _mm_or_si128(backward, _mm_srli_si128(in[k - 1], 14)); }
+
+            __m128i m0 = _mm_load_si128((const __m128i *) swapMasks.masks[k][0]);
+            __m128i m1 = _mm_load_si128((const __m128i *) swapMasks.masks[k][1]);
+            __m128i m2 = _mm_load_si128((const __m128i *) swapMasks.masks[k][2]);
+            out[k] = _mm_or_si128(_mm_or_si128(_mm_and_si128(forward, m0), _mm_and_si128(in[k], m1)),
+                                  _mm_and_si128(backward, m2));
+        }
+        // 三个输入都读完才写, 原地转换也安全
+        _mm_storeu_si128((__m128i *) d, out[0]);
+        _mm_storeu_si128((__m128i *) (d + 16), out[1]);
+        _mm_storeu_si128((__m128i *) (d + 32), out[2]);
+    }
+    bgrToRgbScalar(src + blocks * 48, dst + blocks * 48, pixels - blocks * 16);
+}
+
+__attribute__((target("sse2")))
+static void premultiplyRgbaSse2(const unsigned char *src, unsigned char *dst, size_t pixels) {
+    const __m128i zero = _mm_setzero_si128();
+    // alpha分量乘255, (a * 255) / 255 == a, 所以alpha保持不变
+    const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    const __m128i alpha255 = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    const __m128i round = _mm_set1_epi16(128);
+    size_t blocks = pixels / 4;
+    for (size_t i = 0; i < blocks; ++i) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i * 16));
+        __m128i halves[2] = {_mm_unpacklo_epi8(v, zero), _mm_unpackhi_epi8(v, zero)};
+        for (__m128i &h : halves) {
+            __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(h, 0xFF), 0xFF);
+            a = _mm_or_si128(_mm_andnot_si128(alphaLanes, a), alpha255);
+            __m128i t = _mm_add_epi16(_mm_mullo_epi16(h, a), round);
+            h = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        }
+        _mm_storeu_si128((__m128i *) (dst + i * 16), _mm_packus_epi16(halves[0], halves[1]));
+    }
+    premultiplyRgbaScalar(src + blocks * 16, dst + blocks * 16, pixels - blocks * 4);
+}
+
+/* SSSE3: pshufb一次处理4个像素, 读写16字节只用前12字节, 后4字节原样写回保证原地转换安全 */
+
+__attribute__((target("ssse3")))
+static void bgrToRgbSsse3(const unsigned char *src, unsigned char *dst, size_t pixels) {
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 12, 13, 14, 15);
+    size_t i = 0;
+    // 剩余至少6个像素(18字节)才能安全读写16字节
+    for (; i + 6 <= pixels; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i * 3));
+        _mm_storeu_si128((__m128i *) (dst + i * 3), _mm_shuffle_epi8(v, shuffle));
+    }
+    bgrToRgbScalar(src + i * 3, dst + i * 3, pixels - i);
+}
+
+__attribute__((target("ssse3")))
+static void bgrToRgbaSsse3(const unsigned char *src, unsigned char *dst, size_t pixels) {
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    const __m128i alpha = _mm_set1_epi32((int) 0xFF000000);
+    size_t i = 0;
+    for (; i + 6 <= pixels; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i * 3));
+        _mm_storeu_si128((__m128i *) (dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha));
+    }
+    bgrToRgbaScalar(src + i * 3, dst + i * 4, pixels - i);
+}
+
+/* AVX2: vpshufb按128位通道工作, 两个通道分别装入相邻的4个像素 */
+
+__attribute__((target("avx2")))
+static inline __m256i loadTwoPixelQuads(const unsigned char *src) {
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) src)),
+                                   _mm_loadu_si128((const __m128i *) (src + 12)), 1);
+}
+
+__attribute__((target("avx2")))
+static void bgrToRgbAvx2(const unsigned char *src, unsigned char *dst, size_t pixels) {
+    const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 12, 13, 14, 15,
+                                             2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 12, 13, 14, 15);
+    size_t i = 0;
+    // 第二个通道从第12字节读16字节, 剩余至少10个像素(30字节)
+    for (; i + 10 <= pixels; i += 8) {
+        __m256i v = _mm256_shuffle_epi8(loadTwoPixelQuads(src + i * 3), shuffle);
+        // 先写低通道, 高通道覆盖低通道多写的4字节
+        _mm_storeu_si128((__m128i *) (dst + i * 3), _mm256_castsi256_si128(v));
+        _mm_storeu_si128((__m128i *) (dst + i * 3 + 12), _mm256_extracti128_si256(v, 1));
+    }
+    bgrToRgbScalar(src + i * 3, dst + i * 3, pixels - i);
+}
+
+__attribute__((target("avx2")))
+static void bgrToRgbaAvx2(const unsigned char *src, unsigned char *dst, size_t pixels) {
+    const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+                                             2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    const __m256i alpha = _mm256_set1_epi32((int) 0xFF000000);
+    size_t i = 0;
+    for (; i + 10 <= pixels; i += 8) {
+        __m256i v = _mm256_shuffle_epi8(loadTwoPixelQuads(src + i * 3), shuffle);
+        _mm256_storeu_si256((__m256i *) (dst + i * 4), _mm256_or_si256(v, alpha));
+    }
+    bgrToRgbaScalar(src + i * 3, dst + i * 4, pixels - i);
+}
+
+__attribute__((target("avx2")))
+static void premultiplyRgbaAvx2(const unsigned char *src, unsigned char *dst, size_t pixels) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alphaLanes = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+    const __m256i alpha255 = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+    const __m256i round = _mm256_set1_epi16(128);
+    size_t blocks = pixels / 8;
+    for (size_t i = 0; i < blocks; ++i) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (src + i * 32));
+        __m256i halves[2] = {_mm256_unpacklo_epi8(v, zero), _mm256_unpackhi_epi8(v, zero)};
+        for (__m256i &h : halves) {
+            __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(h, 0xFF), 0xFF);
+            a = _mm256_or_si256(_mm256_andnot_si256(alphaLanes, a), alpha255);
+            __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(h, a), round);
+            h = _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+        }
+        // unpack和pack都按通道进行, 像素顺序保持不变
+        _mm256_storeu_si256((__m256i *) (dst + i * 32), _mm256_packus_epi16(halves[0], halves[1]));
+    }
+    premultiplyRgbaScalar(src + blocks * 32, dst + blocks * 32, pixels - blocks * 8);
+}
+
+#endif
+
+// [转换][指令集], NULL表示该指令集没有专门实现
+static const GLESPixelConvert::Kernel kernelTable[GLESPixelConvert::CONVERSION_COUNT][GLESPixelConvert::ISA_COUNT] = {
+#ifdef GLES_PIXEL_X86
+        {copyRgbScalar, NULL, NULL, NULL},
+        {bgrToRgbScalar, bgrToRgbSse2, bgrToRgbSsse3, bgrToRgbAvx2},
+        {bgrToRgbaScalar, NULL, bgrToRgbaSsse3, bgrToRgbaAvx2},
+        {premultiplyRgbaScalar, premultiplyRgbaSse2, NULL, premultiplyRgbaAvx2},
+#else
+        {copyRgbScalar, NULL, NULL, NULL},
+        {bgrToRgbScalar, NULL, NULL, NULL},
+        {bgrToRgbaScalar, NULL, NULL, NULL},
+        {premultiplyRgbaScalar, NULL, NULL, NULL},
+#endif
+};
+
+/**
+ * @MethodName: detectIsa
+ * @Return: 当前CPU支持的最高指令集, 只检测一次
+ */
+GLESPixelConvert::Isa GLESPixelConvert::detectIsa() {
+#ifdef GLES_PIXEL_X86
+    static const Isa detected = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) { return ISA_AVX2; }
+        if (__builtin_cpu_supports("ssse3")) { return ISA_SSSE3; }
+        if (__builtin_cpu_supports("sse2")) { return ISA_SSE2; }
+        return ISA_SCALAR;
+    }();
+    return detected;
+#else
+    return ISA_SCALAR;
+#endif
+}
+
+const char *GLESPixelConvert::getIsaName(Isa isa) {
+    switch (isa) {
+        case ISA_SSE2:
+            return "sse2";
+        case ISA_SSSE3:
+            return "ssse3";
+        case ISA_AVX2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
+
+const char *GLESPixelConvert::getConversionName(Conversion conversion) {
+    switch (conversion) {
+        case BGR_TO_RGB:
+            return "bgr_to_rgb";
+        case BGR_TO_RGBA:
+            return "bgr_to_rgba";
+        case PREMULTIPLY_RGBA:
+            return "premultiply_rgba";
+        default:
+            return "copy_rgb";
+    }
+}
+
+int GLESPixelConvert::getSrcBytesPerPixel(Conversion conversion) {
+    return conversion == PREMULTIPLY_RGBA ? 4 : 3;
+}
+
+int GLESPixelConvert::getDstBytesPerPixel(Conversion conversion) {
+    return conversion == BGR_TO_RGBA || conversion == PREMULTIPLY_RGBA ? 4 : 3;
+}
+
+GLESPixelConvert::Kernel GLESPixelConvert::getKernel(Conversion conversion, Isa isa, Isa *actualIsa) {
+    int level = std::min((int) isa, (int) detectIsa());
+    for (; level > ISA_SCALAR; --level) {
+        if (kernelTable[conversion][level]) {
+            break;
+        }
+    }
+    if (actualIsa) { *actualIsa = (Isa) level; }
+    return kernelTable[conversion][level];
+}
+
+void GLESPixelConvert::convertPixels(Conversion conversion, const unsigned char *src, unsigned char *dst,
+                                     size_t pixels) {
+    getKernel(conversion, ISA_AVX2)(src, dst, pixels);
+}
+
+/**
+ * @MethodName: convertImage
+ * @Description: 支持带对齐的行距(如FreeImage的4字节对齐), 大图按行分块交给线程池
+ */
+void GLESPixelConvert::convertImage(Conversion conversion, const unsigned char *src, size_t srcPitch,
+                                    unsigned char *dst, size_t dstPitch, int width, int height,
+                                    GLESThreadPool *pool) {
+    Kernel kernel = getKernel(conversion, ISA_AVX2);
+    auto convertRows = [=](int rowBegin, int rowEnd) {
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            kernel(src + (size_t) y * srcPitch, dst + (size_t) y * dstPitch, (size_t) width);
+        }
+    };
+
+    // 小图直接在当前线程做, 分发的开销比转换本身还大
+    const long parallelThreshold = 256 * 1024;
+    if (!pool || (long) width * height < parallelThreshold || height < 2) {
+        convertRows(0, height);
+        return;
+    }
+    int rowsPerChunk = std::max(1, height / (int) (pool->getThreadCount() * 4));
+    pool->parallelFor(0, height, rowsPerChunk, convertRows);
+}
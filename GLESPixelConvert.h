@@ -0,0 +1,61 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESPIXELCONVERT_H
+#define GLES_DEMO_GLESPIXELCONVERT_H
+
+#include <cstddef>
+
+class GLESThreadPool;
+
+/**
+ * 纹理上传路径上的像素格式转换.
+ * 每种转换都有标量参考实现和SSE2/SSSE3/AVX2版本, 运行时按CPU能力选择, 结果与标量版本逐位一致.
+ */
+class GLESPixelConvert {
+public:
+    enum Isa {
+        ISA_SCALAR = 0,
+        ISA_SSE2,
+        ISA_SSSE3,
+        ISA_AVX2,
+        ISA_COUNT
+    };
+
+    enum Conversion {
+        // 原样拷贝(只处理行距)
+        COPY_RGB = 0,
+        // BGR -> RGB, 可以原地转换
+        BGR_TO_RGB,
+        // BGR -> RGBA, alpha为255, 源和目标不能重叠
+        BGR_TO_RGBA,
+        // RGBA预乘alpha, 可以原地转换
+        PREMULTIPLY_RGBA,
+        CONVERSION_COUNT
+    };
+
+    typedef void (*Kernel)(const unsigned char *src, unsigned char *dst, size_t pixels);
+
+    static Isa detectIsa();
+
+    static const char *getIsaName(Isa isa);
+
+    static const char *getConversionName(Conversion conversion);
+
+    static int getSrcBytesPerPixel(Conversion conversion);
+
+    static int getDstBytesPerPixel(Conversion conversion);
+
+    // 返回不超过isa的最优实现, 以及实际使用的指令集
+    static Kernel getKernel(Conversion conversion, Isa isa, Isa *actualIsa = NULL);
+
+    static void convertPixels(Conversion conversion, const unsigned char *src, unsigned char *dst, size_t pixels);
+
+    // 按行距逐行转换, 图片较大且提供线程池时按行分块并行
+    static void convertImage(Conversion conversion, const unsigned char *src, size_t srcPitch, unsigned char *dst,
+                             size_t dstPitch, int width, int height, GLESThreadPool *pool = NULL);
+};
+
+
+#endif //GLES_DEMO_GLESPIXELCONVERT_H
@@ -0,0 +1,372 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESPlaylist.h"
+#include "GLESTrace.h"
+#include "GLESTextureLoader.h"
+
+#define DYNAMICGLES_NO_NAMESPACE
+#define DYNAMICEGL_NO_NAMESPACE
+
+#include <DynamicGles.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+
+GLESPlaylist::GLESPlaylist(GLESThreadPool &pool, GLESStateCache &stateCache)
+        : _pool(pool), _stateCache(stateCache) {
+}
+
+GLESPlaylist::~GLESPlaylist() {
+    // 没有机会调用release时至少停掉解码线程, 纹理随上下文销毁
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_all();
+    if (_decoder.joinable()) {
+        _decoder.join();
+    }
+}
+
+static bool isImageFile(const std::string &name) {
+    static const char *extensions[] = {".jpg", ".jpeg", ".png", ".bmp", ".tga", ".tif", ".tiff"};
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return (char) tolower(c); });
+    for (const char *extension : extensions) {
+        size_t length = strlen(extension);
+        if (lower.size() > length && lower.compare(lower.size() - length, length, extension) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 深度优先收集, 隐藏文件和目录跳过
+static void collectImages(const std::string &path, std::vector<std::string> &files) {
+    DIR *dir = opendir(path.c_str());
+    if (!dir) {
+        printf("Failed to open directory: %s\n", path.c_str());
+        return;
+    }
+    std::vector<std::string> entries;
+    while (struct dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            entries.push_back(path + "/" + entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(entries.begin(), entries.end());
+
+    for (const std::string &entry : entries) {
+        struct stat info;
+        if (stat(entry.c_str(), &info) != 0) {
+            continue;
+        }
+        if (S_ISDIR(info.st_mode)) {
+            collectImages(entry, files);
+        } else if (S_ISREG(info.st_mode) && isImageFile(entry)) {
+            files.push_back(entry);
+        }
+    }
+}
+
+size_t GLESPlaylist::addDirectory(const std::string &path) {
+    size_t before = _files.size();
+    collectImages(path, _files);
+    return _files.size() - before;
+}
+
+size_t GLESPlaylist::addPath(const std::string &path) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        printf("Playlist entry not found: %s\n", path.c_str());
+        return 0;
+    }
+    if (S_ISDIR(info.st_mode)) {
+        return addDirectory(path);
+    }
+    _files.push_back(path);
+    return 1;
+}
+
+size_t GLESPlaylist::getSize() const {
+    return _files.size();
+}
+
+void GLESPlaylist::setUseTextureStorage(bool useStorage) {
+    _useStorage = useStorage;
+}
+
+void GLESPlaylist::setTiming(double holdSeconds, double transitionSeconds) {
+    _holdSeconds = holdSeconds;
+    _transitionSeconds = transitionSeconds;
+}
+
+/**
+ * @MethodName: start
+ * @Return: 是否成功, 播放列表为空时失败
+ * @Description: 一次性分配slotCount个width x height的RGB纹理并清成黑色, 之后只更新内容; 然后启动解码线程
+ */
+bool GLESPlaylist::start(int slotCount, int width, int height) {
+    if (_files.empty() || width <= 0 || height <= 0) {
+        return false;
+    }
+    release();
+
+    _width = width;
+    _height = height;
+    _slots = std::vector<Slot>((size_t) std::max(2, slotCount));
+
+    std::vector<unsigned char> black((size_t) width * height * 3, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (Slot &slot : _slots) {
+        glGenTextures(1, &slot.texture);
+        _stateCache.bindTexture(GL_TEXTURE_2D, slot.texture);
+        if (_useStorage) {
+            glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGB8, width, height);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, black.data());
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, black.data());
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    if (glGetError() != GL_NO_ERROR) {
+        printf("Failed to allocate playlist textures\n");
+        release();
+        return false;
+    }
+
+    _current = 0;
+    _fillSlot = 0;
+    _nextFile = 0;
+    _stateStart = -1.0;
+    _transitioning = false;
+    _transitionTime = 0.0;
+    _shown = 0;
+    _stop = false;
+    _decoder = std::thread(&GLESPlaylist::decoderLoop, this);
+    return true;
+}
+
+/**
+ * @MethodName: decodeInto
+ * @Return: 解码是否成功
+ * @Description: 解码后等比缩放到槽位尺寸并居中, 空出的边缘为黑色; 尺寸一致时直接拷贝
+ */
+bool GLESPlaylist::decodeInto(const std::string &fileName, std::vector<unsigned char> &pixels) {
+    GLES_TRACE_SCOPE("playlist.decode");
+    // 只在解码线程使用, 像素缓冲在两次解码之间复用
+    static thread_local GLESImage decoded;
+    if (!GLESTextureLoader::decodeImage(fileName, decoded, &_pool)) {
+        return false;
+    }
+
+    size_t pitch = (size_t) _width * 3;
+    pixels.resize(pitch * _height);
+    if (decoded.width == _width && decoded.height == _height) {
+        memcpy(pixels.data(), decoded.pixels.data(), pixels.size());
+        return true;
+    }
+
+    double scale = std::min((double) _width / decoded.width, (double) _height / decoded.height);
+    int fitWidth = std::max(1, (int) (decoded.width * scale + 0.5));
+    int fitHeight = std::max(1, (int) (decoded.height * scale + 0.5));
+    int left = (_width - fitWidth) / 2;
+    int bottom = (_height - fitHeight) / 2;
+    std::fill(pixels.begin(), pixels.end(), 0);
+
+    // 双线性采样, 按行分块并行
+    const GLESImage &source = decoded;
+    unsigned char *target = pixels.data();
+    _pool.parallelFor(0, fitHeight, 32, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+            double sy = std::max(0.0, (y + 0.5) / scale - 0.5);
+            int y0 = std::min((int) sy, source.height - 1);
+            int y1 = std::min(y0 + 1, source.height - 1);
+            double fy = sy - y0;
+            unsigned char *row = target + (size_t) (bottom + y) * pitch + (size_t) left * 3;
+            for (int x = 0; x < fitWidth; ++x) {
+                double sx = std::max(0.0, (x + 0.5) / scale - 0.5);
+                int x0 = std::min((int) sx, source.width - 1);
+                int x1 = std::min(x0 + 1, source.width - 1);
+                double fx = sx - x0;
+                const unsigned char *p00 = &source.pixels[((size_t) y0 * source.width + x0) * 3];
+                const unsigned char *p01 = &source.pixels[((size_t) y0 * source.width + x1) * 3];
+                const unsigned char *p10 = &source.pixels[((size_t) y1 * source.width + x0) * 3];
+                const unsigned char *p11 = &source.pixels[((size_t) y1 * source.width + x1) * 3];
+                for (int c = 0; c < 3; ++c) {
+                    double top = p00[c] + (p01[c] - p00[c]) * fx;
+                    double down = p10[c] + (p11[c] - p10[c]) * fx;
+                    row[x * 3 + c] = (unsigned char) (top + (down - top) * fy + 0.5);
+                }
+            }
+        }
+    });
+    return true;
+}
+
+/**
+ * @MethodName: decoderLoop
+ * @Description: 按环的顺序等待空闲槽位, 解码播放列表中的下一张填进去; 解码失败的文件跳过
+ */
+void GLESPlaylist::decoderLoop() {
+    GLES_TRACE_THREAD_NAME("playlist decoder");
+    for (;;) {
+        Slot *slot = NULL;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]() { return _stop || _slots[_fillSlot].state == SLOT_FREE; });
+            if (_stop) {
+                return;
+            }
+            slot = &_slots[_fillSlot];
+            slot->state = SLOT_DECODING;
+        }
+
+        std::string fileName;
+        bool decoded = false;
+        for (size_t attempt = 0; attempt < _files.size() && !decoded; ++attempt) {
+            fileName = _files[_nextFile];
+            _nextFile = (_nextFile + 1) % _files.size();
+            decoded = decodeInto(fileName, slot->pixels);
+        }
+        if (!decoded) {
+            printf("Playlist: no decodable images left\n");
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            slot->fileName = fileName;
+            slot->state = SLOT_DECODED;
+        }
+        _fillSlot = (_fillSlot + 1) % (int) _slots.size();
+    }
+}
+
+void GLESPlaylist::uploadSlot(Slot &slot) {
+    GLES_TRACE_SCOPE("playlist.upload");
+    glPixelStorei(GL_UNPACK_ALIGNMENT, (_width * 3) % 4 == 0 ? 4 : 1);
+    _stateCache.bindTexture(GL_TEXTURE_2D, slot.texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _width, _height, GL_RGB, GL_UNSIGNED_BYTE, slot.pixels.data());
+}
+
+bool GLESPlaylist::slotResident(int index) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _slots[index].state == SLOT_RESIDENT;
+}
+
+/**
+ * @MethodName: update
+ * @Description: 每帧调用一次, time为秒. 按显示顺序上传最多一张已解码的图片;
+ *               停留时间到且下一张已上传时开始渐变, 渐变结束后当前槽位交还解码线程
+ */
+void GLESPlaylist::update(double time) {
+    if (_slots.empty()) {
+        return;
+    }
+    auto slotCount = (int) _slots.size();
+
+    Slot *decoded = NULL;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (int i = 0; i < slotCount && !decoded; ++i) {
+            Slot &slot = _slots[(_current + i) % slotCount];
+            if (slot.state == SLOT_DECODED) {
+                decoded = &slot;
+            }
+        }
+    }
+    if (decoded) {
+        // 解码线程只会写空闲槽位, 这里不用加锁
+        uploadSlot(*decoded);
+        std::lock_guard<std::mutex> lock(_mutex);
+        decoded->state = SLOT_RESIDENT;
+    }
+
+    if (_stateStart < 0.0) {
+        if (!slotResident(_current)) {
+            return;
+        }
+        _stateStart = time;
+        _shown = 1;
+    }
+
+    int next = (_current + 1) % slotCount;
+    if (!_transitioning) {
+        _transitionTime = 0.0;
+        if (time - _stateStart >= _holdSeconds && _files.size() > 1 && slotResident(next)) {
+            _transitioning = true;
+            _stateStart = time;
+        }
+    }
+    if (_transitioning) {
+        _transitionTime = time - _stateStart;
+        if (_transitionTime >= _transitionSeconds) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _slots[_current].state = SLOT_FREE;
+            }
+            _condition.notify_one();
+            _current = next;
+            _transitioning = false;
+            _transitionTime = 0.0;
+            _stateStart = time;
+            ++_shown;
+        }
+    }
+}
+
+bool GLESPlaylist::isActive() const {
+    return !_slots.empty();
+}
+
+bool GLESPlaylist::isReady() {
+    if (_slots.empty()) {
+        return false;
+    }
+    return slotResident(_current) && (_files.size() < 2 || slotResident((_current + 1) % (int) _slots.size()));
+}
+
+GLuint GLESPlaylist::getCurrentTexture() const {
+    return _slots.empty() ? 0 : _slots[_current].texture;
+}
+
+GLuint GLESPlaylist::getNextTexture() const {
+    return _slots.empty() ? 0 : _slots[(_current + 1) % _slots.size()].texture;
+}
+
+double GLESPlaylist::getTransitionTime() const {
+    return _transitionTime;
+}
+
+uint64_t GLESPlaylist::getShownCount() const {
+    return _shown;
+}
+
+/**
+ * @MethodName: release
+ * @Description: 停止解码线程并删除槽位纹理, 播放列表本身保留, 可以再次start
+ */
+void GLESPlaylist::release() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_all();
+    if (_decoder.joinable()) {
+        _decoder.join();
+    }
+    for (Slot &slot : _slots) {
+        _stateCache.deleteTextures(1, &slot.texture);
+    }
+    _slots.clear();
+}
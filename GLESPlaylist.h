@@ -0,0 +1,118 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESPLAYLIST_H
+#define GLES_DEMO_GLESPLAYLIST_H
+
+#include <GLES3/gl32.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GLESStateCache.h"
+#include "GLESThreadPool.h"
+
+/**
+ * 流式幻灯片: 播放列表可以有任意多张图片, 显存中只保留固定个数的纹理槽位组成的环.
+ * 解码线程按播放顺序把后面的图片解码并缩放到槽位尺寸, GL线程每帧最多上传一张,
+ * 用glTexSubImage2D复用槽位的存储, 显存和内存占用与列表长度无关.
+ * 下一张还没上传完时继续停留在当前图片, 切换不会因为加载而卡顿.
+ * 除add*外的方法都必须在GL线程调用.
+ */
+class GLESPlaylist {
+public:
+    GLESPlaylist(GLESThreadPool &pool, GLESStateCache &stateCache);
+
+    ~GLESPlaylist();
+
+    GLESPlaylist(const GLESPlaylist &) = delete;
+
+    GLESPlaylist &operator=(const GLESPlaylist &) = delete;
+
+    // 递归加入目录下的图片(按路径排序), 返回加入的个数
+    size_t addDirectory(const std::string &path);
+
+    // 目录或单个文件
+    size_t addPath(const std::string &path);
+
+    size_t getSize() const;
+
+    // GLES3下用glTexStorage2D分配不可变存储
+    void setUseTextureStorage(bool useStorage);
+
+    // 每张图停留和渐变的秒数
+    void setTiming(double holdSeconds, double transitionSeconds);
+
+    bool start(int slotCount, int width, int height);
+
+    void update(double time);
+
+    bool isActive() const;
+
+    // 当前和下一张都已上传
+    bool isReady();
+
+    GLuint getCurrentTexture() const;
+
+    GLuint getNextTexture() const;
+
+    // 当前渐变已经进行的秒数, 停留阶段为0
+    double getTransitionTime() const;
+
+    uint64_t getShownCount() const;
+
+    void release();
+
+private:
+    enum SlotState {
+        SLOT_FREE = 0,
+        SLOT_DECODING,
+        SLOT_DECODED,
+        SLOT_RESIDENT
+    };
+
+    struct Slot {
+        GLuint texture = 0;
+        SlotState state = SLOT_FREE;
+        std::string fileName;
+        // 已经缩放到槽位尺寸的RGB像素, 反复复用
+        std::vector<unsigned char> pixels;
+    };
+
+    void decoderLoop();
+
+    bool decodeInto(const std::string &fileName, std::vector<unsigned char> &pixels);
+
+    void uploadSlot(Slot &slot);
+
+    bool slotResident(int index);
+
+    GLESThreadPool &_pool;
+    GLESStateCache &_stateCache;
+    std::vector<std::string> _files;
+    bool _useStorage = false;
+    double _holdSeconds = 3.0;
+    double _transitionSeconds = 1.0;
+    int _width = 0;
+    int _height = 0;
+
+    // 槽位环: GL线程从_current开始按顺序显示, 解码线程从_fillSlot开始按顺序填充
+    std::vector<Slot> _slots;
+    int _current = 0;
+    int _fillSlot = 0;
+    size_t _nextFile = 0;
+    double _stateStart = -1.0;
+    bool _transitioning = false;
+    double _transitionTime = 0.0;
+    uint64_t _shown = 0;
+
+    std::thread _decoder;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _stop = false;
+};
+
+
+#endif //GLES_DEMO_GLESPLAYLIST_H
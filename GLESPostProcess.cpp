@@ -0,0 +1,191 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESPostProcess.h"
+#include "GLESTrace.h"
+
+#define DYNAMICGLES_NO_NAMESPACE
+#define DYNAMICEGL_NO_NAMESPACE
+
+#include <DynamicGles.h>
+#include <cstdio>
+#include <utility>
+
+GLESPostProcess::GLESPostProcess(GLESStateCache &stateCache, GLESRenderTargetPool &pool)
+        : _stateCache(stateCache), _pool(pool) {
+}
+
+/**
+ * @MethodName: init
+ * @Return: 所有pass是否都创建成功
+ * @Description: blur按半径换算成纹素步长, 拆成水平和竖直两个pass; grade的参数直接作为uniform
+ */
+bool GLESPostProcess::init(const GLESSceneConfig &config, GLESShaderPreprocessor &preprocessor, int width,
+                           int height) {
+    GLES_TRACE_SCOPE("initPostProcess");
+    release();
+    _width = width;
+    _height = height;
+
+    GLESShaderPreprocessor::Defines defines = {{"PRECISION", config.precision}};
+    std::string vshStr;
+    if (!preprocessor.load(config.postVshPath, defines, vshStr)) {
+        return false;
+    }
+    for (const std::string &name : config.postPasses) {
+        std::string fshStr;
+        if (name == "blur") {
+            if (!preprocessor.load(config.blurFshPath, defines, fshStr)) {
+                release();
+                return false;
+            }
+            int horizontal = addPass("blur horizontal", vshStr, fshStr);
+            int vertical = addPass("blur vertical", vshStr, fshStr);
+            if (horizontal < 0 || vertical < 0) {
+                release();
+                return false;
+            }
+            int horizontalUniform = getProgram(horizontal).findUniform("direction");
+            int verticalUniform = getProgram(vertical).findUniform("direction");
+            auto stepX = (GLfloat) (config.blurRadius / (float) width);
+            auto stepY = (GLfloat) (config.blurRadius / (float) height);
+            setSetup(horizontal, [horizontalUniform, stepX](GLESProgram &program) {
+                program.setUniform2f(horizontalUniform, stepX, 0.0f);
+            });
+            setSetup(vertical, [verticalUniform, stepY](GLESProgram &program) {
+                program.setUniform2f(verticalUniform, 0.0f, stepY);
+            });
+        } else if (name == "grade") {
+            if (!preprocessor.load(config.gradeFshPath, defines, fshStr)) {
+                release();
+                return false;
+            }
+            int pass = addPass("grade", vshStr, fshStr);
+            if (pass < 0) {
+                release();
+                return false;
+            }
+            GLESProgram &gradeProgram = getProgram(pass);
+            int exposureUniform = gradeProgram.findUniform("exposure");
+            int contrastUniform = gradeProgram.findUniform("contrast");
+            int saturationUniform = gradeProgram.findUniform("saturation");
+            float exposure = config.gradeExposure;
+            float contrast = config.gradeContrast;
+            float saturation = config.gradeSaturation;
+            setSetup(pass, [=](GLESProgram &program) {
+                program.setUniform1f(exposureUniform, exposure);
+                program.setUniform1f(contrastUniform, contrast);
+                program.setUniform1f(saturationUniform, saturation);
+            });
+        } else {
+            printf("Unknown post pass: %s\n", name.c_str());
+            release();
+            return false;
+        }
+    }
+    return true;
+}
+
+int GLESPostProcess::addPass(const std::string &name, const std::string &vshSource, const std::string &fshSource) {
+    std::unique_ptr<Pass> pass(new Pass(_stateCache));
+    pass->name = name;
+    GLuint vertexShader = GLESProgram::compileShader(GL_VERTEX_SHADER, vshSource);
+    GLuint fragmentShader = GLESProgram::compileShader(GL_FRAGMENT_SHADER, fshSource);
+    bool linked = vertexShader && fragmentShader &&
+                  pass->program.link(vertexShader, fragmentShader, std::vector<std::pair<GLuint, std::string> >());
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    if (!linked) {
+        printf("Failed to create post pass: %s\n", name.c_str());
+        return -1;
+    }
+    pass->samplerUniform = pass->program.findUniform("s_input");
+    _passes.push_back(std::move(pass));
+    return (int) _passes.size() - 1;
+}
+
+void GLESPostProcess::setSetup(int pass, Setup setup) {
+    _passes[pass]->setup = std::move(setup);
+}
+
+GLESProgram &GLESPostProcess::getProgram(int pass) {
+    return _passes[pass]->program;
+}
+
+bool GLESPostProcess::isEnabled() const {
+    return !_passes.empty();
+}
+
+int GLESPostProcess::getPassCount() const {
+    return (int) _passes.size();
+}
+
+GLuint GLESPostProcess::beginScene() {
+    if (_sceneTarget < 0) {
+        _sceneTarget = _pool.acquire(_width, _height, GL_RGBA8);
+        if (_sceneTarget < 0) {
+            return 0;
+        }
+    }
+    GLuint framebuffer = _pool.get(_sceneTarget).framebuffer;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    _stateCache.viewport(0, 0, _width, _height);
+    return framebuffer;
+}
+
+GLuint GLESPostProcess::getSceneFramebuffer() const {
+    return _sceneTarget < 0 ? 0 : _pool.get(_sceneTarget).framebuffer;
+}
+
+/**
+ * @MethodName: run
+ * @Return: 所有pass是否都执行了
+ * @Description: 每个pass先取输出目标再放回输入, 相邻两个pass的输入和输出不会是同一个目标;
+ *               程序切回场景的程序, 下一帧场景不会因为程序切换被当成有变化
+ */
+bool GLESPostProcess::run() {
+    if (!isEnabled() || _sceneTarget < 0) {
+        return false;
+    }
+    GLuint sceneProgram = _stateCache.getProgram();
+    int input = _sceneTarget;
+    _sceneTarget = -1;
+    bool completed = true;
+    for (size_t i = 0; i < _passes.size(); ++i) {
+        Pass &pass = *_passes[i];
+        bool last = i + 1 == _passes.size();
+        int output = last ? -1 : _pool.acquire(_width, _height, GL_RGBA8);
+        if (!last && output < 0) {
+            completed = false;
+            break;
+        }
+
+        // 整个目标都会被覆盖, 原有内容不必载入
+        glBindFramebuffer(GL_FRAMEBUFFER, last ? 0 : _pool.get(output).framebuffer);
+        const GLenum attachment = last ? GL_COLOR : GL_COLOR_ATTACHMENT0;
+        _pool.invalidate(1, &attachment);
+        _stateCache.viewport(0, 0, _width, _height);
+
+        pass.program.use();
+        _stateCache.bindTextureUnit(GLESRenderTargetPool::TEXTURE_UNIT, GL_TEXTURE_2D, _pool.get(input).texture);
+        pass.program.setUniform1i(pass.samplerUniform, (GLint) GLESRenderTargetPool::TEXTURE_UNIT);
+        if (pass.setup) {
+            pass.setup(pass.program);
+        }
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        // 输入已经读完, 后面的pass可以复用
+        _pool.release(input);
+        input = output;
+    }
+    _pool.release(input);
+    _stateCache.useProgram(sceneProgram);
+    return completed;
+}
+
+void GLESPostProcess::release() {
+    _pool.release(_sceneTarget);
+    _sceneTarget = -1;
+    _passes.clear();
+}
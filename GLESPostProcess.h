@@ -0,0 +1,81 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESPOSTPROCESS_H
+#define GLES_DEMO_GLESPOSTPROCESS_H
+
+#include <GLES3/gl32.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "GLESProgram.h"
+#include "GLESRenderTargetPool.h"
+#include "GLESSceneConfig.h"
+#include "GLESShaderPreprocessor.h"
+
+/**
+ * 后处理: 场景(过渡)先画到池中的离屏目标, 再依次经过各个全屏pass, 最后一个pass直接画到默认帧缓冲.
+ * 每个pass采样上一个pass的输出(s_input), 写入从池中新取的目标; 输入读完后立即放回池中,
+ * 所以不论pass有多少个, 同一时刻最多占用两个目标, 帧与帧之间也是同样的两个.
+ * pass都画满整个目标, 画之前丢弃目标原有的内容, 不从显存载入.
+ * 内置的pass: blur(可分离高斯, 水平和竖直各一个pass)、grade(曝光、对比度、饱和度). 需要GLES3.
+ */
+class GLESPostProcess {
+public:
+    // 每帧绘制前调用, 设置pass自己的uniform; 程序已经是当前程序
+    typedef std::function<void(GLESProgram &program)> Setup;
+
+    GLESPostProcess(GLESStateCache &stateCache, GLESRenderTargetPool &pool);
+
+    // 按config.postPasses依次添加内置的pass, 名字未知或着色器编译失败时返回false
+    bool init(const GLESSceneConfig &config, GLESShaderPreprocessor &preprocessor, int width, int height);
+
+    // 添加一个全屏pass, 返回编号, 失败时返回-1; 片元着色器从s_input采样上一个pass的输出
+    int addPass(const std::string &name, const std::string &vshSource, const std::string &fshSource);
+
+    void setSetup(int pass, Setup setup);
+
+    GLESProgram &getProgram(int pass);
+
+    bool isEnabled() const;
+
+    int getPassCount() const;
+
+    // 取本帧的场景目标(已经取过时直接返回)并绑定, 视口为整个窗口; 失败时返回0
+    GLuint beginScene();
+
+    // 本帧的场景目标, 还没有取时为0(默认帧缓冲)
+    GLuint getSceneFramebuffer() const;
+
+    /**
+     * 从场景目标开始依次执行所有pass, 最后一个输出到默认帧缓冲; 之后恢复原来的程序
+     * 返回是否执行完, 中途取不到目标时返回false
+     */
+    bool run();
+
+    void release();
+
+private:
+    struct Pass {
+        explicit Pass(GLESStateCache &stateCache) : program(stateCache) {}
+
+        std::string name;
+        GLESProgram program;
+        int samplerUniform = -1;
+        Setup setup;
+    };
+
+    GLESStateCache &_stateCache;
+    GLESRenderTargetPool &_pool;
+    // GLESProgram不能复制, pass按指针保存
+    std::vector<std::unique_ptr<Pass> > _passes;
+    int _width = 0;
+    int _height = 0;
+    // 本帧场景目标的句柄, 没有时为-1
+    int _sceneTarget = -1;
+};
+
+
+#endif //GLES_DEMO_GLESPOSTPROCESS_H
@@ -0,0 +1,336 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESProgram.h"
+#include "GLESTrace.h"
+
+#define DYNAMICGLES_NO_NAMESPACE
+#define DYNAMICEGL_NO_NAMESPACE
+
+#include <DynamicGles.h>
+#include <cstdio>
+#include <cstring>
+
+// 每种uniform类型的32位分量个数
+static int uniformComponents(GLenum type) {
+    switch (type) {
+        case GL_FLOAT_VEC2:
+        case GL_INT_VEC2:
+        case GL_BOOL_VEC2:
+            return 2;
+        case GL_FLOAT_VEC3:
+        case GL_INT_VEC3:
+        case GL_BOOL_VEC3:
+            return 3;
+        case GL_FLOAT_VEC4:
+        case GL_INT_VEC4:
+        case GL_BOOL_VEC4:
+        case GL_FLOAT_MAT2:
+            return 4;
+        case GL_FLOAT_MAT3:
+            return 9;
+        case GL_FLOAT_MAT4:
+            return 16;
+        default:
+            return 1;
+    }
+}
+
+// 数组变量反射出来的名字是"name[0]", 去掉后缀后也要能查到
+static std::string baseName(const std::string &name) {
+    size_t pos = name.find('[');
+    return pos == std::string::npos ? name : name.substr(0, pos);
+}
+
+GLESProgram::GLESProgram(GLESStateCache &stateCache) : _stateCache(stateCache) {
+}
+
+GLuint GLESProgram::compileShader(GLenum type, const std::string &source) {
+    GLuint shader = glCreateShader(type);
+    const char *text = source.c_str();
+    glShaderSource(shader, 1, &text, NULL);
+    glCompileShader(shader);
+    GLint compiled = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled) {
+        char infoLog[512] = {0};
+        glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+        printf("Failed to compile %s shader: %s\n", type == GL_VERTEX_SHADER ? "vertex" : "fragment", infoLog);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// 设为当前程序, 已经是当前程序时不再提交
+void GLESProgram::use() {
+    _stateCache.useProgram(_program);
+}
+
+/**
+ * @MethodName: link
+ * @Return: 链接是否成功
+ * @Description: 链接着色器并反射所有active的attribute和uniform
+ */
+bool GLESProgram::link(GLuint vertexShader, GLuint fragmentShader,
+                       const std::vector<std::pair<GLuint, std::string> > &attribBindings) {
+    release();
+
+    // Create the shader program
+    _program = glCreateProgram();
+
+    // Attach the fragment and vertex shaders to it
+    glAttachShader(_program, fragmentShader);
+    glAttachShader(_program, vertexShader);
+
+    // 固定属性位置, 必须在链接之前设置
+    for (const auto &binding : attribBindings) {
+        glBindAttribLocation(_program, binding.first, binding.second.c_str());
+    }
+    if (_binaryRetrievable) {
+        glProgramParameteri(_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // Link the program
+    // 驱动可能推迟到查询链接状态时才真正编译, 两者一起计时
+    GLint isLinked;
+    {
+        GLES_TRACE_SCOPE("glLinkProgram");
+        glLinkProgram(_program);
+
+        // Check if linking succeeded in the same way we checked for compilation success
+        glGetProgramiv(_program, GL_LINK_STATUS, &isLinked);
+    }
+    if (!isLinked) {
+        // If an error happened, first retrieve the length of the log message
+        int infoLogLength, charactersWritten;
+        glGetProgramiv(_program, GL_INFO_LOG_LENGTH, &infoLogLength);
+
+        // Allocate enough space for the message and retrieve it
+        std::vector<char> infoLog;
+        infoLog.resize(infoLogLength);
+        glGetProgramInfoLog(_program, infoLogLength, &charactersWritten, infoLog.data());
+
+        // Display the error in a dialog box
+        infoLogLength > 1 ? printf("%s", infoLog.data()) : printf("Failed to link shader program.");
+        return false;
+    }
+
+    reflect();
+    return true;
+}
+
+/**
+ * @MethodName: loadBinary
+ * @Return: 驱动是否接受该二进制
+ * @Description: 从程序缓存加载, 属性位置已经包含在二进制里; 驱动升级等原因被拒绝时返回false, 由调用方回退到源码编译
+ */
+bool GLESProgram::loadBinary(GLenum binaryFormat, const void *binary, GLsizei size) {
+    release();
+
+    _program = glCreateProgram();
+    glProgramBinary(_program, binaryFormat, binary, size);
+
+    GLint isLinked = GL_FALSE;
+    glGetProgramiv(_program, GL_LINK_STATUS, &isLinked);
+    if (!isLinked) {
+        // 被拒绝属于正常情况, 清掉错误状态, 不影响之后的testGLError
+        while (glGetError() != GL_NO_ERROR) {}
+        release();
+        return false;
+    }
+
+    reflect();
+    return true;
+}
+
+/**
+ * @MethodName: getBinary
+ * @Return: 是否取到二进制
+ */
+bool GLESProgram::getBinary(GLenum &binaryFormat, std::vector<unsigned char> &binary) const {
+    GLint length = 0;
+    if (_program) {
+        glGetProgramiv(_program, GL_PROGRAM_BINARY_LENGTH, &length);
+    }
+    if (length <= 0) {
+        return false;
+    }
+    binary.resize((size_t) length);
+    GLsizei written = 0;
+    glGetProgramBinary(_program, length, &written, &binaryFormat, binary.data());
+    binary.resize(written > 0 ? (size_t) written : 0);
+    return !binary.empty();
+}
+
+void GLESProgram::setBinaryRetrievable(bool retrievable) {
+    _binaryRetrievable = retrievable;
+}
+
+/**
+ * @MethodName: reflect
+ * @Description: 通过glGetActiveAttrib/glGetActiveUniform建立名字到句柄的查找表, 帧内不再做字符串查询
+ */
+void GLESProgram::reflect() {
+    GLint count = 0, maxLength = 0;
+    GLsizei length = 0;
+
+    glGetProgramiv(_program, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(_program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+    std::vector<char> nameBuffer(maxLength > 0 ? maxLength : 1);
+    for (GLint i = 0; i < count; ++i) {
+        GLESShaderVariable attrib;
+        glGetActiveAttrib(_program, i, (GLsizei) nameBuffer.size(), &length, &attrib.size, &attrib.type,
+                          nameBuffer.data());
+        attrib.name.assign(nameBuffer.data(), length);
+        attrib.location = glGetAttribLocation(_program, attrib.name.c_str());
+        _attribIndex[attrib.name] = (int) _attribs.size();
+        _attribs.push_back(attrib);
+    }
+
+    glGetProgramiv(_program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    nameBuffer.resize(maxLength > 0 ? maxLength : 1);
+    int cacheSize = 0;
+    for (GLint i = 0; i < count; ++i) {
+        GLESShaderVariable uniform;
+        glGetActiveUniform(_program, i, (GLsizei) nameBuffer.size(), &length, &uniform.size, &uniform.type,
+                           nameBuffer.data());
+        uniform.name.assign(nameBuffer.data(), length);
+        uniform.location = glGetUniformLocation(_program, uniform.name.c_str());
+        uniform.cacheOffset = cacheSize;
+        uniform.cacheCount = uniform.size * uniformComponents(uniform.type);
+        cacheSize += uniform.cacheCount;
+
+        int index = (int) _uniforms.size();
+        _uniformIndex[uniform.name] = index;
+        _uniformIndex[baseName(uniform.name)] = index;
+        _uniforms.push_back(uniform);
+    }
+    _uniformCache.assign(cacheSize, 0);
+}
+
+void GLESProgram::release() {
+    if (_program) {
+        _stateCache.deleteProgram(_program);
+        _program = 0;
+    }
+    _attribs.clear();
+    _uniforms.clear();
+    _attribIndex.clear();
+    _uniformIndex.clear();
+    _uniformCache.clear();
+}
+
+GLuint GLESProgram::getProgram() const {
+    return _program;
+}
+
+int GLESProgram::findAttrib(const std::string &name) const {
+    auto it = _attribIndex.find(name);
+    return it == _attribIndex.end() ? -1 : it->second;
+}
+
+int GLESProgram::findUniform(const std::string &name) const {
+    auto it = _uniformIndex.find(name);
+    return it == _uniformIndex.end() ? -1 : it->second;
+}
+
+GLint GLESProgram::getAttribLocation(const std::string &name) const {
+    int handle = findAttrib(name);
+    return handle < 0 ? -1 : _attribs[handle].location;
+}
+
+GLint GLESProgram::getUniformLocation(const std::string &name) const {
+    int handle = findUniform(name);
+    return handle < 0 ? -1 : _uniforms[handle].location;
+}
+
+const std::vector<GLESShaderVariable> &GLESProgram::getAttribs() const {
+    return _attribs;
+}
+
+const std::vector<GLESShaderVariable> &GLESProgram::getUniforms() const {
+    return _uniforms;
+}
+
+/**
+ * @MethodName: updateCache
+ * @Return: 值是否有变化, 没变化就不需要提交
+ * @Description: 比较并更新影子缓存
+ */
+bool GLESProgram::updateCache(GLESShaderVariable &uniform, const void *values, int count) {
+    GLuint *cached = &_uniformCache[uniform.cacheOffset];
+    size_t bytes = count * sizeof(GLuint);
+    if (uniform.cacheValid && memcmp(cached, values, bytes) == 0) {
+        _stateCache.countCall(false);
+        return false;
+    }
+    memcpy(cached, values, bytes);
+    uniform.cacheValid = true;
+    _stateCache.countCall(true);
+    return true;
+}
+
+bool GLESProgram::setUniform1f(int handle, GLfloat value) {
+    if (handle < 0) { return false; }
+    GLESShaderVariable &uniform = _uniforms[handle];
+    if (!updateCache(uniform, &value, 1)) { return false; }
+    glUniform1f(uniform.location, value);
+    return true;
+}
+
+bool GLESProgram::setUniform2f(int handle, GLfloat x, GLfloat y) {
+    if (handle < 0) { return false; }
+    GLESShaderVariable &uniform = _uniforms[handle];
+    GLfloat values[] = {x, y};
+    if (!updateCache(uniform, values, 2)) { return false; }
+    glUniform2f(uniform.location, x, y);
+    return true;
+}
+
+bool GLESProgram::setUniform4f(int handle, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+    if (handle < 0) { return false; }
+    GLESShaderVariable &uniform = _uniforms[handle];
+    GLfloat values[] = {x, y, z, w};
+    if (!updateCache(uniform, values, 4)) { return false; }
+    glUniform4f(uniform.location, x, y, z, w);
+    return true;
+}
+
+bool GLESProgram::setUniform1i(int handle, GLint value) {
+    if (handle < 0) { return false; }
+    GLESShaderVariable &uniform = _uniforms[handle];
+    if (!updateCache(uniform, &value, 1)) { return false; }
+    glUniform1i(uniform.location, value);
+    return true;
+}
+
+bool GLESProgram::setUniform1iv(int handle, GLsizei count, const GLint *values) {
+    if (handle < 0) { return false; }
+    GLESShaderVariable &uniform = _uniforms[handle];
+    // 编译器可能裁掉数组中没用到的元素, 只提交active的部分
+    if (count > uniform.cacheCount) { count = uniform.cacheCount; }
+    if (!updateCache(uniform, values, count)) { return false; }
+    glUniform1iv(uniform.location, count, values);
+    return true;
+}
+
+bool GLESProgram::setUniformMatrix4fv(int handle, const GLfloat *values) {
+    if (handle < 0) { return false; }
+    GLESShaderVariable &uniform = _uniforms[handle];
+    if (!updateCache(uniform, values, 16)) { return false; }
+    glUniformMatrix4fv(uniform.location, 1, GL_FALSE, values);
+    return true;
+}
+
+/**
+ * @MethodName: invalidateUniformCache
+ * @Description: 在外部绕过本类修改了uniform时调用, 下次设置一定会提交
+ */
+void GLESProgram::invalidateUniformCache() {
+    for (GLESShaderVariable &uniform : _uniforms) {
+        uniform.cacheValid = false;
+    }
+}
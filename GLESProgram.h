@@ -0,0 +1,98 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESPROGRAM_H
+#define GLES_DEMO_GLESPROGRAM_H
+
+#include <GLES3/gl32.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "GLESStateCache.h"
+
+// 链接后反射出的attribute/uniform信息
+struct GLESShaderVariable {
+    std::string name;
+    GLint location = -1;
+    GLenum type = 0;
+    GLint size = 0;
+    // uniform在影子缓存中的起始位置和分量个数(size * 每个元素的分量数)
+    int cacheOffset = 0;
+    int cacheCount = 0;
+    bool cacheValid = false;
+};
+
+/**
+ * 着色器程序: 链接后一次性反射所有active变量, 帧内通过句柄(数组下标)访问,
+ * uniform值与影子缓存相同时不再提交.
+ * 所有setUniform*都要求该程序已经是当前程序; 提交和省掉的uniform调用记在状态缓存的计数里.
+ */
+class GLESProgram {
+public:
+    explicit GLESProgram(GLESStateCache &stateCache);
+
+    // 编译单个着色器, 失败时打印日志并返回0
+    static GLuint compileShader(GLenum type, const std::string &source);
+
+    void use();
+
+    bool link(GLuint vertexShader, GLuint fragmentShader,
+              const std::vector<std::pair<GLuint, std::string> > &attribBindings);
+
+    bool loadBinary(GLenum binaryFormat, const void *binary, GLsizei size);
+
+    bool getBinary(GLenum &binaryFormat, std::vector<unsigned char> &binary) const;
+
+    void setBinaryRetrievable(bool retrievable);
+
+    void release();
+
+    GLuint getProgram() const;
+
+    int findAttrib(const std::string &name) const;
+
+    int findUniform(const std::string &name) const;
+
+    GLint getAttribLocation(const std::string &name) const;
+
+    GLint getUniformLocation(const std::string &name) const;
+
+    const std::vector<GLESShaderVariable> &getAttribs() const;
+
+    const std::vector<GLESShaderVariable> &getUniforms() const;
+
+    bool setUniform1f(int handle, GLfloat value);
+
+    bool setUniform2f(int handle, GLfloat x, GLfloat y);
+
+    bool setUniform4f(int handle, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+
+    bool setUniform1i(int handle, GLint value);
+
+    bool setUniform1iv(int handle, GLsizei count, const GLint *values);
+
+    bool setUniformMatrix4fv(int handle, const GLfloat *values);
+
+    void invalidateUniformCache();
+
+private:
+    void reflect();
+
+    bool updateCache(GLESShaderVariable &uniform, const void *values, int count);
+
+    GLESStateCache &_stateCache;
+    GLuint _program = 0;
+    // GLES3: 链接前提示驱动保留二进制, 供程序缓存读取
+    bool _binaryRetrievable = false;
+    std::vector<GLESShaderVariable> _attribs;
+    std::vector<GLESShaderVariable> _uniforms;
+    std::unordered_map<std::string, int> _attribIndex;
+    std::unordered_map<std::string, int> _uniformIndex;
+    // uniform影子缓存, float和int都按32位保存
+    std::vector<GLuint> _uniformCache;
+};
+
+
+#endif //GLES_DEMO_GLESPROGRAM_H
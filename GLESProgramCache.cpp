@@ -0,0 +1,134 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESProgramCache.h"
+#include "GLESTrace.h"
+#include "GLESHash.h"
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+// 缓存文件头, 之后依次是键和程序二进制
+struct ProgramCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t binaryFormat;
+    uint32_t keySize;
+    uint32_t binarySize;
+};
+
+static const char programCacheMagic[4] = {'G', 'L', 'P', 'B'};
+static const uint32_t programCacheVersion = 1;
+
+void GLESProgramCache::setCacheDir(const std::string &cacheDir) {
+    _cacheDir = cacheDir;
+}
+
+const std::string &GLESProgramCache::getCacheDir() const {
+    return _cacheDir;
+}
+
+unsigned GLESProgramCache::getHitCount() const {
+    return _hits.load();
+}
+
+unsigned GLESProgramCache::getMissCount() const {
+    return _misses.load();
+}
+
+/**
+ * @MethodName: makeKey
+ * @Return: 缓存键, 驱动字符串原样保留便于排查, 源码部分取哈希
+ */
+std::string GLESProgramCache::makeKey(const std::string &driver, const std::vector<std::string> &sources) {
+    uint64_t hash = GLES_HASH_SEED;
+    for (const std::string &source : sources) {
+        hash = hashString(source, hash);
+    }
+    return driver + "|" + hashToHex(hash);
+}
+
+std::string GLESProgramCache::getCachePath(const std::string &key) const {
+    return _cacheDir + "/" + hashToHex(hashString(key)) + ".bin";
+}
+
+/**
+ * @MethodName: load
+ * @Return: 是否命中
+ * @Description: 校验文件头、版本和完整的键, 任何不一致都当作未命中
+ */
+bool GLESProgramCache::load(const std::string &key, GLenum &binaryFormat, std::vector<unsigned char> &binary) {
+    GLES_TRACE_SCOPE("programCache.load");
+    std::string cachePath = getCachePath(key);
+    FILE *file = fopen(cachePath.c_str(), "rb");
+    if (!file) {
+        ++_misses;
+        return false;
+    }
+
+    ProgramCacheHeader header;
+    std::string storedKey;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                 memcmp(header.magic, programCacheMagic, sizeof(programCacheMagic)) == 0 &&
+                 header.version == programCacheVersion &&
+                 header.keySize == key.size() && header.binarySize > 0;
+    if (valid) {
+        storedKey.resize(header.keySize);
+        binary.resize(header.binarySize);
+        valid = fread(&storedKey[0], header.keySize, 1, file) == 1 && storedKey == key &&
+                fread(binary.data(), header.binarySize, 1, file) == 1;
+    }
+    fclose(file);
+
+    if (!valid) {
+        printf("Ignoring invalid program cache file: %s\n", cachePath.c_str());
+        binary.clear();
+        ++_misses;
+        return false;
+    }
+    binaryFormat = header.binaryFormat;
+    ++_hits;
+    return true;
+}
+
+/**
+ * @MethodName: store
+ * @Return: 是否写入成功
+ * @Description: 先写临时文件再rename, 多个进程同时启动也不会读到写了一半的文件
+ */
+bool GLESProgramCache::store(const std::string &key, GLenum binaryFormat, const std::vector<unsigned char> &binary) {
+    if (binary.empty()) {
+        return false;
+    }
+    ProgramCacheHeader header;
+    memcpy(header.magic, programCacheMagic, sizeof(programCacheMagic));
+    header.version = programCacheVersion;
+    header.binaryFormat = binaryFormat;
+    header.keySize = (uint32_t) key.size();
+    header.binarySize = (uint32_t) binary.size();
+
+    std::string cachePath = getCachePath(key);
+    mkdir(_cacheDir.c_str(), 0755);
+    std::string tmpPath = cachePath + ".tmp." + std::to_string(getpid()) + "." +
+                          std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    FILE *file = fopen(tmpPath.c_str(), "wb");
+    if (!file) {
+        printf("Failed to write program cache: %s\n", tmpPath.c_str());
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(key.data(), key.size(), 1, file) == 1 &&
+                   fwrite(binary.data(), binary.size(), 1, file) == 1;
+    written = fclose(file) == 0 && written;
+    if (!written || rename(tmpPath.c_str(), cachePath.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        printf("Failed to write program cache: %s\n", cachePath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,44 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESPROGRAMCACHE_H
+#define GLES_DEMO_GLESPROGRAMCACHE_H
+
+#include <GLES3/gl32.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+/**
+ * 着色器程序二进制的磁盘缓存: 链接成功后用glGetProgramBinary取出二进制保存, 下次启动用glProgramBinary直接加载,
+ * 跳过GLSL编译和链接. 键由着色器源码(含宏定义)、属性绑定以及驱动的厂商/渲染器/版本字符串组成,
+ * 任何一项变化都会换一个缓存文件; 驱动拒绝加载时调用方回退到源码编译.
+ * load/store只做文件操作, 不调用GL.
+ */
+class GLESProgramCache {
+public:
+    void setCacheDir(const std::string &cacheDir);
+
+    const std::string &getCacheDir() const;
+
+    static std::string makeKey(const std::string &driver, const std::vector<std::string> &sources);
+
+    bool load(const std::string &key, GLenum &binaryFormat, std::vector<unsigned char> &binary);
+
+    bool store(const std::string &key, GLenum binaryFormat, const std::vector<unsigned char> &binary);
+
+    unsigned getHitCount() const;
+
+    unsigned getMissCount() const;
+
+private:
+    std::string getCachePath(const std::string &key) const;
+
+    std::string _cacheDir = "program_cache";
+    std::atomic<unsigned> _hits{0};
+    std::atomic<unsigned> _misses{0};
+};
+
+
+#endif //GLES_DEMO_GLESPROGRAMCACHE_H
@@ -0,0 +1,181 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESRenderTargetPool.h"
+#include "GLESTrace.h"
+
+#define DYNAMICGLES_NO_NAMESPACE
+#define DYNAMICEGL_NO_NAMESPACE
+
+#include <DynamicGles.h>
+#include <algorithm>
+
+GLESRenderTargetPool::GLESRenderTargetPool(GLESStateCache &stateCache) : _stateCache(stateCache) {
+}
+
+void GLESRenderTargetPool::setCaps(bool invalidateFramebuffer, bool discardFramebuffer) {
+    _invalidateFramebuffer = invalidateFramebuffer;
+    _discardFramebuffer = discardFramebuffer;
+}
+
+size_t GLESRenderTargetPool::getBytesPerPixel(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_R8:
+            return 1;
+        case GL_RG8:
+        case GL_RGB565:
+        case GL_R16F:
+            return 2;
+        case GL_RGB8:
+            return 3;
+        case GL_RGBA16F:
+            return 8;
+        default:
+            return 4;
+    }
+}
+
+/**
+ * @MethodName: acquire
+ * @Return: 渲染目标句柄, 失败时为-1
+ * @Description: 优先取大小和格式都相同的空闲目标, 没有时在空位或末尾创建
+ */
+int GLESRenderTargetPool::acquire(int width, int height, GLenum internalFormat) {
+    _stats.acquires++;
+    int freeSlot = -1;
+    for (int i = 0; i < (int) _entries.size(); ++i) {
+        Entry &entry = _entries[i];
+        if (!entry.target.framebuffer) {
+            freeSlot = freeSlot < 0 ? i : freeSlot;
+            continue;
+        }
+        if (!entry.inUse && entry.target.width == width && entry.target.height == height &&
+            entry.target.format == internalFormat) {
+            _stats.reuses++;
+            entry.inUse = true;
+            entry.lastUsedFrame = _frameIndex;
+            _stats.inUse++;
+            _stats.peakInUse = std::max(_stats.peakInUse, _stats.inUse);
+            return i;
+        }
+    }
+
+    if (freeSlot < 0) {
+        freeSlot = (int) _entries.size();
+        _entries.emplace_back();
+    }
+    Entry &entry = _entries[freeSlot];
+    if (!create(entry, width, height, internalFormat)) {
+        return -1;
+    }
+    entry.inUse = true;
+    entry.lastUsedFrame = _frameIndex;
+    _stats.inUse++;
+    _stats.peakInUse = std::max(_stats.peakInUse, _stats.inUse);
+    return freeSlot;
+}
+
+bool GLESRenderTargetPool::create(Entry &entry, int width, int height, GLenum internalFormat) {
+    GLES_TRACE_SCOPE("createRenderTarget");
+    GLESRenderTarget &target = entry.target;
+    glGenTextures(1, &target.texture);
+    _stateCache.bindTextureUnit(TEXTURE_UNIT, GL_TEXTURE_2D, target.texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glGenFramebuffers(1, &target.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        printf("Render target %dx%d (0x%x) incomplete: 0x%x\n", width, height, internalFormat, status);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &target.framebuffer);
+        _stateCache.deleteTextures(1, &target.texture);
+        target = GLESRenderTarget();
+        return false;
+    }
+    target.width = width;
+    target.height = height;
+    target.format = internalFormat;
+
+    _stats.targets++;
+    _stats.allocations++;
+    _stats.bytes += (size_t) width * (size_t) height * getBytesPerPixel(internalFormat);
+    _stats.peakBytes = std::max(_stats.peakBytes, _stats.bytes);
+    return true;
+}
+
+void GLESRenderTargetPool::destroy(Entry &entry) {
+    GLESRenderTarget &target = entry.target;
+    if (!target.framebuffer) {
+        return;
+    }
+    if (entry.inUse) {
+        _stats.inUse--;
+    }
+    _stats.targets--;
+    _stats.bytes -= (size_t) target.width * (size_t) target.height * getBytesPerPixel(target.format);
+    glDeleteFramebuffers(1, &target.framebuffer);
+    _stateCache.deleteTextures(1, &target.texture);
+    entry = Entry();
+}
+
+void GLESRenderTargetPool::release(int handle) {
+    if (handle < 0 || handle >= (int) _entries.size() || !_entries[handle].inUse) {
+        return;
+    }
+    _entries[handle].inUse = false;
+    _stats.inUse--;
+}
+
+const GLESRenderTarget &GLESRenderTargetPool::get(int handle) const {
+    return _entries[handle].target;
+}
+
+void GLESRenderTargetPool::invalidate(GLsizei count, const GLenum *attachments) {
+    if (!_invalidateFramebuffer && !_discardFramebuffer) {
+        return;
+    }
+    // 两个入口的附件枚举值相同(GL_COLOR与GL_COLOR_EXT等)
+    if (_invalidateFramebuffer) {
+        glInvalidateFramebuffer(GL_FRAMEBUFFER, count, attachments);
+    } else {
+        glDiscardFramebufferEXT(GL_FRAMEBUFFER, count, attachments);
+    }
+    _stats.invalidations++;
+}
+
+void GLESRenderTargetPool::endFrame() {
+    _frameIndex++;
+    for (Entry &entry : _entries) {
+        if (entry.target.framebuffer && !entry.inUse && _frameIndex - entry.lastUsedFrame > TRIM_FRAMES) {
+            destroy(entry);
+        }
+    }
+}
+
+GLESRenderTargetStats GLESRenderTargetPool::getStats() const {
+    return _stats;
+}
+
+void GLESRenderTargetPool::printStats(FILE *file) const {
+    if (_stats.acquires == 0) {
+        return;
+    }
+    fprintf(file, "Render targets: %d (%.1f MB), peak %d in use / %.1f MB, %llu acquires, %llu reused, "
+                  "%llu allocated, %llu invalidations\n", _stats.targets, (double) _stats.bytes / (1024.0 * 1024.0),
+            _stats.peakInUse, (double) _stats.peakBytes / (1024.0 * 1024.0), (unsigned long long) _stats.acquires,
+            (unsigned long long) _stats.reuses, (unsigned long long) _stats.allocations,
+            (unsigned long long) _stats.invalidations);
+}
+
+void GLESRenderTargetPool::release() {
+    for (Entry &entry : _entries) {
+        destroy(entry);
+    }
+    _entries.clear();
+}
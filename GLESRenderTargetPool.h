@@ -0,0 +1,105 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESRENDERTARGETPOOL_H
+#define GLES_DEMO_GLESRENDERTARGETPOOL_H
+
+#include <GLES3/gl32.h>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "GLESStateCache.h"
+
+// 一个离屏渲染目标: 单个颜色纹理附件的FBO
+struct GLESRenderTarget {
+    GLuint framebuffer = 0;
+    GLuint texture = 0;
+    int width = 0;
+    int height = 0;
+    GLenum format = 0;
+};
+
+// 池的用量, 字节数按格式估算, 不含驱动的对齐和压缩
+struct GLESRenderTargetStats {
+    int targets = 0;
+    int inUse = 0;
+    int peakInUse = 0;
+    size_t bytes = 0;
+    size_t peakBytes = 0;
+    uint64_t acquires = 0;
+    // acquire时复用了已有目标的次数, 其余的新分配
+    uint64_t reuses = 0;
+    uint64_t allocations = 0;
+    uint64_t invalidations = 0;
+};
+
+/**
+ * 渲染目标池: 多个pass之间和帧与帧之间按(宽, 高, 格式)复用FBO和颜色纹理, 稳定后每帧不再创建GL对象.
+ * acquire返回句柄, 内容未定义; 用完release放回池中, 同一帧内后面的pass就可以复用.
+ * 连续TRIM_FRAMES帧没有被取用的空闲目标在endFrame时释放.
+ * invalidate告诉驱动附件的内容不需要载入或写回, 分块渲染的GPU可以省掉片上内存与显存之间的拷贝:
+ * GLES3用glInvalidateFramebuffer, 否则退回GL_EXT_discard_framebuffer, 都不支持时为空操作.
+ * 离屏目标需要GLES3(glTexStorage2D).
+ */
+class GLESRenderTargetPool {
+public:
+    // 创建纹理和后处理采样输入时占用的纹理单元, 避开场景和动态分辨率使用的单元
+    static const GLuint TEXTURE_UNIT = 14;
+
+    explicit GLESRenderTargetPool(GLESStateCache &stateCache);
+
+    GLESRenderTargetPool(const GLESRenderTargetPool &) = delete;
+
+    GLESRenderTargetPool &operator=(const GLESRenderTargetPool &) = delete;
+
+    // 上下文创建后设置, 决定invalidate使用的入口
+    void setCaps(bool invalidateFramebuffer, bool discardFramebuffer);
+
+    // 返回句柄, 创建失败时返回-1; internalFormat为glTexStorage2D的有尺寸格式
+    int acquire(int width, int height, GLenum internalFormat);
+
+    void release(int handle);
+
+    const GLESRenderTarget &get(int handle) const;
+
+    // 丢弃当前绑定的帧缓冲上这些附件的内容; 默认帧缓冲的附件用GL_COLOR/GL_DEPTH/GL_STENCIL
+    void invalidate(GLsizei count, const GLenum *attachments);
+
+    // 每帧结束时调用, 释放长时间空闲的目标
+    void endFrame();
+
+    GLESRenderTargetStats getStats() const;
+
+    void printStats(FILE *file) const;
+
+    // 释放所有目标, 需要在上下文销毁之前调用
+    void release();
+
+private:
+    struct Entry {
+        GLESRenderTarget target;
+        bool inUse = false;
+        uint64_t lastUsedFrame = 0;
+    };
+
+    static size_t getBytesPerPixel(GLenum internalFormat);
+
+    bool create(Entry &entry, int width, int height, GLenum internalFormat);
+
+    void destroy(Entry &entry);
+
+    // 空闲目标保留的帧数
+    static const uint64_t TRIM_FRAMES = 120;
+
+    GLESStateCache &_stateCache;
+    bool _invalidateFramebuffer = false;
+    bool _discardFramebuffer = false;
+    // 释放后的空位留给下次创建, 句柄保持不变
+    std::vector<Entry> _entries;
+    uint64_t _frameIndex = 0;
+    GLESRenderTargetStats _stats;
+};
+
+
+#endif //GLES_DEMO_GLESRENDERTARGETPOOL_H
@@ -0,0 +1,93 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESSCENECONFIG_H
+#define GLES_DEMO_GLESSCENECONFIG_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * 场景配置, 每个GLESUtils实例持有一份, 调用initShaders前设置即可生效.
+ * 路径都相对运行目录, 默认值对应从build/bin运行gles_demo
+ */
+struct GLESSceneConfig {
+    // 着色器路径
+    std::string vshPath = "../../shader/test/vsh.vert";
+    std::string fshPath = "../../shader/test/fsh.frag";
+    // 纹理个数, 多于图片时循环使用
+    int textureSize = 3;
+    std::vector<std::string> imageFiles = {"../../pic/1.jpg", "../../pic/2.jpg", "../../pic/3.jpg"};
+    // 压缩纹理缓存和着色器程序二进制缓存目录, 空表示不使用
+    std::string textureCacheDir = "texture_cache";
+    std::string programCacheDir = "program_cache";
+    // 过渡速度, 着色器在progress * speed达到1时完成一次渐变
+    float speed = 1.3f;
+    // 画面没有变化(uniform、纹理、窗口都没变)时不绘制也不交换, 改为等待窗口消息或定时器; 基准测试要关掉
+    bool idleSkip = true;
+    int idleWaitMs = 16;
+
+    // 动态分辨率: 先画到离屏FBO再放大到窗口, 渲染比例按实测帧间隔在[minScale, maxScale]内调整,
+    // 帧间隔超出targetFrameMs的±scaleHysteresis(相对值)时才调整; 需要GLES3
+    bool dynamicResolution = false;
+    double targetFrameMs = 16.7;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    double scaleHysteresis = 0.1;
+
+    // 后处理: 非空时场景先画到离屏目标, 再按顺序经过这些pass(blur/grade), 最后一个输出到窗口; 需要GLES3
+    std::vector<std::string> postPasses;
+    std::string postVshPath = "../../shader/post/post.vert";
+    std::string blurFshPath = "../../shader/post/blur.frag";
+    std::string gradeFshPath = "../../shader/post/grade.frag";
+    // 模糊半径(像素), 以及调色的曝光(档)、对比度和饱和度
+    float blurRadius = 1.5f;
+    float gradeExposure = 0.0f;
+    float gradeContrast = 1.1f;
+    float gradeSaturation = 1.2f;
+
+    // 帧内GL错误检查: strict/deferred/callback, 空为构建的默认值(调试构建strict, 发布构建callback);
+    // deferred模式每glErrorInterval帧调用一次glGetError
+    std::string glErrorMode;
+    int glErrorInterval = 60;
+
+    // 着色器变体: 缓动曲线(linear/pow5/smoothstep)、片元精度, 以及额外注入的宏; 纹理个数由textureSize注入
+    std::string easing = "pow5";
+    std::string precision = "mediump";
+    std::vector<std::pair<std::string, std::string> > shaderDefines;
+
+    // 图块墙: 列数和行数都大于0时用纹理数组和实例化绘制整屏图块, 否则绘制单个全屏四边形
+    int tileColumns = 0;
+    int tileRows = 0;
+    std::string tileVshPath = "../../shader/tiles/tiles.vert";
+    std::string tileFshPath = "../../shader/tiles/tiles.frag";
+    // 图块各自切换时的缓动曲线
+    std::string tileEasing = "smoothstep";
+
+    // 视频输入(Y4M文件或管道, "-"为标准输入), 优先于图块墙和图片; 设置了宽高时按裸I420/NV12帧读取
+    std::string videoPath;
+    std::string videoFormat = "i420";
+    int videoWidth = 0;
+    int videoHeight = 0;
+    bool videoLoop = true;
+    std::string videoVshPath = "../../shader/video/video.vert";
+    std::string videoFshPath = "../../shader/video/video.frag";
+
+    // 截帧输出(png为文件名模板, raw/y4m为单个文件), 非空时每帧交换前异步读回
+    std::string capturePath;
+    std::string captureFormat = "png";
+    // 写进Y4M头的帧率; 不丢帧时渲染等待读回和写文件, 用于离线生成
+    int captureFps = 60;
+    bool captureLossless = false;
+
+    // 播放列表(目录或图片文件), 非空时流式播放, 显存中只保留playlistSlots张纹理
+    std::vector<std::string> playlistPaths;
+    // 每张图停留的秒数
+    double playlistHold = 3.0;
+    int playlistSlots = 4;
+};
+
+
+#endif //GLES_DEMO_GLESSCENECONFIG_H
@@ -0,0 +1,167 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESShaderPreprocessor.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+static bool readFile(const std::string &path, std::string &text) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    text.assign((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static std::string trimLeft(const std::string &line) {
+    size_t begin = line.find_first_not_of(" \t\r");
+    return begin == std::string::npos ? "" : line.substr(begin);
+}
+
+// GLSL ES 1.00中#line N之后的一行是第N + 1行, 3.00起是第N行
+static std::string lineDirective(int nextLine, int sourceIndex, bool es3) {
+    return "#line " + std::to_string(es3 ? nextLine : nextLine - 1) + " " + std::to_string(sourceIndex) + "\n";
+}
+
+/**
+ * @MethodName: load
+ * @Return: 是否成功
+ * @Description: 命中内存中的变体时直接返回; 否则从根文件开始展开, 宏定义注入在根文件的#version之后
+ */
+bool GLESShaderPreprocessor::load(const std::string &path, const Defines &defines, std::string &source) {
+    std::string key = makeVariantKey(path, defines);
+    auto cached = _variants.find(key);
+    if (cached != _variants.end()) {
+        source = cached->second.source;
+        _files = cached->second.files;
+        return true;
+    }
+
+    std::string text;
+    if (!readFile(path, text)) {
+        printf("Failed to read shader: %s\n", path.c_str());
+        return false;
+    }
+    std::string prologue;
+    for (const auto &define : defines) {
+        prologue += "#define " + define.first + " " + define.second + "\n";
+    }
+
+    _files.assign(1, path);
+    std::vector<std::string> stack(1, path);
+    std::string out;
+    bool es3 = text.find("#version 3") != std::string::npos;
+    if (!expandLines(path, text, 0, es3, &prologue, stack, out)) {
+        return false;
+    }
+
+    Variant &variant = _variants[key];
+    variant.source = out;
+    variant.files = _files;
+    source = out;
+    return true;
+}
+
+/**
+ * @MethodName: expand
+ * @Return: 是否成功
+ * @Description: 展开被包含的文件; 已经展开过的文件跳过, 正在展开的文件再次出现说明循环包含
+ */
+bool GLESShaderPreprocessor::expand(const std::string &path, bool es3, std::vector<std::string> &stack,
+                                    std::string &out) {
+    if (std::find(stack.begin(), stack.end(), path) != stack.end()) {
+        printf("Circular #include of %s\n", path.c_str());
+        return false;
+    }
+    if (std::find(_files.begin(), _files.end(), path) != _files.end()) {
+        return true;
+    }
+    std::string text;
+    if (!readFile(path, text)) {
+        printf("Failed to read shader include: %s\n", path.c_str());
+        return false;
+    }
+
+    auto sourceIndex = (int) _files.size();
+    _files.push_back(path);
+    stack.push_back(path);
+    out += lineDirective(1, sourceIndex, es3);
+    bool result = expandLines(path, text, sourceIndex, es3, NULL, stack, out);
+    stack.pop_back();
+    return result;
+}
+
+/**
+ * @MethodName: expandLines
+ * @Return: 是否成功
+ * @Description: 逐行输出, #include行换成被包含文件的内容, 之后用#line恢复本文件的行号;
+ *               prologue非空时放在第一条有效内容之前, 第一条是#version时放在它之后
+ */
+bool GLESShaderPreprocessor::expandLines(const std::string &path, const std::string &text, int sourceIndex, bool es3,
+                                         const std::string *prologue, std::vector<std::string> &stack,
+                                         std::string &out) {
+    std::istringstream lines(text);
+    std::string line;
+    for (int lineNumber = 1; std::getline(lines, line); ++lineNumber) {
+        std::string trimmed = trimLeft(line);
+        if (prologue && !trimmed.empty() && trimmed.compare(0, 2, "//") != 0) {
+            bool version = trimmed.compare(0, 8, "#version") == 0;
+            if (version) {
+                out += line + "\n";
+            }
+            out += *prologue + lineDirective(version ? lineNumber + 1 : lineNumber, sourceIndex, es3);
+            prologue = NULL;
+            if (version) {
+                continue;
+            }
+        }
+        if (trimmed.compare(0, 8, "#include") != 0) {
+            out += line + "\n";
+            continue;
+        }
+
+        size_t open = trimmed.find_first_of("\"<");
+        size_t close = open == std::string::npos ? open : trimmed.find_first_of("\">", open + 1);
+        if (close == std::string::npos || close == open + 1) {
+            printf("%s:%d: malformed #include\n", path.c_str(), lineNumber);
+            return false;
+        }
+        std::string name = trimmed.substr(open + 1, close - open - 1);
+        size_t slash = path.rfind('/');
+        if (name[0] != '/' && slash != std::string::npos) {
+            name = path.substr(0, slash + 1) + name;
+        }
+        if (!expand(name, es3, stack, out)) {
+            printf("  included from %s:%d\n", path.c_str(), lineNumber);
+            return false;
+        }
+        out += lineDirective(lineNumber + 1, sourceIndex, es3);
+    }
+    return true;
+}
+
+std::string GLESShaderPreprocessor::makeVariantKey(const std::string &path, const Defines &defines) {
+    std::string key = path;
+    for (const auto &define : defines) {
+        key += "|" + define.first + "=" + define.second;
+    }
+    return key;
+}
+
+const std::vector<std::string> &GLESShaderPreprocessor::getFiles() const {
+    return _files;
+}
+
+size_t GLESShaderPreprocessor::getVariantCount() const {
+    return _variants.size();
+}
+
+void GLESShaderPreprocessor::clear() {
+    _variants.clear();
+    _files.clear();
+}
@@ -0,0 +1,52 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESSHADERPREPROCESSOR_H
+#define GLES_DEMO_GLESSHADERPREPROCESSOR_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * 着色器预处理: 在交给驱动之前展开#include "file"(相对包含它的文件, 同一文件只展开一次), 并在#version之后注入
+ * #define, 同一份源码按宏的组合特化成不同的变体. 展开时插入#line, 编译错误中的源串号对应getFiles()的下标.
+ * #include不受#if控制, 总会展开.
+ * 展开结果按变体键缓存在内存中; 编译好的变体由程序二进制缓存按展开后的源码保存在磁盘上.
+ */
+class GLESShaderPreprocessor {
+public:
+    typedef std::vector<std::pair<std::string, std::string> > Defines;
+
+    // 失败(文件不存在、循环包含)时打印原因并返回false
+    bool load(const std::string &path, const Defines &defines, std::string &source);
+
+    // 路径和宏定义(按给出的顺序)组成的键
+    static std::string makeVariantKey(const std::string &path, const Defines &defines);
+
+    // 最近一次load用到的文件
+    const std::vector<std::string> &getFiles() const;
+
+    size_t getVariantCount() const;
+
+    void clear();
+
+private:
+    struct Variant {
+        std::string source;
+        std::vector<std::string> files;
+    };
+
+    bool expand(const std::string &path, bool es3, std::vector<std::string> &stack, std::string &out);
+
+    bool expandLines(const std::string &path, const std::string &text, int sourceIndex, bool es3,
+                     const std::string *prologue, std::vector<std::string> &stack, std::string &out);
+
+    std::map<std::string, Variant> _variants;
+    std::vector<std::string> _files;
+};
+
+
+#endif //GLES_DEMO_GLESSHADERPREPROCESSOR_H
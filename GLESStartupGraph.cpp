@@ -0,0 +1,193 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESStartupGraph.h"
+#include "GLESTrace.h"
+#include <chrono>
+
+GLESStartupGraph::GLESStartupGraph(GLESThreadPool &pool) : _pool(pool) {
+}
+
+GLESStartupGraph::~GLESStartupGraph() {
+    // 后台任务引用了调用者的对象, 先等它们结束
+    wait();
+}
+
+int GLESStartupGraph::addTask(const std::string &name, const std::vector<int> &deps, bool contextThread,
+                              std::function<bool()> body) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Task task;
+    task.name = name;
+    task.deps = deps;
+    task.contextThread = contextThread;
+    task.body = std::move(body);
+    _tasks.push_back(std::move(task));
+    return (int) _tasks.size() - 1;
+}
+
+double GLESStartupGraph::getElapsedMs() const {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count() - _startMs;
+}
+
+bool GLESStartupGraph::isReady(const Task &task) const {
+    for (int dep : task.deps) {
+        if (!_tasks[dep].finished || !_tasks[dep].ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @MethodName: dispatchWorkers
+ * @Description: 就绪时刻取最晚结束的前驱, 任务在线程池中排队的时间计入等待
+ */
+void GLESStartupGraph::dispatchWorkers() {
+    for (int i = 0; i < (int) _tasks.size() && !_failed; ++i) {
+        Task &task = _tasks[i];
+        if (task.contextThread || task.dispatched || !isReady(task)) {
+            continue;
+        }
+        task.dispatched = true;
+        task.readyMs = 0.0;
+        for (int dep : task.deps) {
+            if (_tasks[dep].endMs > task.readyMs) {
+                task.readyMs = _tasks[dep].endMs;
+                task.blocker = dep;
+            }
+        }
+        _running++;
+        _pool.submit([this, i]() {
+            double beginMs = getElapsedMs();
+            bool ok = _tasks[i].body();
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running--;
+            finishTask(i, ok, beginMs);
+        });
+    }
+}
+
+void GLESStartupGraph::finishTask(int index, bool ok, double beginMs) {
+    Task &task = _tasks[index];
+    task.beginMs = beginMs;
+    task.endMs = getElapsedMs();
+    task.ok = ok;
+    task.finished = true;
+    if (!ok) {
+        printf("Startup task failed: %s\n", task.name.c_str());
+        _failed = true;
+    }
+    dispatchWorkers();
+    _condition.notify_all();
+}
+
+/**
+ * @MethodName: run
+ * @Return: 上下文线程任务是否全部成功
+ * @Description: 上下文线程任务严格按添加顺序执行, 前一个没结束或依赖没满足时在这里等待, 线程池任务结束时唤醒
+ */
+bool GLESStartupGraph::run() {
+    GLES_TRACE_SCOPE("startup");
+    std::unique_lock<std::mutex> lock(_mutex);
+    _startMs = 0.0;
+    _startMs = getElapsedMs();
+    dispatchWorkers();
+    for (;;) {
+        int next = -1;
+        for (int i = 0; i < (int) _tasks.size(); ++i) {
+            if (_tasks[i].contextThread && !_tasks[i].dispatched) {
+                next = i;
+                break;
+            }
+        }
+        if (next < 0 || _failed) {
+            break;
+        }
+        if (!isReady(_tasks[next])) {
+            _condition.wait(lock);
+            continue;
+        }
+
+        Task &task = _tasks[next];
+        task.dispatched = true;
+        task.readyMs = 0.0;
+        task.blocker = -1;
+        std::vector<int> predecessors = task.deps;
+        if (_lastContextTask >= 0) {
+            predecessors.push_back(_lastContextTask);
+        }
+        for (int dep : predecessors) {
+            if (_tasks[dep].endMs > task.readyMs) {
+                task.readyMs = _tasks[dep].endMs;
+                task.blocker = dep;
+            }
+        }
+        _lastContextTask = next;
+
+        // 执行期间不持锁, 线程池任务可以同时结束和投递后续任务
+        lock.unlock();
+        double beginMs = getElapsedMs();
+        bool ok = task.body();
+        lock.lock();
+        finishTask(next, ok, beginMs);
+    }
+    return !_failed;
+}
+
+bool GLESStartupGraph::wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _condition.wait(lock, [this]() { return _running == 0; });
+    return !_failed;
+}
+
+double GLESStartupGraph::getEndMs(const std::string &name) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const Task &task : _tasks) {
+        if (task.name == name) {
+            return task.finished ? task.endMs : -1.0;
+        }
+    }
+    return -1.0;
+}
+
+/**
+ * @MethodName: printReport
+ * @Description: 关键路径上的任务标*; 等待为就绪到开始之间的时间(线程池排队或上下文线程忙),
+ *               关键路径的总长等于其上各任务的等待与耗时之和
+ */
+void GLESStartupGraph::printReport(FILE *file) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    int last = -1;
+    for (int i = 0; i < (int) _tasks.size(); ++i) {
+        if (_tasks[i].finished && (last < 0 || _tasks[i].endMs > _tasks[last].endMs)) {
+            last = i;
+        }
+    }
+    std::vector<bool> critical(_tasks.size(), false);
+    for (int i = last; i >= 0; i = _tasks[i].blocker) {
+        critical[i] = true;
+    }
+
+    fprintf(file, "Startup tasks (critical path %.1f ms):\n", last >= 0 ? _tasks[last].endMs : 0.0);
+    for (size_t i = 0; i < _tasks.size(); ++i) {
+        const Task &task = _tasks[i];
+        const char *thread = task.contextThread ? "context" : "worker";
+        if (!task.finished) {
+            fprintf(file, "    %-28s %-7s %s\n", task.name.c_str(), thread, task.dispatched ? "running" : "not run");
+            continue;
+        }
+        fprintf(file, "  %c %-28s %-7s start %7.1f ms  took %7.1f ms  waited %6.1f ms%s\n", critical[i] ? '*' : ' ',
+                task.name.c_str(), thread, task.beginMs, task.endMs - task.beginMs, task.beginMs - task.readyMs,
+                task.ok ? "" : "  FAILED");
+    }
+}
+
+void GLESStartupGraph::clear() {
+    wait();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _tasks.clear();
+    _failed = false;
+    _lastContextTask = -1;
+}
@@ -0,0 +1,92 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESSTARTUPGRAPH_H
+#define GLES_DEMO_GLESSTARTUPGRAPH_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "GLESThreadPool.h"
+
+/**
+ * 启动任务图: 与GL上下文无关的步骤(读文件、解码)投递到线程池, 与本地窗口和EGL的初始化重叠;
+ * 需要上下文的步骤在调用run的线程上按添加顺序依次执行.
+ * run在所有上下文线程任务完成后返回, 没有被它们依赖的线程池任务在后台继续执行, wait等待它们结束.
+ * 记录每个任务的就绪、开始和结束时刻, 报告中标出关键路径: 从最后完成的任务沿最晚就绪的前驱回溯.
+ */
+class GLESStartupGraph {
+public:
+    explicit GLESStartupGraph(GLESThreadPool &pool);
+
+    ~GLESStartupGraph();
+
+    GLESStartupGraph(const GLESStartupGraph &) = delete;
+
+    GLESStartupGraph &operator=(const GLESStartupGraph &) = delete;
+
+    /**
+     * 添加任务, 返回任务编号; deps为之前添加的任务编号
+     * contextThread为true时在调用run的线程执行, 否则在线程池执行. 任务返回false时不再启动新的任务
+     */
+    int addTask(const std::string &name, const std::vector<int> &deps, bool contextThread,
+                std::function<bool()> body);
+
+    // 返回上下文线程任务是否全部成功
+    bool run();
+
+    // 等待后台任务结束, 返回所有已执行的任务是否都成功
+    bool wait();
+
+    // 任务结束的时刻(距run开始的毫秒数), 任务不存在或还没结束时返回-1
+    double getEndMs(const std::string &name) const;
+
+    // 距run开始的毫秒数
+    double getElapsedMs() const;
+
+    // 各任务的开始、耗时和等待时间, 以及到目前为止完成的任务中的关键路径
+    void printReport(FILE *file) const;
+
+    void clear();
+
+private:
+    struct Task {
+        std::string name;
+        std::vector<int> deps;
+        bool contextThread;
+        std::function<bool()> body;
+        bool dispatched = false;
+        bool finished = false;
+        bool ok = false;
+        // 距run开始的毫秒数; ready为所有前驱都结束(上下文线程任务还要等上一个上下文任务)的时刻
+        double readyMs = -1.0;
+        double beginMs = -1.0;
+        double endMs = -1.0;
+        // 决定就绪时刻的前驱, 用于回溯关键路径
+        int blocker = -1;
+    };
+
+    bool isReady(const Task &task) const;
+
+    // 需要持有_mutex; 投递所有依赖已满足的线程池任务
+    void dispatchWorkers();
+
+    void finishTask(int index, bool ok, double beginMs);
+
+    GLESThreadPool &_pool;
+    std::vector<Task> _tasks;
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;
+    double _startMs = 0.0;
+    int _running = 0;
+    bool _failed = false;
+    // 上一个执行的上下文线程任务
+    int _lastContextTask = -1;
+};
+
+
+#endif //GLES_DEMO_GLESSTARTUPGRAPH_H
@@ -0,0 +1,324 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESStateCache.h"
+
+#define DYNAMICGLES_NO_NAMESPACE
+#define DYNAMICEGL_NO_NAMESPACE
+
+#include <DynamicGles.h>
+#include <cstring>
+
+// 影子状态未知, 下一次调用一定会提交
+static const GLuint UNKNOWN = 0xFFFFFFFFu;
+
+GLESStateCache::GLESStateCache() {
+    invalidate();
+}
+
+/**
+ * @MethodName: invalidate
+ * @Description: 把所有影子状态置为未知, 不影响计数
+ */
+void GLESStateCache::invalidate() {
+    _program = UNKNOWN;
+    _activeUnit = UNKNOWN;
+    for (auto &unit : _textures) {
+        for (GLuint &texture : unit) {
+            texture = UNKNOWN;
+        }
+    }
+    for (GLuint &buffer : _buffers) {
+        buffer = UNKNOWN;
+    }
+    _vertexArray = UNKNOWN;
+    memset(_vertexAttribs, -1, sizeof(_vertexAttribs));
+    memset(_capabilities, -1, sizeof(_capabilities));
+    _blendSrc = _blendDst = UNKNOWN;
+    _clearColorValid = false;
+    _viewportValid = false;
+}
+
+int GLESStateCache::textureTargetIndex(GLenum target) {
+    switch (target) {
+        case GL_TEXTURE_2D:
+            return 0;
+        case GL_TEXTURE_2D_ARRAY:
+            return 1;
+        case GL_TEXTURE_CUBE_MAP:
+            return 2;
+        case GL_TEXTURE_3D:
+            return 3;
+        default:
+            return -1;
+    }
+}
+
+int GLESStateCache::bufferTargetIndex(GLenum target) {
+    switch (target) {
+        case GL_ARRAY_BUFFER:
+            return 0;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            return 1;
+        case GL_PIXEL_UNPACK_BUFFER:
+            return 2;
+        case GL_PIXEL_PACK_BUFFER:
+            return 3;
+        case GL_UNIFORM_BUFFER:
+            return 4;
+        case GL_COPY_READ_BUFFER:
+            return 5;
+        case GL_COPY_WRITE_BUFFER:
+            return 6;
+        default:
+            return -1;
+    }
+}
+
+int GLESStateCache::capabilityIndex(GLenum capability) {
+    switch (capability) {
+        case GL_BLEND:
+            return 0;
+        case GL_DEPTH_TEST:
+            return 1;
+        case GL_CULL_FACE:
+            return 2;
+        case GL_SCISSOR_TEST:
+            return 3;
+        case GL_STENCIL_TEST:
+            return 4;
+        default:
+            return -1;
+    }
+}
+
+// 记账并返回是否可以省掉这次调用
+bool GLESStateCache::elide(bool same) {
+    if (same) {
+        ++_counters.elided;
+    } else {
+        ++_counters.issued;
+    }
+    return same;
+}
+
+void GLESStateCache::useProgram(GLuint program) {
+    if (elide(program == _program)) {
+        return;
+    }
+    glUseProgram(program);
+    _program = program;
+}
+
+void GLESStateCache::activeTexture(GLenum unit) {
+    GLuint index = unit - GL_TEXTURE0;
+    if (elide(index == _activeUnit)) {
+        return;
+    }
+    glActiveTexture(unit);
+    _activeUnit = index;
+}
+
+/**
+ * @MethodName: bindTexture
+ * @Description: 绑定到当前活动纹理单元, 与glBindTexture语义相同
+ */
+void GLESStateCache::bindTexture(GLenum target, GLuint texture) {
+    int targetIndex = textureTargetIndex(target);
+    bool known = targetIndex >= 0 && _activeUnit < MAX_TEXTURE_UNITS;
+    if (elide(known && _textures[_activeUnit][targetIndex] == texture)) {
+        return;
+    }
+    glBindTexture(target, texture);
+    if (known) {
+        _textures[_activeUnit][targetIndex] = texture;
+    }
+}
+
+/**
+ * @MethodName: bindTextureUnit
+ * @Description: 绑定到指定纹理单元, 该单元已经绑定了这个纹理时连glActiveTexture也省掉
+ */
+void GLESStateCache::bindTextureUnit(GLuint unit, GLenum target, GLuint texture) {
+    int targetIndex = textureTargetIndex(target);
+    if (targetIndex >= 0 && unit < MAX_TEXTURE_UNITS && _textures[unit][targetIndex] == texture) {
+        elide(true);
+        return;
+    }
+    activeTexture(GL_TEXTURE0 + unit);
+    bindTexture(target, texture);
+}
+
+void GLESStateCache::bindBuffer(GLenum target, GLuint buffer) {
+    int targetIndex = bufferTargetIndex(target);
+    if (elide(targetIndex >= 0 && _buffers[targetIndex] == buffer)) {
+        return;
+    }
+    glBindBuffer(target, buffer);
+    if (targetIndex >= 0) {
+        _buffers[targetIndex] = buffer;
+    }
+}
+
+/**
+ * @MethodName: bindVertexArray
+ * @Description: 索引缓冲绑定和属性开关属于VAO, 切换VAO后这些影子状态变为未知
+ */
+void GLESStateCache::bindVertexArray(GLuint vertexArray) {
+    if (elide(vertexArray == _vertexArray)) {
+        return;
+    }
+    glBindVertexArray(vertexArray);
+    _vertexArray = vertexArray;
+    _buffers[bufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    memset(_vertexAttribs, -1, sizeof(_vertexAttribs));
+}
+
+void GLESStateCache::setVertexAttribArray(GLuint index, bool enabled) {
+    bool known = index < MAX_VERTEX_ATTRIBS;
+    if (elide(known && _vertexAttribs[index] == (enabled ? 1 : 0))) {
+        return;
+    }
+    if (enabled) {
+        glEnableVertexAttribArray(index);
+    } else {
+        glDisableVertexAttribArray(index);
+    }
+    if (known) {
+        _vertexAttribs[index] = (int8_t) (enabled ? 1 : 0);
+    }
+}
+
+void GLESStateCache::setEnabled(GLenum capability, bool enabled) {
+    int index = capabilityIndex(capability);
+    if (elide(index >= 0 && _capabilities[index] == (enabled ? 1 : 0))) {
+        return;
+    }
+    if (enabled) {
+        glEnable(capability);
+    } else {
+        glDisable(capability);
+    }
+    if (index >= 0) {
+        _capabilities[index] = (int8_t) (enabled ? 1 : 0);
+    }
+}
+
+void GLESStateCache::blendFunc(GLenum srcFactor, GLenum dstFactor) {
+    if (elide(srcFactor == _blendSrc && dstFactor == _blendDst)) {
+        return;
+    }
+    glBlendFunc(srcFactor, dstFactor);
+    _blendSrc = srcFactor;
+    _blendDst = dstFactor;
+}
+
+void GLESStateCache::clearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+    const GLfloat color[4] = {red, green, blue, alpha};
+    if (elide(_clearColorValid && memcmp(color, _clearColor, sizeof(color)) == 0)) {
+        return;
+    }
+    glClearColor(red, green, blue, alpha);
+    memcpy(_clearColor, color, sizeof(color));
+    _clearColorValid = true;
+}
+
+void GLESStateCache::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    const GLint rect[4] = {x, y, width, height};
+    if (elide(_viewportValid && memcmp(rect, _viewport, sizeof(rect)) == 0)) {
+        return;
+    }
+    glViewport(x, y, width, height);
+    memcpy(_viewport, rect, sizeof(rect));
+    _viewportValid = true;
+}
+
+/**
+ * @MethodName: deleteProgram
+ * @Description: 当前程序被删除时GL会推迟到不再使用才真正释放, 影子置为未知, 下次useProgram一定提交
+ */
+void GLESStateCache::deleteProgram(GLuint program) {
+    if (!program) {
+        return;
+    }
+    glDeleteProgram(program);
+    if (_program == program) {
+        _program = UNKNOWN;
+    }
+}
+
+// 删除的纹理会从所有单元解绑, 影子同步改为0, 避免名字被复用后误判为已绑定
+void GLESStateCache::deleteTextures(GLsizei count, const GLuint *textures) {
+    if (count <= 0) {
+        return;
+    }
+    glDeleteTextures(count, textures);
+    for (GLsizei i = 0; i < count; ++i) {
+        if (!textures[i]) {
+            continue;
+        }
+        for (auto &unit : _textures) {
+            for (GLuint &texture : unit) {
+                if (texture == textures[i]) {
+                    texture = 0;
+                }
+            }
+        }
+    }
+}
+
+void GLESStateCache::deleteBuffers(GLsizei count, const GLuint *buffers) {
+    if (count <= 0) {
+        return;
+    }
+    glDeleteBuffers(count, buffers);
+    for (GLsizei i = 0; i < count; ++i) {
+        for (GLuint &buffer : _buffers) {
+            if (buffers[i] && buffer == buffers[i]) {
+                buffer = 0;
+            }
+        }
+    }
+}
+
+void GLESStateCache::deleteVertexArrays(GLsizei count, const GLuint *vertexArrays) {
+    if (count <= 0) {
+        return;
+    }
+    glDeleteVertexArrays(count, vertexArrays);
+    for (GLsizei i = 0; i < count; ++i) {
+        // 删除当前VAO后绑定回到0
+        if (vertexArrays[i] && _vertexArray == vertexArrays[i]) {
+            _vertexArray = 0;
+            _buffers[bufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+            memset(_vertexAttribs, -1, sizeof(_vertexAttribs));
+        }
+    }
+}
+
+void GLESStateCache::countCall(bool issued) {
+    elide(!issued);
+}
+
+GLuint GLESStateCache::getProgram() const {
+    return _program;
+}
+
+GLuint GLESStateCache::getBoundTexture(GLuint unit, GLenum target) const {
+    int targetIndex = textureTargetIndex(target);
+    return targetIndex >= 0 && unit < MAX_TEXTURE_UNITS ? _textures[unit][targetIndex] : UNKNOWN;
+}
+
+GLuint GLESStateCache::getBoundBuffer(GLenum target) const {
+    int targetIndex = bufferTargetIndex(target);
+    return targetIndex >= 0 ? _buffers[targetIndex] : UNKNOWN;
+}
+
+const GLESStateCounters &GLESStateCache::getCounters() const {
+    return _counters;
+}
+
+void GLESStateCache::resetCounters() {
+    _counters = GLESStateCounters();
+}
@@ -0,0 +1,109 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESSTATECACHE_H
+#define GLES_DEMO_GLESSTATECACHE_H
+
+#include <GLES3/gl32.h>
+#include <cstdint>
+
+// 状态调用计数: issued为真正提交给驱动的调用, elided为与影子状态相同而省掉的调用
+struct GLESStateCounters {
+    uint64_t issued = 0;
+    uint64_t elided = 0;
+};
+
+/**
+ * GL状态影子缓存: 记录程序、各纹理单元的纹理、缓冲、VAO、顶点属性开关、混合和清屏颜色等状态,
+ * 与当前值相同的调用直接省掉. 所有会改变这些状态的GL调用都要经过这里, 否则影子会与实际状态不一致;
+ * 删除对象也要通过这里, 以便清掉指向已删除名字的影子. 上下文重建或外部代码改过状态后调用invalidate.
+ * 只能在GL线程使用.
+ */
+class GLESStateCache {
+public:
+    static const int MAX_TEXTURE_UNITS = 32;
+    static const int MAX_VERTEX_ATTRIBS = 16;
+
+    GLESStateCache();
+
+    void invalidate();
+
+    void useProgram(GLuint program);
+
+    void activeTexture(GLenum unit);
+
+    void bindTexture(GLenum target, GLuint texture);
+
+    void bindTextureUnit(GLuint unit, GLenum target, GLuint texture);
+
+    void bindBuffer(GLenum target, GLuint buffer);
+
+    void bindVertexArray(GLuint vertexArray);
+
+    void setVertexAttribArray(GLuint index, bool enabled);
+
+    void setEnabled(GLenum capability, bool enabled);
+
+    void blendFunc(GLenum srcFactor, GLenum dstFactor);
+
+    void clearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    void deleteProgram(GLuint program);
+
+    void deleteTextures(GLsizei count, const GLuint *textures);
+
+    void deleteBuffers(GLsizei count, const GLuint *buffers);
+
+    void deleteVertexArrays(GLsizei count, const GLuint *vertexArrays);
+
+    // 给缓存之外的去重逻辑(如uniform影子缓存)记账
+    void countCall(bool issued);
+
+    GLuint getProgram() const;
+
+    GLuint getBoundTexture(GLuint unit, GLenum target) const;
+
+    GLuint getBoundBuffer(GLenum target) const;
+
+    const GLESStateCounters &getCounters() const;
+
+    void resetCounters();
+
+private:
+    enum {
+        TEXTURE_TARGET_COUNT = 4,
+        BUFFER_TARGET_COUNT = 7,
+        CAPABILITY_COUNT = 5
+    };
+
+    static int textureTargetIndex(GLenum target);
+
+    static int bufferTargetIndex(GLenum target);
+
+    static int capabilityIndex(GLenum capability);
+
+    bool elide(bool same);
+
+    GLuint _program;
+    GLuint _activeUnit;
+    GLuint _textures[MAX_TEXTURE_UNITS][TEXTURE_TARGET_COUNT];
+    GLuint _buffers[BUFFER_TARGET_COUNT];
+    GLuint _vertexArray;
+    // -1未知, 0关闭, 1打开
+    int8_t _vertexAttribs[MAX_VERTEX_ATTRIBS];
+    int8_t _capabilities[CAPABILITY_COUNT];
+    GLenum _blendSrc;
+    GLenum _blendDst;
+    GLfloat _clearColor[4];
+    bool _clearColorValid;
+    GLint _viewport[4];
+    bool _viewportValid;
+
+    GLESStateCounters _counters;
+};
+
+
+#endif //GLES_DEMO_GLESSTATECACHE_H
@@ -0,0 +1,409 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESTextureCache.h"
+#include "GLESTrace.h"
+#include "GLESHash.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+/* ETC1块编码. ETC1的individual/differential模式同时也是合法的ETC2 RGB8块 */
+
+// 亮度修正表, 像素索引0:+a 1:+b 2:-a 3:-b
+static const int etcModifiers[8][2] = {
+        {2,  8},
+        {5,  17},
+        {9,  29},
+        {13, 42},
+        {18, 60},
+        {24, 80},
+        {33, 106},
+        {47, 183}
+};
+
+static inline int clampByte(int v) {
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+static inline int etcModifier(int table, int selector) {
+    int value = etcModifiers[table][selector & 1];
+    return (selector & 2) ? -value : value;
+}
+
+/**
+ * @MethodName: fitSubblock
+ * @Return: 最小平方误差
+ * @Description: 对给定基色, 穷举8张修正表并为每个像素选最优修正值
+ */
+static int fitSubblock(const unsigned char *const pixels[8], const int base[3], int &bestTable,
+                       unsigned char selectors[8]) {
+    int bestError = INT_MAX;
+    for (int table = 0; table < 8; ++table) {
+        int error = 0;
+        unsigned char current[8];
+        for (int p = 0; p < 8 && error < bestError; ++p) {
+            int bestPixelError = INT_MAX;
+            for (int s = 0; s < 4; ++s) {
+                int modifier = etcModifier(table, s);
+                int dr = clampByte(base[0] + modifier) - pixels[p][0];
+                int dg = clampByte(base[1] + modifier) - pixels[p][1];
+                int db = clampByte(base[2] + modifier) - pixels[p][2];
+                int e = dr * dr + dg * dg + db * db;
+                if (e < bestPixelError) {
+                    bestPixelError = e;
+                    current[p] = (unsigned char) s;
+                }
+            }
+            error += bestPixelError;
+        }
+        if (error < bestError) {
+            bestError = error;
+            bestTable = table;
+            memcpy(selectors, current, 8);
+        }
+    }
+    return bestError;
+}
+
+struct EtcCandidate {
+    int error = INT_MAX;
+    bool differential = false;
+    bool flip = false;
+    int colors[2][3];
+    int tables[2];
+    unsigned char selectors[2][8];
+};
+
+/**
+ * @MethodName: encodeEtcBlock
+ * @Description: block为4x4像素(行优先RGB), 尝试两种分块方向和两种基色模式, 取误差最小者
+ */
+static void encodeEtcBlock(const unsigned char block[16][3], unsigned char out[8]) {
+    EtcCandidate best;
+    for (int flip = 0; flip < 2; ++flip) {
+        // flip=0: 左右两个2x4子块; flip=1: 上下两个4x2子块
+        const unsigned char *sub[2][8];
+        int count[2] = {0, 0};
+        float average[2][3] = {{0, 0, 0},
+                               {0, 0, 0}};
+        for (int y = 0; y < 4; ++y) {
+            for (int x = 0; x < 4; ++x) {
+                int s = flip ? (y >= 2) : (x >= 2);
+                sub[s][count[s]++] = block[y * 4 + x];
+                for (int c = 0; c < 3; ++c) { average[s][c] += block[y * 4 + x][c] / 8.0f; }
+            }
+        }
+
+        for (int differential = 0; differential < 2; ++differential) {
+            EtcCandidate candidate;
+            candidate.flip = flip != 0;
+            candidate.differential = differential != 0;
+            int expanded[2][3];
+            for (int c = 0; c < 3; ++c) {
+                if (differential) {
+                    // 5位基色, 第二个子块用3位有符号差值, 超出范围时截断
+                    int c0 = (int) lroundf(average[0][c] * 31.0f / 255.0f);
+                    int c1 = (int) lroundf(average[1][c] * 31.0f / 255.0f);
+                    int delta = c1 - c0 < -4 ? -4 : (c1 - c0 > 3 ? 3 : c1 - c0);
+                    candidate.colors[0][c] = c0;
+                    candidate.colors[1][c] = c0 + delta;
+                    expanded[0][c] = (c0 << 3) | (c0 >> 2);
+                    expanded[1][c] = ((c0 + delta) << 3) | ((c0 + delta) >> 2);
+                } else {
+                    for (int s = 0; s < 2; ++s) {
+                        int q = (int) lroundf(average[s][c] * 15.0f / 255.0f);
+                        candidate.colors[s][c] = q;
+                        expanded[s][c] = (q << 4) | q;
+                    }
+                }
+            }
+            candidate.error = fitSubblock(sub[0], expanded[0], candidate.tables[0], candidate.selectors[0]) +
+                              fitSubblock(sub[1], expanded[1], candidate.tables[1], candidate.selectors[1]);
+            if (candidate.error < best.error) {
+                best = candidate;
+            }
+        }
+    }
+
+    uint32_t high = 0, low = 0;
+    if (best.differential) {
+        for (int c = 0; c < 3; ++c) {
+            int shift = 27 - c * 8;
+            high |= (uint32_t) best.colors[0][c] << shift;
+            high |= (uint32_t) ((best.colors[1][c] - best.colors[0][c]) & 7) << (shift - 3);
+        }
+    } else {
+        for (int c = 0; c < 3; ++c) {
+            int shift = 28 - c * 8;
+            high |= (uint32_t) best.colors[0][c] << shift;
+            high |= (uint32_t) best.colors[1][c] << (shift - 4);
+        }
+    }
+    high |= (uint32_t) best.tables[0] << 5;
+    high |= (uint32_t) best.tables[1] << 2;
+    high |= (uint32_t) (best.differential ? 1 : 0) << 1;
+    high |= (uint32_t) (best.flip ? 1 : 0);
+
+    // 像素索引按列优先排列: 像素(x, y)的序号为x * 4 + y, 高位在bit(16 + i), 低位在bit(i)
+    int position[2] = {0, 0};
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            int s = best.flip ? (y >= 2) : (x >= 2);
+            unsigned selector = best.selectors[s][position[s]++];
+            int i = x * 4 + y;
+            low |= (uint32_t) (selector >> 1) << (16 + i);
+            low |= (uint32_t) (selector & 1) << i;
+        }
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        out[i] = (unsigned char) (high >> (24 - i * 8));
+        out[4 + i] = (unsigned char) (low >> (24 - i * 8));
+    }
+}
+
+size_t GLESTextureCache::getEtc2Size(int width, int height) {
+    return (size_t) ((width + 3) / 4) * ((height + 3) / 4) * 8;
+}
+
+/**
+ * @MethodName: encodeEtc2
+ * @Description: 按块行分给线程池并行编码
+ */
+void GLESTextureCache::encodeEtc2(const GLESImage &image, std::vector<unsigned char> &blocks, GLESThreadPool *pool) {
+    int blocksX = (image.width + 3) / 4;
+    int blocksY = (image.height + 3) / 4;
+    blocks.resize(getEtc2Size(image.width, image.height));
+    int bpp = image.bytesPerPixel();
+
+    auto encodeRows = [&](int rowBegin, int rowEnd) {
+        unsigned char block[16][3];
+        for (int by = rowBegin; by < rowEnd; ++by) {
+            for (int bx = 0; bx < blocksX; ++bx) {
+                for (int y = 0; y < 4; ++y) {
+                    int sy = std::min(by * 4 + y, image.height - 1);
+                    for (int x = 0; x < 4; ++x) {
+                        int sx = std::min(bx * 4 + x, image.width - 1);
+                        memcpy(block[y * 4 + x], &image.pixels[((size_t) sy * image.width + sx) * bpp], 3);
+                    }
+                }
+                encodeEtcBlock(block, &blocks[((size_t) by * blocksX + bx) * 8]);
+            }
+        }
+    };
+
+    if (pool) {
+        pool->parallelFor(0, blocksY, 4, encodeRows);
+    } else {
+        encodeRows(0, blocksY);
+    }
+}
+
+/* KTX 1.1文件 */
+
+static const unsigned char ktxIdentifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+static const char ktxSourceKey[] = "gles_demo.source";
+
+struct KtxHeader {
+    unsigned char identifier[12];
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+void GLESTextureCache::setCacheDir(const std::string &cacheDir) {
+    _cacheDir = cacheDir;
+}
+
+const std::string &GLESTextureCache::getCacheDir() const {
+    return _cacheDir;
+}
+
+unsigned GLESTextureCache::getHitCount() const {
+    return _hits.load();
+}
+
+unsigned GLESTextureCache::getMissCount() const {
+    return _misses.load();
+}
+
+/**
+ * @MethodName: makeKey
+ * @Return: 源文件是否存在
+ * @Description: 键包含路径、修改时间和大小, 缓存文件名为键的哈希
+ */
+bool GLESTextureCache::makeKey(const std::string &sourcePath, std::string &key, std::string &cachePath) const {
+    // 没有设置目录表示不使用缓存
+    struct stat st;
+    if (_cacheDir.empty() || stat(sourcePath.c_str(), &st) != 0) {
+        return false;
+    }
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "|%lld.%09ld|%lld", (long long) st.st_mtim.tv_sec, (long) st.st_mtim.tv_nsec,
+             (long long) st.st_size);
+    key = sourcePath + buffer;
+    cachePath = _cacheDir + "/" + hashToHex(hashString(key)) + ".ktx";
+    return true;
+}
+
+/**
+ * @MethodName: load
+ * @Return: 是否命中
+ * @Description: mmap缓存文件并校验头和键, 压缩数据直接指向映射区域
+ */
+bool GLESTextureCache::load(const std::string &sourcePath, GLESImage &image) {
+    GLES_TRACE_SCOPE("textureCache.load");
+    std::string key, cachePath;
+    if (!makeKey(sourcePath, key, cachePath)) {
+        return false;
+    }
+
+    int fd = open(cachePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        ++_misses;
+        return false;
+    }
+    struct stat st;
+    void *mapped = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > (off_t) sizeof(KtxHeader)) {
+        mapped = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        ++_misses;
+        return false;
+    }
+    auto fileSize = (size_t) st.st_size;
+    std::shared_ptr<void> storage(mapped, [fileSize](void *p) { munmap(p, fileSize); });
+
+    const auto *bytes = static_cast<const unsigned char *>(mapped);
+    KtxHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    size_t offset = sizeof(header);
+    bool valid = memcmp(header.identifier, ktxIdentifier, sizeof(ktxIdentifier)) == 0 &&
+                 header.endianness == 0x04030201 &&
+                 header.glInternalFormat == GL_COMPRESSED_RGB8_ETC2 &&
+                 header.numberOfMipmapLevels == 1 &&
+                 offset + header.bytesOfKeyValueData + 4 <= fileSize;
+
+    // 键值对中的源文件键必须一致(防止哈希碰撞)
+    if (valid) {
+        uint32_t pairSize = 0;
+        memcpy(&pairSize, bytes + offset, 4);
+        const char *pair = reinterpret_cast<const char *>(bytes + offset + 4);
+        valid = pairSize <= header.bytesOfKeyValueData &&
+                pairSize == sizeof(ktxSourceKey) + key.size() + 1 &&
+                memcmp(pair, ktxSourceKey, sizeof(ktxSourceKey)) == 0 &&
+                memcmp(pair + sizeof(ktxSourceKey), key.c_str(), key.size() + 1) == 0;
+        offset += header.bytesOfKeyValueData;
+    }
+
+    uint32_t imageSize = 0;
+    if (valid) {
+        memcpy(&imageSize, bytes + offset, 4);
+        offset += 4;
+        valid = imageSize == getEtc2Size(header.pixelWidth, header.pixelHeight) && offset + imageSize <= fileSize;
+    }
+    if (!valid) {
+        printf("Ignoring invalid texture cache file: %s\n", cachePath.c_str());
+        ++_misses;
+        return false;
+    }
+
+    image.width = (int) header.pixelWidth;
+    image.height = (int) header.pixelHeight;
+    image.format = GL_RGB;
+    image.pixels.clear();
+    image.compressed.format = GL_COMPRESSED_RGB8_ETC2;
+    image.compressed.data = bytes + offset;
+    image.compressed.size = imageSize;
+    image.compressed.storage = storage;
+    ++_hits;
+    return true;
+}
+
+/**
+ * @MethodName: store
+ * @Return: 是否写入成功
+ * @Description: 编码后先写临时文件再rename, 其他进程/线程不会读到写了一半的缓存
+ */
+bool GLESTextureCache::store(const std::string &sourcePath, const GLESImage &image, GLESThreadPool *pool) {
+    GLES_TRACE_SCOPE("textureCache.store");
+    if (!image.valid() || image.pixels.empty()) {
+        return false;
+    }
+    std::string key, cachePath;
+    if (!makeKey(sourcePath, key, cachePath)) {
+        return false;
+    }
+
+    std::vector<unsigned char> blocks;
+    encodeEtc2(image, blocks, pool);
+
+    // 键值对: 大小 + "key\0value\0", 按4字节补齐
+    auto pairSize = (uint32_t) (sizeof(ktxSourceKey) + key.size() + 1);
+    uint32_t keyValueBytes = (4 + pairSize + 3) & ~3u;
+
+    KtxHeader header;
+    memcpy(header.identifier, ktxIdentifier, sizeof(ktxIdentifier));
+    header.endianness = 0x04030201;
+    header.glType = 0;
+    header.glTypeSize = 1;
+    header.glFormat = 0;
+    header.glInternalFormat = GL_COMPRESSED_RGB8_ETC2;
+    header.glBaseInternalFormat = GL_RGB;
+    header.pixelWidth = (uint32_t) image.width;
+    header.pixelHeight = (uint32_t) image.height;
+    header.pixelDepth = 0;
+    header.numberOfArrayElements = 0;
+    header.numberOfFaces = 1;
+    header.numberOfMipmapLevels = 1;
+    header.bytesOfKeyValueData = keyValueBytes;
+
+    std::vector<unsigned char> keyValue(keyValueBytes, 0);
+    memcpy(&keyValue[0], &pairSize, 4);
+    memcpy(&keyValue[4], ktxSourceKey, sizeof(ktxSourceKey));
+    memcpy(&keyValue[4 + sizeof(ktxSourceKey)], key.c_str(), key.size() + 1);
+    auto imageSize = (uint32_t) blocks.size();
+
+    mkdir(_cacheDir.c_str(), 0755);
+    std::string tmpPath = cachePath + ".tmp." + std::to_string(getpid()) + "." +
+                          std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    FILE *file = fopen(tmpPath.c_str(), "wb");
+    if (!file) {
+        printf("Failed to write texture cache: %s\n", tmpPath.c_str());
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(keyValue.data(), keyValue.size(), 1, file) == 1 &&
+                   fwrite(&imageSize, 4, 1, file) == 1 &&
+                   fwrite(blocks.data(), blocks.size(), 1, file) == 1;
+    written = fclose(file) == 0 && written;
+    if (!written || rename(tmpPath.c_str(), cachePath.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        printf("Failed to write texture cache: %s\n", cachePath.c_str());
+        return false;
+    }
+    return true;
+}
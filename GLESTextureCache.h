@@ -0,0 +1,48 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESTEXTURECACHE_H
+#define GLES_DEMO_GLESTEXTURECACHE_H
+
+#include <GLES3/gl32.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "GLESTextureLoader.h"
+
+/**
+ * 压缩纹理磁盘缓存: 源图片首次加载时编码成ETC2(RGB8, GLES3必须支持), 以KTX格式保存;
+ * 之后启动直接mmap缓存文件, 用glCompressedTexImage2D上传, 省去JPEG解码, 显存也只有RGB的1/6.
+ * 缓存文件名由源路径、修改时间和大小的哈希决定, 源文件变化后自动失效.
+ * load/store只做文件操作, 可以在任意线程调用.
+ */
+class GLESTextureCache {
+public:
+    void setCacheDir(const std::string &cacheDir);
+
+    const std::string &getCacheDir() const;
+
+    bool load(const std::string &sourcePath, GLESImage &image);
+
+    bool store(const std::string &sourcePath, const GLESImage &image, GLESThreadPool *pool = NULL);
+
+    // 把RGB图片编码成ETC2 RGB8块(块内使用ETC1兼容的模式), 宽高不是4的倍数时复制边缘像素补齐
+    static void encodeEtc2(const GLESImage &image, std::vector<unsigned char> &blocks, GLESThreadPool *pool = NULL);
+
+    static size_t getEtc2Size(int width, int height);
+
+    unsigned getHitCount() const;
+
+    unsigned getMissCount() const;
+
+private:
+    bool makeKey(const std::string &sourcePath, std::string &key, std::string &cachePath) const;
+
+    std::string _cacheDir = "texture_cache";
+    std::atomic<unsigned> _hits{0};
+    std::atomic<unsigned> _misses{0};
+};
+
+
+#endif //GLES_DEMO_GLESTEXTURECACHE_H
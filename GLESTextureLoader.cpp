@@ -0,0 +1,349 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESTextureLoader.h"
+#include "GLESTrace.h"
+#include "GLESPixelConvert.h"
+#include "GLESTextureCache.h"
+
+#define DYNAMICGLES_NO_NAMESPACE
+#define DYNAMICEGL_NO_NAMESPACE
+
+#include <DynamicGles.h>
+#include <FreeImage.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+GLESTextureLoader::GLESTextureLoader(GLESThreadPool &pool, GLESStateCache &stateCache)
+        : _pool(pool), _stateCache(stateCache) {
+}
+
+/**
+ * @MethodName: decodeImage
+ * @Return: 解码是否成功
+ * @Description: 解码并转换为紧密排列的RGB, 不调用GL, 可以在任意线程执行
+ */
+bool GLESTextureLoader::decodeImage(const std::string &fileName, GLESImage &image, GLESThreadPool *pool) {
+    GLES_TRACE_SCOPE("decodeImage");
+    //1 获取图片格式
+    FREE_IMAGE_FORMAT fifmt = FreeImage_GetFileType(fileName.c_str(), 0);
+    //2 加载图片
+    FIBITMAP *source = FreeImage_Load(fifmt, fileName.c_str(), 0);
+    if (!source) {
+        printf("Failed to load image: %s\n", fileName.c_str());
+        return false;
+    }
+    //3 转换为rgb24色
+    FIBITMAP *dib = FreeImage_ConvertTo24Bits(source);
+    FreeImage_Unload(source);
+    if (!dib) {
+        return false;
+    }
+
+    image.width = (int) FreeImage_GetWidth(dib);
+    image.height = (int) FreeImage_GetHeight(dib);
+    image.format = GL_RGB;
+    image.pixels.resize((size_t) image.width * image.height * 3);
+
+    //4 FreeImage每行按4字节对齐且存储为BGR, 逐行去掉对齐并翻转成RGB
+    GLESPixelConvert::convertImage(GLESPixelConvert::BGR_TO_RGB, FreeImage_GetBits(dib), FreeImage_GetPitch(dib),
+                                   image.pixels.data(), (size_t) image.width * 3, image.width, image.height, pool);
+
+    //释放内存
+    FreeImage_Unload(dib);
+    return true;
+}
+
+// 行字节数是4的倍数时保持默认对齐, 只有真正需要时才退到1字节对齐
+static GLint unpackAlignment(const GLESImage &image) {
+    return (image.width * image.bytesPerPixel()) % 4 == 0 ? 4 : 1;
+}
+
+/**
+ * @MethodName: uploadImage
+ * @Description: 直接从客户端内存上传, 同步加载和GLES2时使用
+ */
+void GLESTextureLoader::uploadImage(GLuint textureID, const GLESImage &image) {
+    // Use tightly packed data
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment(image));
+
+    // Bind the texture object
+    _stateCache.bindTexture(GL_TEXTURE_2D, textureID);
+
+    // Load the texture
+    glTexImage2D(GL_TEXTURE_2D, 0, image.format, image.width, image.height, 0, image.format, GL_UNSIGNED_BYTE,
+                 image.pixels.data());
+
+    // Set the filtering mode
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void GLESTextureLoader::setUsePixelBuffers(bool usePBO) {
+    _usePBO = usePBO;
+}
+
+void GLESTextureLoader::setTextureCache(GLESTextureCache *cache) {
+    _cache = cache;
+}
+
+/**
+ * @MethodName: loadAsync
+ * @Return: 纹理句柄, 纹理对象立即可用
+ * @Description: 先创建1x1灰色占位纹理, 再把解码任务交给线程池.
+ *               有压缩缓存时直接读缓存; 未命中则先上传未压缩数据, 同时在后台编码ETC2写入缓存供下次启动使用
+ */
+GLESTextureHandle GLESTextureLoader::loadAsync(const std::string &fileName) {
+    PendingTexture pending;
+    pending.fileName = fileName;
+
+    glGenTextures(1, &pending.textureID);
+    const unsigned char placeholder[] = {128, 128, 128};
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    _stateCache.bindTexture(GL_TEXTURE_2D, pending.textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, placeholder);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    auto prefetched = _prefetched.find(fileName);
+    if (prefetched != _prefetched.end() && (_cache || !prefetched->second.usedCache)) {
+        pending.image = prefetched->second.image;
+    } else {
+        GLESThreadPool *pool = &_pool;
+        GLESTextureCache *cache = _cache;
+        pending.image = _pool.submit([fileName, pool, cache]() { return loadImage(fileName, pool, cache); }).share();
+    }
+
+    GLESTextureHandle handle;
+    handle.textureID = pending.textureID;
+    handle.ready = pending.ready.get_future().share();
+    _pending.push_back(std::move(pending));
+    return handle;
+}
+
+GLESImage GLESTextureLoader::loadImage(const std::string &fileName, GLESThreadPool *pool, GLESTextureCache *cache) {
+    GLESImage image;
+    if (cache && cache->load(fileName, image)) {
+        return image;
+    }
+    decodeImage(fileName, image, pool);
+    if (cache && image.valid()) {
+        // 编码比较慢, 单独作为任务执行, 不耽误本次上传
+        auto source = std::make_shared<GLESImage>(image);
+        pool->submit([cache, fileName, source, pool]() { cache->store(fileName, *source, pool); });
+    }
+    return image;
+}
+
+void GLESTextureLoader::setPrefetched(const std::string &fileName, std::shared_future<GLESImage> image,
+                                      bool usedCache) {
+    _prefetched[fileName] = {std::move(image), usedCache};
+}
+
+void GLESTextureLoader::clearPrefetched() {
+    _prefetched.clear();
+}
+
+/**
+ * @MethodName: loadTextureArray
+ * @Return: 纹理数组对象, 没有可用图片时返回0
+ * @Description: 在线程池中并行解码, 尺寸与第一张不同的图片被跳过, layerCount返回实际层数.
+ *               所有层都命中同一种压缩格式时直接上传压缩数据; 否则统一按RGB上传并生成mipmap,
+ *               缩小成很多小图块显示时不会闪烁
+ */
+GLuint GLESTextureLoader::loadTextureArray(const std::vector<std::string> &fileNames, GLsizei &layerCount) {
+    layerCount = 0;
+    GLESThreadPool *pool = &_pool;
+    GLESTextureCache *cache = _cache;
+    std::vector<std::future<GLESImage> > decoding;
+    for (const std::string &fileName : fileNames) {
+        decoding.push_back(_pool.submit([fileName, pool, cache]() {
+            GLESImage image;
+            if (!cache || !cache->load(fileName, image)) {
+                decodeImage(fileName, image, pool);
+            }
+            return image;
+        }));
+    }
+
+    std::vector<GLESImage> layers;
+    std::vector<std::string> layerFiles;
+    for (size_t i = 0; i < decoding.size(); ++i) {
+        GLESImage image = decoding[i].get();
+        if (!image.valid()) {
+            continue;
+        }
+        if (!layers.empty() && (image.width != layers[0].width || image.height != layers[0].height)) {
+            printf("Texture array: %s is %dx%d, expected %dx%d, skipped\n", fileNames[i].c_str(),
+                   image.width, image.height, layers[0].width, layers[0].height);
+            continue;
+        }
+        layers.push_back(std::move(image));
+        layerFiles.push_back(fileNames[i]);
+    }
+    if (layers.empty()) {
+        return 0;
+    }
+
+    bool compressed = true;
+    for (const GLESImage &image : layers) {
+        compressed = compressed && image.compressed.data && image.compressed.format == layers[0].compressed.format;
+    }
+    // 混合了压缩和未压缩数据时, 压缩的那几层重新解码
+    if (!compressed) {
+        for (size_t i = 0; i < layers.size(); ++i) {
+            if (layers[i].pixels.empty()) {
+                GLESImage image;
+                decodeImage(layerFiles[i], image, pool);
+                layers[i] = std::move(image);
+            }
+        }
+    }
+
+    int width = layers[0].width;
+    int height = layers[0].height;
+    auto levels = compressed ? 1 : (GLsizei) std::floor(std::log2((double) std::max(width, height))) + 1;
+
+    GLuint textureID = 0;
+    glGenTextures(1, &textureID);
+    _stateCache.bindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, compressed ? layers[0].compressed.format : GL_RGB8, width, height,
+                   (GLsizei) layers.size());
+    for (size_t i = 0; i < layers.size(); ++i) {
+        const GLESImage &image = layers[i];
+        if (compressed) {
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint) i, width, height, 1,
+                                      image.compressed.format, (GLsizei) image.compressed.size,
+                                      image.compressed.data);
+        } else if (image.pixels.size() == (size_t) width * height * 3) {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment(image));
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint) i, width, height, 1, GL_RGB, GL_UNSIGNED_BYTE,
+                            image.pixels.data());
+        }
+    }
+    if (levels > 1) {
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    if (glGetError() != GL_NO_ERROR) {
+        printf("Failed to upload texture array\n");
+        _stateCache.deleteTextures(1, &textureID);
+        return 0;
+    }
+    layerCount = (GLsizei) layers.size();
+    return textureID;
+}
+
+/**
+ * @MethodName: pumpUploads
+ * @Return: 本次上传的纹理个数
+ * @Description: 在GL线程每帧调用, 上传已经解码完成的图片, maxUploads限制单帧上传量避免卡顿
+ */
+int GLESTextureLoader::pumpUploads(int maxUploads) {
+    GLES_TRACE_SCOPE("pumpUploads");
+    int uploaded = 0;
+    for (size_t i = 0; i < _pending.size() && (maxUploads < 0 || uploaded < maxUploads);) {
+        PendingTexture &pending = _pending[i];
+        if (pending.image.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++i;
+            continue;
+        }
+
+        // 同一张预取的图片可能被多个纹理共用, 不拷贝
+        const GLESImage &image = pending.image.get();
+        if (image.valid()) {
+            upload(pending.textureID, image);
+            ++uploaded;
+        }
+        pending.ready.set_value(image.valid());
+        _pending.erase(_pending.begin() + i);
+    }
+    return uploaded;
+}
+
+/**
+ * @MethodName: finish
+ * @Description: 阻塞直到所有纹理上传完成
+ */
+void GLESTextureLoader::finish() {
+    while (!_pending.empty()) {
+        _pending.front().image.wait();
+        pumpUploads();
+    }
+}
+
+size_t GLESTextureLoader::getPendingCount() const {
+    return _pending.size();
+}
+
+/**
+ * @MethodName: upload
+ * @Description: GLES3下先把像素写进PBO, glTexImage2D从PBO取数据, 驱动可以异步完成拷贝
+ */
+void GLESTextureLoader::upload(GLuint textureID, const GLESImage &image) {
+    GLES_TRACE_SCOPE("uploadTexture");
+    // 压缩数据直接从mmap的缓存文件上传
+    if (image.compressed.data) {
+        _stateCache.bindTexture(GL_TEXTURE_2D, textureID);
+        glCompressedTexImage2D(GL_TEXTURE_2D, 0, image.compressed.format, image.width, image.height, 0,
+                               (GLsizei) image.compressed.size, image.compressed.data);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        return;
+    }
+
+    if (!_usePBO) {
+        uploadImage(textureID, image);
+        return;
+    }
+
+    if (!_pixelBuffers[0]) {
+        glGenBuffers(2, _pixelBuffers);
+    }
+    GLuint pixelBuffer = _pixelBuffers[_nextPixelBuffer];
+    _nextPixelBuffer = (_nextPixelBuffer + 1) % 2;
+
+    auto size = (GLsizeiptr) image.pixels.size();
+    _stateCache.bindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+    // 先孤立旧的存储, 不必等待驱动读完上一次的数据
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!mapped) {
+        _stateCache.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        uploadImage(textureID, image);
+        return;
+    }
+    memcpy(mapped, image.pixels.data(), image.pixels.size());
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment(image));
+    _stateCache.bindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, image.format, image.width, image.height, 0, image.format, GL_UNSIGNED_BYTE,
+                 (const void *) 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    _stateCache.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void GLESTextureLoader::release() {
+    // 等待解码任务结束, 避免线程池在对象销毁后还写结果
+    for (PendingTexture &pending : _pending) {
+        pending.image.wait();
+        pending.ready.set_value(false);
+        _stateCache.deleteTextures(1, &pending.textureID);
+    }
+    _pending.clear();
+    _prefetched.clear();
+    if (_pixelBuffers[0]) {
+        _stateCache.deleteBuffers(2, _pixelBuffers);
+        _pixelBuffers[0] = _pixelBuffers[1] = 0;
+    }
+}
@@ -0,0 +1,117 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESTEXTURELOADER_H
+#define GLES_DEMO_GLESTEXTURELOADER_H
+
+#include <GLES3/gl32.h>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "GLESStateCache.h"
+#include "GLESThreadPool.h"
+
+class GLESTextureCache;
+
+// 压缩纹理数据, data可能直接指向mmap的缓存文件, storage负责保持映射有效
+struct GLESCompressedImage {
+    GLenum format = 0;
+    const unsigned char *data = NULL;
+    size_t size = 0;
+    std::shared_ptr<void> storage;
+};
+
+// 解码后的图片, 行紧密排列, 与FreeImage一致按自下而上存放(对应GL纹理坐标原点在左下)
+struct GLESImage {
+    int width = 0;
+    int height = 0;
+    // GL_RGB或GL_RGBA
+    GLenum format = GL_RGB;
+    std::vector<unsigned char> pixels;
+    // 命中压缩纹理缓存时pixels为空
+    GLESCompressedImage compressed;
+
+    bool valid() const { return width > 0 && height > 0 && (!pixels.empty() || compressed.data); }
+
+    int bytesPerPixel() const { return format == GL_RGBA ? 4 : 3; }
+};
+
+// 异步纹理句柄: 纹理对象立即可用(先是占位纹理), ready在真正上传完成后置位
+struct GLESTextureHandle {
+    GLuint textureID = 0;
+    std::shared_future<bool> ready;
+};
+
+/**
+ * 异步纹理加载: 工作线程解码和转换像素, GL线程通过PBO上传.
+ * 除decodeImage外的所有方法都必须在GL线程调用.
+ */
+class GLESTextureLoader {
+public:
+    GLESTextureLoader(GLESThreadPool &pool, GLESStateCache &stateCache);
+
+    static bool decodeImage(const std::string &fileName, GLESImage &image, GLESThreadPool *pool = NULL);
+
+    // 先查压缩纹理缓存, 未命中时解码并把编码写缓存作为单独的任务; cache为NULL时只解码. 不需要GL上下文
+    static GLESImage loadImage(const std::string &fileName, GLESThreadPool *pool, GLESTextureCache *cache);
+
+    void uploadImage(GLuint textureID, const GLESImage &image);
+
+    void setUsePixelBuffers(bool usePBO);
+
+    // 设置压缩纹理缓存, NULL表示不使用(如不支持ETC2时)
+    void setTextureCache(GLESTextureCache *cache);
+
+    GLESTextureHandle loadAsync(const std::string &fileName);
+
+    /**
+     * 登记创建上下文之前就开始加载的图片, 之后loadAsync遇到同名文件时不再重新解码
+     * usedCache为加载时是否查了压缩纹理缓存; 驱动不支持压缩格式(没有设置缓存)时不使用这样的结果
+     */
+    void setPrefetched(const std::string &fileName, std::shared_future<GLESImage> image, bool usedCache);
+
+    // 释放没有用到的预取结果
+    void clearPrefetched();
+
+    // 同步加载为GL_TEXTURE_2D_ARRAY, 每张图一层, 只支持GLES3
+    GLuint loadTextureArray(const std::vector<std::string> &fileNames, GLsizei &layerCount);
+
+    int pumpUploads(int maxUploads = -1);
+
+    void finish();
+
+    size_t getPendingCount() const;
+
+    void release();
+
+private:
+    struct PendingTexture {
+        GLuint textureID;
+        std::string fileName;
+        std::shared_future<GLESImage> image;
+        std::promise<bool> ready;
+    };
+
+    struct Prefetched {
+        std::shared_future<GLESImage> image;
+        bool usedCache;
+    };
+
+    void upload(GLuint textureID, const GLESImage &image);
+
+    GLESThreadPool &_pool;
+    GLESStateCache &_stateCache;
+    bool _usePBO = false;
+    GLESTextureCache *_cache = NULL;
+    // 两个PBO轮流使用, 驱动还在读上一个时可以写下一个
+    GLuint _pixelBuffers[2] = {0, 0};
+    int _nextPixelBuffer = 0;
+    std::vector<PendingTexture> _pending;
+    std::map<std::string, Prefetched> _prefetched;
+};
+
+
+#endif //GLES_DEMO_GLESTEXTURELOADER_H
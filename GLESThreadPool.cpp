@@ -0,0 +1,122 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESThreadPool.h"
+#include "GLESTrace.h"
+
+#include <algorithm>
+#include <atomic>
+
+GLESThreadPool::GLESThreadPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        _workers.emplace_back(&GLESThreadPool::workerLoop, this);
+    }
+}
+
+GLESThreadPool::~GLESThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_all();
+    for (std::thread &worker : _workers) {
+        worker.join();
+    }
+}
+
+void GLESThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+    _condition.notify_one();
+}
+
+void GLESThreadPool::workerLoop() {
+    GLES_TRACE_THREAD_NAME("pool worker");
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+            // 退出前先把队列里的任务做完
+            if (_tasks.empty()) {
+                return;
+            }
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+            ++_activeTasks;
+        }
+        task();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_activeTasks == 0 && _tasks.empty()) {
+                _idleCondition.notify_all();
+            }
+        }
+    }
+}
+
+void GLESThreadPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idleCondition.wait(lock, [this]() { return _tasks.empty() && _activeTasks == 0; });
+}
+
+/**
+ * @MethodName: parallelFor
+ * @Description: 块由原子计数器领取, 调用线程自己也领取, 所以在工作线程里嵌套调用也不会死锁
+ */
+void GLESThreadPool::parallelFor(int begin, int end, int minChunk, const std::function<void(int, int)> &body) {
+    if (end <= begin) {
+        return;
+    }
+    int count = end - begin;
+    int chunk = std::max(minChunk, 1);
+    int chunkCount = (count + chunk - 1) / chunk;
+    if (chunkCount == 1 || _workers.empty()) {
+        body(begin, end);
+        return;
+    }
+
+    struct SharedState {
+        std::atomic<int> next{0};
+        std::atomic<int> finished{0};
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    auto state = std::make_shared<SharedState>();
+
+    // body的生命周期由调用方保证: 所有块完成前本函数不会返回
+    const std::function<void(int, int)> *bodyPtr = &body;
+    auto runChunks = [state, bodyPtr, begin, end, chunk, chunkCount]() {
+        for (;;) {
+            int index = state->next.fetch_add(1);
+            if (index >= chunkCount) {
+                return;
+            }
+            int chunkBegin = begin + index * chunk;
+            (*bodyPtr)(chunkBegin, std::min(end, chunkBegin + chunk));
+            if (state->finished.fetch_add(1) + 1 == chunkCount) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->done.notify_all();
+            }
+        }
+    };
+
+    int helpers = std::min<int>((int) _workers.size(), chunkCount - 1);
+    for (int i = 0; i < helpers; ++i) {
+        enqueue(runChunks);
+    }
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state, chunkCount]() { return state->finished.load() == chunkCount; });
+}
+
+unsigned GLESThreadPool::getThreadCount() const {
+    return (unsigned) _workers.size();
+}
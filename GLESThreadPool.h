@@ -0,0 +1,64 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESTHREADPOOL_H
+#define GLES_DEMO_GLESTHREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * 固定线程数的工作线程池, 用于图片解码、像素转换等与GL上下文无关的任务.
+ */
+class GLESThreadPool {
+public:
+    // threadCount为0时使用硬件线程数
+    explicit GLESThreadPool(unsigned threadCount = 0);
+
+    ~GLESThreadPool();
+
+    GLESThreadPool(const GLESThreadPool &) = delete;
+
+    GLESThreadPool &operator=(const GLESThreadPool &) = delete;
+
+    template<typename F>
+    std::future<typename std::result_of<F()>::type> submit(F task) {
+        typedef typename std::result_of<F()>::type Result;
+        auto packaged = std::make_shared<std::packaged_task<Result()> >(std::move(task));
+        std::future<Result> future = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); });
+        return future;
+    }
+
+    // 把[begin, end)切成若干块并行执行, 调用线程也参与, 全部完成后返回
+    void parallelFor(int begin, int end, int minChunk, const std::function<void(int, int)> &body);
+
+    // 等待队列清空且没有任务在执行, 不能在工作线程里调用
+    void waitIdle();
+
+    unsigned getThreadCount() const;
+
+private:
+    void enqueue(std::function<void()> task);
+
+    void workerLoop();
+
+    std::vector<std::thread> _workers;
+    std::deque<std::function<void()> > _tasks;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::condition_variable _idleCondition;
+    unsigned _activeTasks = 0;
+    bool _stop = false;
+};
+
+
+#endif //GLES_DEMO_GLESTHREADPOOL_H
@@ -0,0 +1,187 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESTrace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct TraceEvent {
+    const char *name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+// 每个线程一个, 只有所属线程写入; count用release发布, 写文件时按acquire读取已经完整的事件
+struct ThreadBuffer {
+    std::vector<TraceEvent> events;
+    std::atomic<size_t> count{0};
+    std::atomic<uint64_t> dropped{0};
+    int tid = 0;
+    char name[32] = {0};
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static std::atomic<bool> traceEnabled{false};
+static Clock::time_point traceStart;
+static std::string tracePath;
+static size_t traceCapacity = 0;
+
+// 只在线程第一次记录和写文件时加锁; 缓冲在写完文件前不释放, 线程退出后数据仍在
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<ThreadBuffer> > registry;
+
+static thread_local ThreadBuffer *tBuffer = NULL;
+static thread_local char tThreadName[32] = {0};
+
+static ThreadBuffer *acquireBuffer() {
+    if (tBuffer) {
+        return tBuffer;
+    }
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+    buffer->events.resize(traceCapacity);
+    buffer->tid = (int) registry.size() + 1;
+    memcpy(buffer->name, tThreadName, sizeof(buffer->name));
+    tBuffer = buffer.get();
+    registry.push_back(std::move(buffer));
+    return tBuffer;
+}
+
+// 名字里的引号和反斜杠要转义, 埋点名都是常量, 这里只是防御
+static void writeJsonString(FILE *file, const char *text) {
+    fputc('"', file);
+    for (const char *c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+bool GLESTrace::start(const std::string &path, size_t eventsPerThread) {
+    if (!isCompiledIn()) {
+        printf("Tracing is not compiled in (GLES_TRACE=OFF)\n");
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(registryMutex);
+    if (traceEnabled.load()) {
+        return true;
+    }
+    tracePath = path;
+    traceCapacity = std::max<size_t>(eventsPerThread, 1);
+    // 上一次记录留下的线程缓冲按新的容量重新分配, finish时已经清空
+    for (const std::unique_ptr<ThreadBuffer> &buffer : registry) {
+        buffer->events.resize(traceCapacity);
+    }
+    traceStart = Clock::now();
+    traceEnabled.store(true);
+    return true;
+}
+
+bool GLESTrace::startFromEnvironment() {
+    const char *path = getenv("GLES_TRACE");
+    return path && *path && start(path);
+}
+
+bool GLESTrace::isEnabled() {
+    return traceEnabled.load(std::memory_order_relaxed);
+}
+
+void GLESTrace::setThreadName(const char *name) {
+    strncpy(tThreadName, name, sizeof(tThreadName) - 1);
+    if (tBuffer) {
+        memcpy(tBuffer->name, tThreadName, sizeof(tBuffer->name));
+    }
+}
+
+uint64_t GLESTrace::now() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - traceStart).count();
+}
+
+void GLESTrace::record(const char *name, uint64_t begin, uint64_t end) {
+    if (!isEnabled()) {
+        return;
+    }
+    ThreadBuffer *buffer = acquireBuffer();
+    size_t count = buffer->count.load(std::memory_order_relaxed);
+    if (count >= buffer->events.size()) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events[count] = {name, begin, end};
+    buffer->count.store(count + 1, std::memory_order_release);
+}
+
+/**
+ * @MethodName: finish
+ * @Return: 写文件是否成功
+ * @Description: 时间单位为微秒. 每个线程一个tid, 线程名作为元数据事件; 区间按完整事件(ph为X)输出.
+ *               应在其他线程不再记录之后调用, 此后的记录被忽略; 写完后清空各线程的缓冲, 可以再次start
+ */
+bool GLESTrace::finish() {
+    if (!traceEnabled.exchange(false)) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(registryMutex);
+    FILE *file = fopen(tracePath.c_str(), "w");
+    if (!file) {
+        printf("Failed to write trace: %s\n", tracePath.c_str());
+        return false;
+    }
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf(file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"gles\"}}");
+    size_t total = 0;
+    uint64_t dropped = 0;
+    for (const std::unique_ptr<ThreadBuffer> &buffer : registry) {
+        fprintf(file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": ",
+                buffer->tid);
+        writeJsonString(file, buffer->name[0] ? buffer->name : "thread");
+        fprintf(file, "}}");
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            const TraceEvent &event = buffer->events[i];
+            fprintf(file, ",\n{\"name\": ");
+            writeJsonString(file, event.name);
+            fprintf(file, ", \"cat\": \"gles\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                    buffer->tid, (double) event.begin / 1000.0, (double) (event.end - event.begin) / 1000.0);
+        }
+        total += count;
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+        // 清空后再次start不会把这次的事件重复写出
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+    }
+    fprintf(file, "\n]}\n");
+    bool ok = fclose(file) == 0;
+    printf("Trace: %zu events from %zu threads written to %s", total, registry.size(), tracePath.c_str());
+    if (dropped > 0) {
+        printf(", %llu dropped (buffer full)", (unsigned long long) dropped);
+    }
+    printf("\n");
+    return ok;
+}
+
+#ifdef GLES_TRACE
+
+bool GLESTrace::isCompiledIn() {
+    return true;
+}
+
+#else
+
+bool GLESTrace::isCompiledIn() {
+    return false;
+}
+
+#endif
@@ -0,0 +1,75 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESTRACE_H
+#define GLES_DEMO_GLESTRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * 区间埋点: 记录各阶段的开始时间和耗时, 结束时写成Chrome trace-event JSON, 可以直接在Perfetto或chrome://tracing中打开.
+ * 每个线程第一次记录时分配自己的固定容量缓冲, 之后只有本线程写入, 不加锁也不做堆分配; 写满后丢弃并计数.
+ * 名字必须是字符串常量(只保存指针). 未开启时每个埋点只读一次原子标志;
+ * 编译时关闭GLES_TRACE后埋点宏展开为空.
+ */
+class GLESTrace {
+public:
+    // 开始记录, path为输出文件; eventsPerThread为每个线程缓冲的事件数
+    static bool start(const std::string &path, size_t eventsPerThread = 65536);
+
+    // 环境变量GLES_TRACE设置了输出文件时开始记录
+    static bool startFromEnvironment();
+
+    static bool isEnabled();
+
+    // 当前线程在时间线上显示的名字, 可以在start之前调用
+    static void setThreadName(const char *name);
+
+    // 距start的纳秒数
+    static uint64_t now();
+
+    static void record(const char *name, uint64_t begin, uint64_t end);
+
+    // 停止记录并写出文件, 没有开始记录时直接返回true
+    static bool finish();
+
+    static bool isCompiledIn();
+};
+
+// 作用域埋点: 构造时记下开始时间, 析构时记录一个完整区间
+class GLESTraceScope {
+public:
+    explicit GLESTraceScope(const char *name) : _name(GLESTrace::isEnabled() ? name : NULL),
+                                                _begin(_name ? GLESTrace::now() : 0) {
+    }
+
+    ~GLESTraceScope() {
+        if (_name) {
+            GLESTrace::record(_name, _begin, GLESTrace::now());
+        }
+    }
+
+    GLESTraceScope(const GLESTraceScope &) = delete;
+
+    GLESTraceScope &operator=(const GLESTraceScope &) = delete;
+
+private:
+    const char *_name;
+    uint64_t _begin;
+};
+
+#ifdef GLES_TRACE
+#define GLES_TRACE_CONCAT_INNER(a, b) a##b
+#define GLES_TRACE_CONCAT(a, b) GLES_TRACE_CONCAT_INNER(a, b)
+#define GLES_TRACE_SCOPE(name) GLESTraceScope GLES_TRACE_CONCAT(traceScope, __LINE__)(name)
+#define GLES_TRACE_THREAD_NAME(name) GLESTrace::setThreadName(name)
+#else
+#define GLES_TRACE_SCOPE(name) do {} while (0)
+#define GLES_TRACE_THREAD_NAME(name) do {} while (0)
+#endif
+
+
+#endif //GLES_DEMO_GLESTRACE_H
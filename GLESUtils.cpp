@@ -3,17 +3,35 @@
 //
 
 #include "GLESUtils.h"
+#include "GLESTrace.h"
 
 #define DYNAMICGLES_NO_NAMESPACE
 #define DYNAMICEGL_NO_NAMESPACE
 
 #include <DynamicGles.h>
+
+#include <EGL/eglext.h>
+
+#ifndef Headless
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
+#include <sys/select.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <FreeImage.h>
 #include <fstream>
 #include <iostream>
+#include <cstring>
+
+// EGLDisplay是进程级的: 同一个本地显示(离屏模式下总是默认显示)取到的是同一个句柄, eglTerminate会销毁其上所有上下文.
+// 多个实例共用一个EGLDisplay时按引用计数, 最后一个实例释放时才终止
+static std::mutex eglDisplayMutex;
+static std::map<EGLDisplay, int> eglDisplayRefs;
 
 /*!*********************************************************************************************************************
 \param[in]			functionLastCalled          Function which triggered the error
@@ -39,14 +57,9 @@ bool GLESUtils::testEGLError(const char *functionLastCalled) {
 ***********************************************************************************************************************/
 bool GLESUtils::testGLError(const char *functionLastCalled) {
     //	glGetError returns the last error that occurred using OpenGL ES, not necessarily the status of the last called function. The user
-    //	has to check after every single OpenGL ES call or at least once every frame. Usually this would be for debugging only, but for this
-    //	example it is enabled always
-    GLenum lastError = glGetError();
-    if (lastError != GL_NO_ERROR) {
-        printf("%s failed (%x).\n", functionLastCalled, lastError);
-        return false;
-    }
-    return true;
+    //	has to check after every single OpenGL ES call or at least once every frame. Usually this would be for debugging only.
+    // 是否真的调用glGetError由错误检查策略决定, 非strict模式下这里只记录检查点, 不会中止帧
+    return _errorMonitor.check(functionLastCalled);
 }
 
 /*!*********************************************************************************************************************
@@ -55,10 +68,20 @@ bool GLESUtils::testGLError(const char *functionLastCalled) {
 \brief	Creates a native isplay for the application to render into.
 ***********************************************************************************************************************/
 bool GLESUtils::createNativeDisplay() {
+    GLES_TRACE_SCOPE("createNativeDisplay");
+#ifdef Headless
+    // 离屏模式没有本地显示, EGLDisplay直接由surfaceless平台创建
+    _nativeDisplay = NULL;
+    return true;
+#else
     Display **nativeDisplay = &_nativeDisplay;
     // Check for a valid display
     if (!nativeDisplay) { return false; }
 
+    // 每个实例各开一个连接, 在各自的线程里处理消息; Xlib要求在任何其他调用之前开启多线程支持
+    static std::once_flag threadsInitialized;
+    std::call_once(threadsInitialized, [] { XInitThreads(); });
+
     // Open the display
     *nativeDisplay = XOpenDisplay(0);
     if (!*nativeDisplay) {
@@ -66,6 +89,7 @@ bool GLESUtils::createNativeDisplay() {
         return false;
     }
     return true;
+#endif
 }
 
 /*!*********************************************************************************************************************
@@ -75,6 +99,17 @@ bool GLESUtils::createNativeDisplay() {
 \brief	Creates a native window for the application to render into.
 ***********************************************************************************************************************/
 bool GLESUtils::createNativeWindow() {
+    GLES_TRACE_SCOPE("createNativeWindow");
+#ifdef Headless
+    // 离屏模式没有窗口, 渲染目标是createEGLSurface中创建的pbuffer
+    _nativeWindow = 0;
+    return true;
+#else
+    // 离屏渲染只需要X连接来创建EGLDisplay, 不创建窗口
+    if (_offscreen) {
+        _nativeWindow = 0;
+        return true;
+    }
     Window *nativeWindow = &_nativeWindow;
     // Get the default screen for the display
     int defaultScreen = XDefaultScreen(_nativeDisplay);
@@ -124,13 +159,14 @@ bool GLESUtils::createNativeWindow() {
     XMapWindow(_nativeDisplay, *nativeWindow);
 
     // Set the window title
-    XStoreName(_nativeDisplay, *nativeWindow, _appName);
+    XStoreName(_nativeDisplay, *nativeWindow, _appName.c_str());
 
     // Setup the window manager protocols to handle window deletion events
     Atom windowManagerDelete = XInternAtom(_nativeDisplay, "WM_DELETE_WINDOW", True);
     XSetWMProtocols(_nativeDisplay, *nativeWindow, &windowManagerDelete, 1);
 
     return true;
+#endif
 }
 
 
@@ -141,11 +177,31 @@ bool GLESUtils::createNativeWindow() {
 \brief	Creates an EGLDisplay from a native native display, and initializes it.
 ***********************************************************************************************************************/
 bool GLESUtils::createEGLDisplay() {
+    GLES_TRACE_SCOPE("createEGLDisplay");
     //	Get an EGL display.
     //	EGL uses the concept of a "display" which in most environments corresponds to a single physical screen. After creating a native
     //	display for a given windowing system, EGL can use this handle to get a corresponding EGLDisplay handle to it for use in rendering.
     //	Should this fail, EGL is usually able to provide access to a default display.
+    // 获取和初始化与其他实例的终止互斥
+    std::lock_guard<std::mutex> lock(eglDisplayMutex);
+#ifdef Headless
+    //	Without a window system, prefer Mesa's surfaceless platform: it needs neither an X server nor a DRM device, and works with
+    //	llvmpipe. Older EGL stacks without EGL_MESA_platform_surfaceless fall back to the default display.
+    _eglDisplay = EGL_NO_DISPLAY;
+    const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+                (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay) {
+            _eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        }
+    }
+    if (_eglDisplay == EGL_NO_DISPLAY) {
+        _eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+#else
     _eglDisplay = eglGetDisplay((EGLNativeDisplayType) _nativeDisplay);
+#endif
     // If a display couldn't be obtained, return an error.
     if (_eglDisplay == EGL_NO_DISPLAY) {
         printf("Failed to get an EGLDisplay");
@@ -163,6 +219,7 @@ bool GLESUtils::createEGLDisplay() {
         printf("Failed to initialize the EGLDisplay");
         return false;
     }
+    eglDisplayRefs[_eglDisplay]++;
 
     // Bind the correct API
     int result = EGL_FALSE;
@@ -183,16 +240,34 @@ bool GLESUtils::createEGLDisplay() {
 \brief	Chooses an appropriate EGLConfig and return it.
 ***********************************************************************************************************************/
 bool GLESUtils::chooseEGLConfig() {
+    GLES_TRACE_SCOPE("chooseEGLConfig");
     //	Specify the required configuration attributes.
     //	An EGL "configuration" describes the capabilities an application requires and the type of surfaces that can be used for drawing.
     //	Each implementation exposes a number of different configurations, and an application needs to describe to EGL what capabilities it
     //	requires so that an appropriate one can be chosen. The first step in doing this is to create an attribute list, which is an array
     //	of key/value pairs which describe particular capabilities requested. In this application nothing special is required so we can query
     //	the minimum of needing it to render to a window, and being OpenGL ES 2.0 capable.
+    const EGLint surfaceType = _offscreen ? EGL_PBUFFER_BIT : EGL_WINDOW_BIT;
+    //	An OpenGL ES 3 capable config is preferred, so that buffer objects can be paired with vertex array objects. If the implementation
+    //	only offers OpenGL ES 2.0 configs the application still works, just without the GLES3 fast paths.
+    //	Colour sizes are requested explicitly: with none given, EGL sorts the smallest buffer first and e.g. Mesa hands out a dithered
+    //	RGB565 config, so read back frames would not match the source images.
     const EGLint configurationAttributes[] =
             {
-                    EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+                    EGL_SURFACE_TYPE, surfaceType,
+                    EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR,
+                    EGL_RED_SIZE, 8,
+                    EGL_GREEN_SIZE, 8,
+                    EGL_BLUE_SIZE, 8,
+                    EGL_NONE
+            };
+    const EGLint configurationAttributesES2[] =
+            {
+                    EGL_SURFACE_TYPE, surfaceType,
                     EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+                    EGL_RED_SIZE, 8,
+                    EGL_GREEN_SIZE, 8,
+                    EGL_BLUE_SIZE, 8,
                     EGL_NONE
             };
 
@@ -205,11 +280,17 @@ bool GLESUtils::chooseEGLConfig() {
     //	advanced applications choose to do. For this application however, taking the first EGLConfig that the function returns suits
     //	its needs perfectly, so we limit it to returning a single EGLConfig.
     EGLint configsReturned;
-    if (!eglChooseConfig(_eglDisplay, configurationAttributes, &_eglConfig, 1, &configsReturned) ||
+    if (eglChooseConfig(_eglDisplay, configurationAttributes, &_eglConfig, 1, &configsReturned) &&
+        (configsReturned == 1)) {
+        _glesVersion = 3;
+        return true;
+    }
+    if (!eglChooseConfig(_eglDisplay, configurationAttributesES2, &_eglConfig, 1, &configsReturned) ||
         (configsReturned != 1)) {
         printf("Failed to choose a suitable config.");
         return false;
     }
+    _glesVersion = 2;
     return true;
 }
 
@@ -223,6 +304,7 @@ bool GLESUtils::chooseEGLConfig() {
 ***********************************************************************************************************************/
 bool
 GLESUtils::createEGLSurface() {
+    GLES_TRACE_SCOPE("createEGLSurface");
     //	Create an EGLSurface for rendering.
     //	Using a native window created earlier and a suitable _eglConfig, a surface is created that can be used to render OpenGL ES calls to.
     //	There are three main surface types in EGL, which can all be used in the same way once created but work slightly differently:
@@ -231,8 +313,23 @@ GLESUtils::createEGLSurface() {
     //	 - PBuffer Surfaces - These are created directly within EGL, and like Pixmap Surfaces are offscreen and thus not displayed.
     //	The offscreen surfaces are useful for non-rendering contexts and in certain other scenarios, but for most applications the main
     //	surface used will be a window surface as performed below.
+    if (_offscreen) {
+        //	Offscreen instances (always the case in Headless builds) have no window, so a PBuffer of the requested window size is used
+        //	instead. eglSwapBuffers on a PBuffer is a no-op, so the render loop is never throttled by a compositor or vsync.
+        const EGLint pbufferAttributes[] =
+                {
+                        EGL_WIDTH, (EGLint) _winWidth,
+                        EGL_HEIGHT, (EGLint) _winHeight,
+                        EGL_NONE
+                };
+        _eglSurface = eglCreatePbufferSurface(_eglDisplay, _eglConfig, pbufferAttributes);
+        if (!testEGLError("eglCreatePbufferSurface")) { return false; }
+        return true;
+    }
+#ifndef Headless
     _eglSurface = eglCreateWindowSurface(_eglDisplay, _eglConfig, (EGLNativeWindowType) _nativeWindow, NULL);
     if (!testEGLError("eglCreateWindowSurface")) { return false; }
+#endif
     return true;
 }
 
@@ -247,6 +344,7 @@ GLESUtils::createEGLSurface() {
 ***********************************************************************************************************************/
 bool
 GLESUtils::setupEGLContext() {
+    GLES_TRACE_SCOPE("setupEGLContext");
     //	Make OpenGL ES the current API.
     // EGL needs a way to know that any subsequent EGL calls are going to be affecting OpenGL ES,
     // rather than any other API (such as OpenVG).
@@ -258,10 +356,10 @@ GLESUtils::setupEGLContext() {
     //	resources and state. What appear to be "global" functions in OpenGL actually only operate on the current _context. A _context
     //	is required for any operations in OpenGL ES.
     //	Similar to an EGLConfig, a _context takes in a list of attributes specifying some of its capabilities. However in most cases this
-    //	is limited to just requiring the version of the OpenGL ES _context required - In this case, OpenGL ES 2.0.
+    //	is limited to just requiring the version of the OpenGL ES _context required - In this case, the version the chosen config supports.
     EGLint contextAttributes[] =
             {
-                    EGL_CONTEXT_CLIENT_VERSION, 2,
+                    EGL_CONTEXT_CLIENT_VERSION, _glesVersion,
                     EGL_NONE
             };
 
@@ -269,6 +367,7 @@ GLESUtils::setupEGLContext() {
     _context = eglCreateContext(_eglDisplay, _eglConfig, NULL, contextAttributes);
     if (!testEGLError("eglCreateContext")) { return false; }
 
+
     //	Bind the _context to the current thread.
     //	Due to the way OpenGL uses global functions, contexts need to be made current so that any function call can operate on the correct
     //	_context. Specifically, make current will bind the _context to the current rendering thread it's called from. If the calling thread already
@@ -278,9 +377,67 @@ GLESUtils::setupEGLContext() {
     eglMakeCurrent(_eglDisplay, _eglSurface, _eglSurface, _context);
 
     if (!testEGLError("eglMakeCurrent")) { return false; }
+
+    queryCaps();
+    // 新上下文的状态都是默认值, 影子全部作废
+    _stateCache.invalidate();
+
+    // 几何缓存在GLES3下用VAO保存属性布局, 纹理通过PBO上传
+    _geometry.setUseVertexArrays(_caps.vertexArrayObject);
+    _textureLoader.setUsePixelBuffers(_caps.pixelBufferObject);
+    // 不支持ETC2或没有设置缓存目录时不使用压缩缓存, 直接走未压缩路径
+    bool textureCache = _caps.etc2Texture && !_sceneConfig.textureCacheDir.empty();
+    _textureLoader.setTextureCache(textureCache ? &_textureCache : NULL);
+    _playlist.setUseTextureStorage(_glesVersion >= 3);
+    _frameTimer.setUseGpuTimer(_caps.timerQuery);
+    _program.setBinaryRetrievable(_caps.programBinary);
     return true;
 }
 
+/*!*********************************************************************************************************************
+\brief	Queries extension and version dependent capabilities once, right after the context has been made current.
+***********************************************************************************************************************/
+void GLESUtils::queryCaps() {
+    GLES_TRACE_SCOPE("queryCaps");
+    _caps.discardFramebuffer = isGlExtensionSupported("GL_EXT_discard_framebuffer");
+    _caps.vertexArrayObject = _glesVersion >= 3;
+    _caps.pixelBufferObject = _glesVersion >= 3;
+    _caps.timerQuery = isGlExtensionSupported("GL_EXT_disjoint_timer_query");
+    _caps.khrDebug = isGlExtensionSupported("GL_KHR_debug");
+    _caps.invalidateFramebuffer = _glesVersion >= 3;
+    _renderTargets.setCaps(_caps.invalidateFramebuffer, _caps.discardFramebuffer);
+
+    // KHR和EXT两个版本的入口参数相同
+    _swapBuffersWithDamage = NULL;
+    if (isEglExtensionSupported(_eglDisplay, "EGL_KHR_swap_buffers_with_damage")) {
+        _swapBuffersWithDamage = (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC) eglGetProcAddress("eglSwapBuffersWithDamageKHR");
+    } else if (isEglExtensionSupported(_eglDisplay, "EGL_EXT_swap_buffers_with_damage")) {
+        _swapBuffersWithDamage = (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC) eglGetProcAddress("eglSwapBuffersWithDamageEXT");
+    }
+    _caps.swapBuffersWithDamage = _swapBuffersWithDamage != NULL;
+
+    // 程序二进制是GLES3核心功能, 但驱动可以不提供任何二进制格式
+    GLint binaryFormatCount = 0;
+    if (_glesVersion >= 3) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatCount);
+    }
+    _caps.programBinary = binaryFormatCount > 0;
+
+    // ETC2在GLES3中是必须支持的, 这里仍以驱动报告的压缩格式为准
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &formatCount);
+    std::vector<GLint> formats(formatCount > 0 ? formatCount : 0);
+    if (formatCount > 0) {
+        glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+    }
+    _caps.etc2Texture = false;
+    for (GLint format : formats) {
+        if (format == GL_COMPRESSED_RGB8_ETC2) {
+            _caps.etc2Texture = true;
+        }
+    }
+}
+
 /*!*********************************************************************************************************************
 \param[in]			eglDisplay                   The EGLDisplay used by the application
 \brief	Releases all resources allocated by EGL
@@ -290,8 +447,23 @@ void GLESUtils::releaseEGLState(EGLDisplay eglDisplay) {
         // To release the resources in the _context, first the _context has to be released from its binding with the current thread.
         eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
 
+        // 其他实例可能还在使用这个EGLDisplay, 先单独销毁本实例的上下文和surface
+        if (eglDisplay == _eglDisplay) {
+            if (_context) { eglDestroyContext(eglDisplay, _context); }
+            if (_eglSurface) { eglDestroySurface(eglDisplay, _eglSurface); }
+            _context = NULL;
+            _eglSurface = NULL;
+            _eglDisplay = NULL;
+        }
+        eglReleaseThread();
+
         // Terminate the display, and any resources associated with it (including the EGLContext)
-        eglTerminate(eglDisplay);
+        std::lock_guard<std::mutex> lock(eglDisplayMutex);
+        auto ref = eglDisplayRefs.find(eglDisplay);
+        if (ref != eglDisplayRefs.end() && --ref->second == 0) {
+            eglDisplayRefs.erase(ref);
+            eglTerminate(eglDisplay);
+        }
     }
 }
 
@@ -301,11 +473,74 @@ void GLESUtils::releaseEGLState(EGLDisplay eglDisplay) {
 \brief	Releases all resources allocated by the windowing system
 ***********************************************************************************************************************/
 void GLESUtils::releaseNativeResources(Display *nativeDisplay, Window nativeWindow) {
+#ifndef Headless
     // Destroy the window
     if (nativeWindow) { XDestroyWindow(nativeDisplay, nativeWindow); }
 
     // Release the display.
     if (nativeDisplay) { XCloseDisplay(nativeDisplay); }
+#endif
+}
+
+/*!*********************************************************************************************************************
+\return		False if the windowing system asked the application to quit
+\brief	Processes pending messages from the windowing system.
+***********************************************************************************************************************/
+bool GLESUtils::handleNativeEvents() {
+#ifndef Headless
+    if (!_nativeWindow) { return true; }
+
+    // Check for messages from the windowing system.
+    int numberOfMessages = XPending(_nativeDisplay);
+    for (int i = 0; i < numberOfMessages; i++) {
+        XEvent event;
+        XNextEvent(_nativeDisplay, &event);
+
+        switch (event.type) {
+            // Exit on window close
+            case ClientMessage:
+                // Exit on mouse click
+            case ButtonPress:
+            case DestroyNotify:
+                return false;
+            // 窗口内容被覆盖或尺寸变化, 下一帧即使没有变化也要重画
+            case Expose:
+            case ConfigureNotify:
+                _redrawPending = true;
+                break;
+            default:
+                break;
+        }
+    }
+#endif
+    return true;
+}
+
+/**
+ * @MethodName: waitNativeEvents
+ * @Return: 窗口系统是否要求退出
+ * @Description: 画面静止时代替绘制和交换: 阻塞到窗口消息到达或超时, 超时是为了继续检查后台上传和时间驱动的变化
+ */
+bool GLESUtils::waitNativeEvents(int timeoutMs) {
+    GLES_TRACE_SCOPE("idleWait");
+#ifndef Headless
+    if (_nativeWindow) {
+        XFlush(_nativeDisplay);
+        if (XPending(_nativeDisplay) == 0) {
+            int fd = ConnectionNumber(_nativeDisplay);
+            fd_set readFds;
+            FD_ZERO(&readFds);
+            FD_SET(fd, &readFds);
+            timeval timeout;
+            timeout.tv_sec = timeoutMs / 1000;
+            timeout.tv_usec = (timeoutMs % 1000) * 1000;
+            select(fd + 1, &readFds, NULL, NULL, &timeout);
+        }
+        return handleNativeEvents();
+    }
+#endif
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+    return handleNativeEvents();
 }
 
 /*!*********************************************************************************************************************
@@ -316,14 +551,39 @@ void GLESUtils::releaseNativeResources(Display *nativeDisplay, Window nativeWind
 \brief	Releases the resources created by "InitializeGLState"
 ***********************************************************************************************************************/
 void GLESUtils::deInitGLState() {
+    GLES_TRACE_SCOPE("deInitGLState");
     // Frees the OpenGL handles for the program and the 2 shaders
     glDeleteShader(_fragmentShader);
     glDeleteShader(_vertexShader);
 
     // Delete texture object
-    glDeleteTextures(1, &_textureID);
+    _textureLoader.release();
+    _playlist.release();
+    _video.release();
+    _stateCache.deleteTextures(1, &_textureID);
+    if (!_vectorTextureID.empty()) {
+        _stateCache.deleteTextures((GLsizei) _vectorTextureID.size(), _vectorTextureID.data());
+        _vectorTextureID.clear();
+    }
 
-    glDeleteProgram(_shaderProgram);
+    // 释放缓冲对象和VAO
+    _geometry.release();
+    _quadMesh = -1;
+    _stateCache.deleteTextures(1, &_tileTexture);
+    _tileTexture = 0;
+    _tileLayers = _tileCount = 0;
+
+    _program.release();
+    _frameTimer.release();
+    // 截帧先把在途的帧取回写完
+    _capture.finish();
+    _capture.release();
+    _resolution.release();
+    _postProcess.release();
+    _renderTargets.release();
+    // 取出还没上报的错误后输出汇总
+    _errorMonitor.release();
+    _errorMonitor.printSummary(stdout);
 }
 
 Display *GLESUtils::getNativeDisplay() {
@@ -343,60 +603,50 @@ Window GLESUtils::getNativeWindow() {
 }
 
 GLuint GLESUtils::loadTexture(std::string fileName) {
-    //unsigned textureId = 0;
-    GLuint textureId = 0;
-    //1 获取图片格式
-    FREE_IMAGE_FORMAT fifmt = FreeImage_GetFileType(fileName.c_str(), 0);
-    //2 加载图片
-    FIBITMAP *dib = FreeImage_Load(fifmt, fileName.c_str(), 0);
-    //3 转换为rgb24色
-    dib = FreeImage_ConvertTo24Bits(dib);
-
-    //4 获取数据指针
-    BYTE *pixels = (BYTE *) FreeImage_GetBits(dib);
-
-    int width = FreeImage_GetWidth(dib);
-    int height = FreeImage_GetHeight(dib);
-
-    //window存储颜色的格式是BGR,opengl的格式是RGB  所以需要翻转
-    int i = 0;
-    for (i = 0; i < width * height * 3; i += 3) {
-        BYTE temp = pixels[i];
-        pixels[i] = pixels[i + 2];
-        pixels[i + 2] = temp;
+    GLES_TRACE_SCOPE("loadTexture");
+    GLESImage image;
+    if (!GLESTextureLoader::decodeImage(fileName, image)) {
+        return 0;
     }
 
-    // Use tightly packed data
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
     // Generate a texture object
+    GLuint textureId = 0;
     glGenTextures(1, &textureId);
-
-    // Bind the texture object
-    glBindTexture(GL_TEXTURE_2D, textureId);
-
-    // Load the texture
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels);
-
-    // Set the filtering mode
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    //释放内存
-    FreeImage_Unload(dib);
+    _textureLoader.uploadImage(textureId, image);
     return textureId;
 }
 
+/**
+ * @MethodName: loadMoreTexture
+ * @Return: 纹理id, 返回时已全部上传
+ * @Description: 多张图片在线程池中并行解码
+ */
 std::vector<GLuint> GLESUtils::loadMoreTexture(std::vector<std::string> fileNames) {
-    std::vector<GLuint> vectorTextureId(fileNames.size());
-    for (int i = 0; i < fileNames.size(); ++i) {
-//        std::cout << fileNames[i] << std::endl;
-        vectorTextureId[i] = loadTexture(fileNames[i]);
-    }
+    GLES_TRACE_SCOPE("loadMoreTexture");
+    std::vector<GLESTextureHandle> handles = loadMoreTextureAsync(fileNames);
+    _textureLoader.finish();
 
+    std::vector<GLuint> vectorTextureId(handles.size());
+    for (size_t i = 0; i < handles.size(); ++i) {
+        vectorTextureId[i] = handles[i].textureID;
+    }
     return vectorTextureId;
 }
 
+/**
+ * @MethodName: loadMoreTextureAsync
+ * @Return: 纹理句柄, 纹理先是占位内容, renderScene每帧上传已解码好的图片
+ * @Description: 异步加载多张图片
+ */
+std::vector<GLESTextureHandle> GLESUtils::loadMoreTextureAsync(const std::vector<std::string> &fileNames) {
+    GLES_TRACE_SCOPE("loadMoreTextureAsync");
+    std::vector<GLESTextureHandle> handles(fileNames.size());
+    for (size_t i = 0; i < fileNames.size(); ++i) {
+        handles[i] = _textureLoader.loadAsync(fileNames[i]);
+    }
+    return handles;
+}
+
 std::string GLESUtils::readShader(std::string path) {
     std::ifstream in(path);
     std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
@@ -409,6 +659,8 @@ void GLESUtils::cleanProc() {
 
     // Release the windowing system resources
     releaseNativeResources(_nativeDisplay, _nativeWindow);
+    _nativeDisplay = NULL;
+    _nativeWindow = 0;
 }
 
 
@@ -460,7 +712,25 @@ unsigned int GLESUtils::getWindowHeight() {
 }
 
 void GLESUtils::setAppName(std::string appName) {
-    _appName = const_cast<char *>(appName.c_str());
+    _appName = appName;
+}
+
+void GLESUtils::setOffscreen(bool offscreen) {
+#ifndef Headless
+    _offscreen = offscreen;
+#endif
+}
+
+bool GLESUtils::isOffscreen() {
+    return _offscreen;
+}
+
+void GLESUtils::setSceneConfig(const GLESSceneConfig &config) {
+    _sceneConfig = config;
+}
+
+GLESSceneConfig &GLESUtils::getSceneConfig() {
+    return _sceneConfig;
 }
 
 void GLESUtils::setTextureSize(int size) {
@@ -472,6 +742,7 @@ int GLESUtils::getTextureSize() {
 }
 
 bool GLESUtils::createShader(std::string shaderPath, int type) {
+    GLES_TRACE_SCOPE("createShader");
     // Create a shader object
     GLuint shader = 0;
     shader = glCreateShader(type);
@@ -512,6 +783,64 @@ bool GLESUtils::createShader(std::string shaderPath, int type) {
     return true;
 }
 
+/**
+ * @MethodName: buildProgram
+ * @Return: 程序是否可用
+ * @Description: 先按源码和驱动信息查程序二进制缓存, 命中且驱动接受时跳过编译和链接;
+ *               否则从源码编译链接, 成功后把二进制写回缓存
+ */
+bool GLESUtils::buildProgram(const std::string &vshSource, const std::string &fshSource,
+                             const std::vector<std::pair<GLuint, std::string> > &attribBindings) {
+    GLES_TRACE_SCOPE("buildProgram");
+    auto begin = std::chrono::steady_clock::now();
+    _programFromCache = false;
+
+    // 缓存目录为空表示不使用程序缓存
+    bool useCache = _caps.programBinary && !_programCache.getCacheDir().empty();
+    std::string key;
+    if (useCache) {
+        std::string driver = std::string((const char *) glGetString(GL_VENDOR)) + "|" +
+                             (const char *) glGetString(GL_RENDERER) + "|" + (const char *) glGetString(GL_VERSION);
+        std::vector<std::string> sources = {vshSource, fshSource};
+        for (const auto &binding : attribBindings) {
+            sources.push_back(std::to_string(binding.first) + binding.second);
+        }
+        key = GLESProgramCache::makeKey(driver, sources);
+
+        GLenum binaryFormat = 0;
+        std::vector<unsigned char> binary;
+        if (_programCache.load(key, binaryFormat, binary) &&
+            _program.loadBinary(binaryFormat, binary.data(), (GLsizei) binary.size())) {
+            _programFromCache = true;
+        }
+    }
+
+    if (!_programFromCache) {
+        bool fragResult = createShader(fshSource, GL_FRAGMENT_SHADER);
+        bool vertResult = createShader(vshSource, GL_VERTEX_SHADER);
+        if (!fragResult || !vertResult || !_program.link(_vertexShader, _fragmentShader, attribBindings)) {
+            return false;
+        }
+
+        GLenum binaryFormat = 0;
+        std::vector<unsigned char> binary;
+        if (useCache && _program.getBinary(binaryFormat, binary)) {
+            _programCache.store(key, binaryFormat, binary);
+        }
+    }
+
+    _programSetupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    return true;
+}
+
+double GLESUtils::getProgramSetupMs() {
+    return _programSetupMs;
+}
+
+bool GLESUtils::isProgramFromCache() {
+    return _programFromCache;
+}
+
 GLuint &GLESUtils::getFragmentShader() {
     return _fragmentShader;
 }
@@ -521,7 +850,7 @@ GLuint &GLESUtils::getVertexShader() {
 }
 
 GLuint GLESUtils::getShaderProgram() {
-    return _shaderProgram;
+    return _program.getProgram();
 }
 
 void GLESUtils::setFragmentShader(GLuint shader) {
@@ -532,25 +861,212 @@ void GLESUtils::setVectorShader(GLuint shader) {
     _vertexShader = shader;
 }
 
-void GLESUtils::initNativeAndEGL() {
-    // Get access to a native display
-    if (!createNativeDisplay()) { cleanProc(); }
+int GLESUtils::getGlesVersion() {
+    return _glesVersion;
+}
 
-    // Setup the windowing system, create a window
-    if (!createNativeWindow()) { cleanProc(); }
+GLESGeometry &GLESUtils::getGeometry() {
+    return _geometry;
+}
 
-    // Create and Initialize an EGLDisplay from the native display
-    if (!createEGLDisplay()) { cleanProc(); }
+GLESProgram &GLESUtils::getProgram() {
+    return _program;
+}
 
-    // Choose an EGLConfig for the application, used when setting up the rendering surface and EGLContext
-    if (!chooseEGLConfig()) { cleanProc(); }
+GLESStateCache &GLESUtils::getStateCache() {
+    return _stateCache;
+}
 
-    // Create an EGLSurface for rendering from the native window
-    if (!createEGLSurface()) { cleanProc(); }
+GLESProgramCache &GLESUtils::getProgramCache() {
+    return _programCache;
+}
 
-    // Setup the EGL Context from the other EGL constructs created so far, so that the application is ready to submit OpenGL ES commands
-    if (!setupEGLContext()) { cleanProc(); }
+GLESShaderPreprocessor &GLESUtils::getShaderPreprocessor() {
+    return _shaderPreprocessor;
+}
+
+const GLESCaps &GLESUtils::getCaps() {
+    return _caps;
+}
+
+GLESFrameArena &GLESUtils::getFrameArena() {
+    return _frameArena;
+}
+
+const GLESFrameStats &GLESUtils::getFrameStats() {
+    return _frameStats;
+}
+
+GLESThreadPool &GLESUtils::getThreadPool() {
+    return _threadPool;
+}
+
+GLESTextureLoader &GLESUtils::getTextureLoader() {
+    return _textureLoader;
+}
+
+GLESPlaylist &GLESUtils::getPlaylist() {
+    return _playlist;
+}
+
+GLESVideoSource &GLESUtils::getVideoSource() {
+    return _video;
+}
+
+GLESFrameCapture &GLESUtils::getFrameCapture() {
+    return _capture;
+}
+
+GLESTextureCache &GLESUtils::getTextureCache() {
+    return _textureCache;
+}
+
+GLESFrameTimer &GLESUtils::getFrameTimer() {
+    return _frameTimer;
+}
+
+GLESDynamicResolution &GLESUtils::getDynamicResolution() {
+    return _resolution;
+}
+
+GLESErrorMonitor &GLESUtils::getErrorMonitor() {
+    return _errorMonitor;
+}
+
+GLESRenderTargetPool &GLESUtils::getRenderTargetPool() {
+    return _renderTargets;
+}
+
+GLESPostProcess &GLESUtils::getPostProcess() {
+    return _postProcess;
+}
+
+GLESStartupGraph &GLESUtils::getStartupGraph() {
+    return _startup;
+}
+
+/**
+ * @MethodName: beginFrame
+ * @Description: 回收上一帧的临时内存, 记录分配计数起点和帧开始时间
+ */
+void GLESUtils::beginFrame() {
+    _frameTimer.beginFrame();
+    _frameArena.reset();
+    _frameAllocStart = getAllocCounters();
+    _stateCache.resetCounters();
+    _frameStats.presented = false;
+}
+
+/**
+ * @MethodName: endFrame
+ * @Description: 统计本帧的堆分配次数、字节数、经过状态缓存的GL调用数, 以及是否跳过了绘制
+ */
+void GLESUtils::endFrame() {
+    GLESAllocCounters now = getAllocCounters();
+    _frameStats.frameIndex++;
+    _frameStats.allocCount = now.allocCount - _frameAllocStart.allocCount;
+    _frameStats.allocBytes = now.allocBytes - _frameAllocStart.allocBytes;
+    _frameStats.arenaUsed = _frameArena.getUsed();
+    _frameStats.glCallsIssued = _stateCache.getCounters().issued;
+    _frameStats.glCallsElided = _stateCache.getCounters().elided;
+    if (_frameStats.presented) {
+        _frameStats.redrawnFrames++;
+    } else {
+        _frameStats.skippedFrames++;
+    }
+    _frameTimer.setPresented(_frameStats.presented);
+    _frameTimer.endFrame();
+    _renderTargets.endFrame();
+    _errorMonitor.endFrame();
+}
 
+/**
+ * @MethodName: initNativeAndEGL
+ * @Return: 上下文是否已创建并绑定到当前线程
+ * @Description: 任一步失败时释放已创建的部分; 之后本实例的GL调用都要在这个线程里进行
+ */
+bool GLESUtils::initNativeAndEGL() {
+    GLES_TRACE_SCOPE("initNativeAndEGL");
+    // Get access to a native display
+    // Setup the windowing system, create a window
+    // Create and Initialize an EGLDisplay from the native display
+    // Choose an EGLConfig for the application, used when setting up the rendering surface and EGLContext
+    // Create an EGLSurface for rendering from the native window
+    // Setup the EGL Context from the other EGL constructs created so far, so that the application is ready to submit OpenGL ES commands
+    if (!createNativeDisplay() || !createNativeWindow() || !createEGLDisplay() || !chooseEGLConfig() ||
+        !createEGLSurface() || !setupEGLContext()) {
+        cleanProc();
+        return false;
+    }
+    return true;
 }
 
+/**
+ * @MethodName: initStartup
+ * @Return: 初始化是否成功
+ * @Description: 着色器源码的读取展开和图片的解码(或读压缩缓存)不需要上下文, 作为线程池任务与本地窗口和EGL的初始化同时进行;
+ *               上下文创建好之后在本线程编译链接并创建纹理. 解码不阻塞第一帧, 在后台继续, 完成后由renderScene逐帧上传
+ */
+bool GLESUtils::initStartup() {
+    GLES_TRACE_SCOPE("initStartup");
+    const GLESSceneConfig &config = _sceneConfig;
+    _startup.clear();
+    _textureCache.setCacheDir(config.textureCacheDir);
+
+    // 还不知道GLES版本, 按支持GLES3选择着色器变体; 猜错时initShaders会重新展开
+    bool tiles = config.tileColumns > 0 && config.tileRows > 0;
+    bool video = !config.videoPath.empty();
+    std::vector<int> shaderDeps;
+    std::string vshPath, fshPath;
+    GLESShaderPreprocessor::Defines defines;
+    int easing = 0;
+    if (getShaderVariant(tiles, video, vshPath, fshPath, defines, easing)) {
+        // 展开结果留在预处理器的缓存里, initShaders依赖这个任务, 不会同时访问预处理器
+        shaderDeps.push_back(_startup.addTask("readShaders", {}, false, [this, vshPath, fshPath, defines]() {
+            std::string source;
+            return _shaderPreprocessor.load(vshPath, defines, source) &&
+                   _shaderPreprocessor.load(fshPath, defines, source);
+        }));
+    }
 
+    bool contextReady = false;
+    int egl = _startup.addTask("initNativeAndEGL", {}, true, [this, &contextReady]() {
+        contextReady = initNativeAndEGL();
+        return contextReady;
+    });
+    shaderDeps.push_back(egl);
+    int shaders = _startup.addTask("initShaders", shaderDeps, true, [this]() { return initShaders(); });
+
+    // 固定的几张图片: 每个文件一个任务, 多个纹理共用同一张图时只解码一次.
+    // 只有一个核时解码与上下文初始化抢同一个核, 反而推迟第一帧, 这时排在初始化之后
+    if (!tiles && !video && config.playlistPaths.empty()) {
+        std::vector<std::string> files = getImageFiles();
+        std::sort(files.begin(), files.end());
+        files.erase(std::unique(files.begin(), files.end()), files.end());
+        GLESThreadPool *pool = &_threadPool;
+        GLESTextureCache *cache = config.textureCacheDir.empty() ? NULL : &_textureCache;
+        std::vector<int> imageDeps;
+        if (_threadPool.getThreadCount() < 2) {
+            imageDeps.push_back(shaders);
+        }
+        for (const std::string &file : files) {
+            auto image = std::make_shared<std::promise<GLESImage> >();
+            _textureLoader.setPrefetched(file, image->get_future().share(), cache != NULL);
+            _startup.addTask("load " + file, imageDeps, false, [file, pool, cache, image]() {
+                // 解码失败时纹理保留占位内容, 不影响启动
+                image->set_value(GLESTextureLoader::loadImage(file, pool, cache));
+                return true;
+            });
+        }
+    }
+
+    if (_startup.run()) {
+        return true;
+    }
+    // 上下文已经创建时由这里释放, initNativeAndEGL失败时已自行清理
+    if (contextReady) {
+        deInitGLState();
+        cleanProc();
+    }
+    return false;
+}
@@ -5,12 +5,69 @@
 #ifndef GLES_DEMO_GLESUTILS_H
 #define GLES_DEMO_GLESUTILS_H
 
+#ifdef Headless
+// 无窗口系统: 保留本地类型, 接口与X11版本一致
+typedef struct HeadlessDisplay Display;
+typedef unsigned long Window;
+#else
 #include <X11/Xlib.h>
+#endif
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <cstdio>
 #include <GLES3/gl32.h>
 #include <string>
 #include <vector>
+#include "GLESStateCache.h"
+#include "GLESGeometry.h"
+#include "GLESProgram.h"
+#include "GLESProgramCache.h"
+#include "GLESFrameArena.h"
+#include "GLESAllocStats.h"
+#include "GLESThreadPool.h"
+#include "GLESTextureLoader.h"
+#include "GLESTextureCache.h"
+#include "GLESPlaylist.h"
+#include "GLESVideoSource.h"
+#include "GLESFrameCapture.h"
+#include "GLESFrameTimer.h"
+#include "GLESSceneConfig.h"
+#include "GLESShaderPreprocessor.h"
+#include "GLESDynamicResolution.h"
+#include "GLESRenderTargetPool.h"
+#include "GLESPostProcess.h"
+#include "GLESErrorMonitor.h"
+#include "GLESStartupGraph.h"
+
+// 上下文创建后一次性查询的能力位, 帧内不再做扩展字符串查找
+struct GLESCaps {
+    bool discardFramebuffer = false;
+    // GLES3的glInvalidateFramebuffer, 可以丢弃任意帧缓冲的附件
+    bool invalidateFramebuffer = false;
+    bool vertexArrayObject = false;
+    bool pixelBufferObject = false;
+    bool etc2Texture = false;
+    bool timerQuery = false;
+    bool programBinary = false;
+    // EGL_KHR/EXT_swap_buffers_with_damage, 交换时只提交变化的区域
+    bool swapBuffersWithDamage = false;
+    // GL_KHR_debug, 错误可以经异步回调上报
+    bool khrDebug = false;
+};
+
+// 单帧统计: 帧内的堆分配次数/字节数、帧内存池用量, 以及经过状态缓存的GL调用数
+struct GLESFrameStats {
+    uint64_t frameIndex = 0;
+    uint64_t allocCount = 0;
+    uint64_t allocBytes = 0;
+    size_t arenaUsed = 0;
+    uint64_t glCallsIssued = 0;
+    uint64_t glCallsElided = 0;
+    // 本帧是否绘制并交换, 以及累计的绘制/跳过帧数
+    bool presented = false;
+    uint64_t redrawnFrames = 0;
+    uint64_t skippedFrames = 0;
+};
 
 class GLESUtils {
 public:
@@ -38,10 +95,25 @@ public:
 
     void setAppName(std::string appName);
 
+    // 渲染到pbuffer而不创建窗口, 在initNativeAndEGL之前设置; 离屏构建总是离屏
+    void setOffscreen(bool offscreen);
+
+    bool isOffscreen();
+
+    // 场景配置, 在initShaders之前设置
+    void setSceneConfig(const GLESSceneConfig &config);
+
+    GLESSceneConfig &getSceneConfig();
+
     void releaseEGLState(EGLDisplay eglDisplay);
 
     void releaseNativeResources(Display *nativeDisplay, Window nativeWindow);
 
+    bool handleNativeEvents();
+
+    // 等待窗口消息, 最多timeoutMs毫秒, 之后处理消息; 离屏时只是休眠
+    bool waitNativeEvents(int timeoutMs);
+
     void deInitGLState();
 
     GLuint getTextureID();
@@ -72,6 +144,8 @@ public:
 
     std::vector<GLuint> loadMoreTexture(std::vector<std::string> fileNames);
 
+    std::vector<GLESTextureHandle> loadMoreTextureAsync(const std::vector<std::string> &fileNames);
+
     bool renderScene();
 
     bool initShaders();
@@ -84,6 +158,13 @@ public:
 
     bool createShader(std::string shaderPath, int i);
 
+    bool buildProgram(const std::string &vshSource, const std::string &fshSource,
+                      const std::vector<std::pair<GLuint, std::string> > &attribBindings);
+
+    double getProgramSetupMs();
+
+    bool isProgramFromCache();
+
     GLuint &getFragmentShader();
 
     GLuint &getVertexShader();
@@ -96,31 +177,178 @@ public:
 
     void cleanProc();
 
-    void initNativeAndEGL();
+    int getGlesVersion();
+
+    GLESGeometry &getGeometry();
+
+    GLESProgram &getProgram();
+
+    GLESStateCache &getStateCache();
+
+    GLESProgramCache &getProgramCache();
+
+    GLESShaderPreprocessor &getShaderPreprocessor();
+
+    const GLESCaps &getCaps();
+
+    GLESFrameArena &getFrameArena();
+
+    const GLESFrameStats &getFrameStats();
+
+    GLESThreadPool &getThreadPool();
+
+    GLESTextureLoader &getTextureLoader();
+
+    GLESPlaylist &getPlaylist();
+
+    GLESVideoSource &getVideoSource();
+
+    GLESFrameCapture &getFrameCapture();
+
+    GLESTextureCache &getTextureCache();
+
+    GLESFrameTimer &getFrameTimer();
+
+    GLESDynamicResolution &getDynamicResolution();
+
+    GLESErrorMonitor &getErrorMonitor();
+
+    GLESRenderTargetPool &getRenderTargetPool();
+
+    GLESPostProcess &getPostProcess();
+
+    bool initNativeAndEGL();
+
+    /**
+     * 按启动任务图完成initNativeAndEGL和initShaders, 与上下文无关的读文件和解码提前在线程池中进行
+     * 失败时已释放GL和窗口资源
+     */
+    bool initStartup();
+
+    GLESStartupGraph &getStartupGraph();
 
 private:
+    void queryCaps();
+
+    void beginFrame();
+
+    void endFrame();
+
+    bool drawScene();
+
+    bool initTiles();
+
+    bool initVideo();
+
+    bool needsRedraw(bool changed);
+
+    bool skipFrame();
+
+    void clearSceneTarget();
+
+    // damage为自下而上的x, y, w, h, NULL表示整个surface
+    bool presentFrame(const EGLint *damage = NULL);
+
+    // 着色器变体: 按是否用图块墙/视频选择源文件, 并生成注入的宏
+    bool getShaderVariant(bool tiles, bool video, std::string &vshPath, std::string &fshPath,
+                          GLESShaderPreprocessor::Defines &defines, int &easing) const;
+
+    // 固定纹理对应的图片, 纹理个数多于图片时循环使用
+    std::vector<std::string> getImageFiles() const;
+
     // Width and height of the window
-    unsigned int _winWidth;
-    unsigned int _winHeight;
+    unsigned int _winWidth = 0;
+    unsigned int _winHeight = 0;
     // Name of the application
-    char *_appName;
+    std::string _appName;
+    // 本实例的场景配置, 渲染只读取这里, 不依赖进程级的全局变量
+    GLESSceneConfig _sceneConfig;
 
-    int _textureSize;
-    GLuint _textureID;
+    int _textureSize = 0;
+    GLuint _textureID = 0;
     std::vector<GLuint> _vectorTextureID;
-    GLint _samplerLoc;
+    GLint _samplerLoc = -1;
     GLuint _fragmentShader = 0, _vertexShader = 0;
-    GLuint _shaderProgram = 0;
+    // 着色器程序及帧内用到的uniform句柄
+    // GL状态影子, 程序/几何/纹理加载都经过它提交状态, 所以要最先构造
+    GLESStateCache _stateCache;
+    GLESProgram _program{_stateCache};
+    int _progressUniform = -1;
+    int _speedUniform = -1;
+    int _samplerUniform = -1;
+    // 在CPU上每帧算好的过渡进度, 及其缓动曲线
+    int _transitionUniform = -1;
+    int _easedTransitionUniform = -1;
+    int _easing = 0;
+    // 展开#include并注入宏, 按变体缓存展开结果
+    GLESShaderPreprocessor _shaderPreprocessor;
+    // 程序二进制缓存, 以及最近一次buildProgram的耗时和来源
+    GLESProgramCache _programCache;
+    double _programSetupMs = 0.0;
+    bool _programFromCache = false;
+
+    // 常驻显存的几何数据
+    GLESGeometry _geometry{_stateCache};
+    int _quadMesh = -1;
+    // 图块墙: 所有图片放在一个纹理数组里, 全部图块一次实例化绘制
+    GLuint _tileTexture = 0;
+    GLsizei _tileLayers = 0;
+    GLsizei _tileCount = 0;
+    int _layerCountUniform = -1;
+    // 视频各平面的采样器和颜色转换, NV12由着色器变体处理
+    int _videoSamplerUniforms[3] = {-1, -1, -1};
+    int _colorMatrixUniform = -1;
+    // 擦除效果每帧只有边缘一带变化, 交换时只提交这一带; 上次交换的过渡进度, 小于0表示要整屏提交
+    bool _wipeEffect = false;
+    float _presentedTransition = -1.0f;
+    // 窗口暴露/尺寸变化, 以及初始化之后的第一帧都要重画
+    bool _redrawPending = true;
 
     // X11 variables
     Display *_nativeDisplay = NULL;
     Window _nativeWindow = 0;
+#ifdef Headless
+    bool _offscreen = true;
+#else
+    bool _offscreen = false;
+#endif
 
     // EGL variables
     EGLDisplay _eglDisplay = NULL;
     EGLConfig _eglConfig = NULL;
     EGLSurface _eglSurface = NULL;
     EGLContext _context = NULL;
+    // 上下文的GLES主版本号, 3时可以使用VAO等GLES3特性
+    int _glesVersion = 2;
+    GLESCaps _caps;
+    PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC _swapBuffersWithDamage = NULL;
+
+    // 帧内临时数据和分配统计
+    GLESFrameArena _frameArena;
+    GLESFrameStats _frameStats;
+    GLESAllocCounters _frameAllocStart;
+    // 帧计时, 动画进度也以它为准
+    GLESFrameTimer _frameTimer;
+
+    // 工作线程解码图片, GL线程上传; 缓存要比线程池活得久, 后台编码任务会用到它
+    GLESTextureCache _textureCache;
+    GLESThreadPool _threadPool;
+    GLESTextureLoader _textureLoader{_threadPool, _stateCache};
+    // 流式幻灯片, 设置了播放列表时代替固定的几张纹理
+    GLESPlaylist _playlist{_threadPool, _stateCache};
+    // 原始视频帧输入
+    GLESVideoSource _video{_stateCache};
+    // 交换前异步读回后台缓冲
+    GLESFrameCapture _capture{_stateCache};
+    // 离屏渲染目标池和后处理pass
+    GLESRenderTargetPool _renderTargets{_stateCache};
+    GLESPostProcess _postProcess{_stateCache, _renderTargets};
+    // 按帧间隔调整渲染分辨率, 放大后经渲染目标池丢弃FBO内容
+    GLESDynamicResolution _resolution{_stateCache, _renderTargets};
+    // 帧内GL错误检查策略和汇总
+    GLESErrorMonitor _errorMonitor;
+    // 启动任务图, 后台任务引用上面的成员, 放在最后先析构
+    GLESStartupGraph _startup{_threadPool};
 
 };
 
@@ -0,0 +1,395 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#include "GLESVideoSource.h"
+#include "GLESTrace.h"
+
+#define DYNAMICGLES_NO_NAMESPACE
+#define DYNAMICEGL_NO_NAMESPACE
+
+#include <DynamicGles.h>
+#include <cstdlib>
+#include <cstring>
+
+GLESVideoSource::GLESVideoSource(GLESStateCache &stateCache) : _stateCache(stateCache) {
+}
+
+GLESVideoSource::~GLESVideoSource() {
+    // 没有机会调用release时至少停掉读取线程, GL对象随上下文销毁
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_all();
+    if (_reader.joinable()) {
+        _reader.join();
+    }
+    if (_file && _file != stdin) {
+        fclose(_file);
+    }
+}
+
+bool GLESVideoSource::parseFormat(const std::string &name, Format &format) {
+    if (name == "i420" || name == "I420" || name == "yuv420p") {
+        format = FORMAT_I420;
+        return true;
+    }
+    if (name == "nv12" || name == "NV12") {
+        format = FORMAT_NV12;
+        return true;
+    }
+    return false;
+}
+
+bool GLESVideoSource::openY4m(const std::string &path) {
+    return open(path, true, 0, 0, FORMAT_I420);
+}
+
+bool GLESVideoSource::openRaw(const std::string &path, int width, int height, Format format) {
+    return open(path, false, width, height, format);
+}
+
+void GLESVideoSource::setLoop(bool loop) {
+    _loop = loop;
+}
+
+/**
+ * @MethodName: parseY4mHeader
+ * @Return: 是否为支持的Y4M流
+ * @Description: 解析"YUV4MPEG2 W.. H.. F.. I.. A.. C.."头, 只接受4:2:0色度采样(按I420平面顺序存放)
+ */
+bool GLESVideoSource::parseY4mHeader() {
+    char line[256];
+    if (!fgets(line, sizeof(line), _file) || strncmp(line, "YUV4MPEG2 ", 10) != 0) {
+        printf("Not a YUV4MPEG2 stream\n");
+        return false;
+    }
+    for (char *token = strtok(line + 10, " \n"); token; token = strtok(NULL, " \n")) {
+        switch (token[0]) {
+            case 'W':
+                _width = atoi(token + 1);
+                break;
+            case 'H':
+                _height = atoi(token + 1);
+                break;
+            case 'C':
+                // 420jpeg/420mpeg2/420paldv只是色度位置不同, 平面布局一致
+                if (strncmp(token + 1, "420", 3) != 0) {
+                    printf("Unsupported Y4M colorspace: %s\n", token + 1);
+                    return false;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    _format = FORMAT_I420;
+    return true;
+}
+
+/**
+ * @MethodName: open
+ * @Return: 是否成功
+ * @Description: 打开输入并分配各平面的纹理和PBO环, 然后启动读取线程
+ */
+bool GLESVideoSource::open(const std::string &path, bool y4m, int width, int height, Format format) {
+    release();
+
+    _file = path == "-" ? stdin : fopen(path.c_str(), "rb");
+    if (!_file) {
+        printf("Failed to open video: %s\n", path.c_str());
+        return false;
+    }
+    _y4m = y4m;
+    _width = width;
+    _height = height;
+    _format = format;
+    if (y4m && !parseY4mHeader()) {
+        release();
+        return false;
+    }
+    if (_width <= 0 || _height <= 0) {
+        printf("Invalid video size %dx%d\n", _width, _height);
+        release();
+        return false;
+    }
+    // 管道不能回退, 循环播放只对普通文件有效
+    _firstFrameOffset = _file == stdin ? -1 : ftell(_file);
+
+    int chromaWidth = (_width + 1) / 2;
+    int chromaHeight = (_height + 1) / 2;
+    _planes[0].width = _width;
+    _planes[0].height = _height;
+    _planes[0].format = GL_RED;
+    _planes[0].bytes = (size_t) _width * _height;
+    if (_format == FORMAT_NV12) {
+        _planeCount = 2;
+        _planes[1].width = chromaWidth;
+        _planes[1].height = chromaHeight;
+        _planes[1].format = GL_RG;
+        _planes[1].bytes = (size_t) chromaWidth * chromaHeight * 2;
+    } else {
+        _planeCount = 3;
+        for (int i = 1; i < 3; ++i) {
+            _planes[i].width = chromaWidth;
+            _planes[i].height = chromaHeight;
+            _planes[i].format = GL_RED;
+            _planes[i].bytes = (size_t) chromaWidth * chromaHeight;
+        }
+    }
+    _frameBytes = 0;
+    for (int i = 0; i < _planeCount; ++i) {
+        Plane &plane = _planes[i];
+        plane.offset = _frameBytes;
+        _frameBytes += plane.bytes;
+
+        glGenTextures(1, &plane.texture);
+        _stateCache.bindTexture(GL_TEXTURE_2D, plane.texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, plane.format == GL_RG ? GL_RG8 : GL_R8, plane.width, plane.height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    for (PixelBuffer &pixelBuffer : _pixelBuffers) {
+        glGenBuffers(1, &pixelBuffer.buffer);
+        _stateCache.bindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr) _frameBytes, NULL, GL_STREAM_DRAW);
+    }
+    _stateCache.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (glGetError() != GL_NO_ERROR) {
+        printf("Failed to allocate video textures\n");
+        release();
+        return false;
+    }
+
+    for (std::vector<unsigned char> &frame : _frames) {
+        frame.resize(_frameBytes);
+    }
+    _readIndex = 0;
+    _filled = 0;
+    _ended = false;
+    _stop = false;
+    _nextPixelBuffer = 0;
+    _stats = GLESVideoStats();
+    _reader = std::thread(&GLESVideoSource::readerLoop, this);
+    return true;
+}
+
+bool GLESVideoSource::readFrame(std::vector<unsigned char> &frame) {
+    if (_y4m) {
+        // 每帧前有一行"FRAME[ 参数]"
+        char tag[5];
+        if (fread(tag, 1, sizeof(tag), _file) != sizeof(tag)) {
+            return false;
+        }
+        if (memcmp(tag, "FRAME", sizeof(tag)) != 0) {
+            printf("Corrupt Y4M frame header\n");
+            return false;
+        }
+        int c;
+        while ((c = fgetc(_file)) != '\n' && c != EOF) {
+        }
+    }
+    return fread(frame.data(), 1, _frameBytes, _file) == _frameBytes;
+}
+
+/**
+ * @MethodName: readerLoop
+ * @Description: 有空闲内存帧就读下一帧, 环满时等待GL线程取走; 到末尾时按需回到第一帧
+ */
+void GLESVideoSource::readerLoop() {
+    int writeIndex = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]() { return _stop || _filled < RING_SIZE; });
+            if (_stop) {
+                return;
+            }
+        }
+
+        bool ok = readFrame(_frames[writeIndex]);
+        if (!ok && _loop && _firstFrameOffset >= 0 && fseek(_file, _firstFrameOffset, SEEK_SET) == 0) {
+            ok = readFrame(_frames[writeIndex]);
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!ok) {
+            _ended = true;
+            return;
+        }
+        ++_filled;
+        writeIndex = (writeIndex + 1) % RING_SIZE;
+    }
+}
+
+/**
+ * @MethodName: update
+ * @Return: 本次是否上传了新帧
+ * @Description: 每帧调用一次. 没有新帧, 或者轮到的PBO上次的上传还没完成时直接返回, 继续显示上一帧;
+ *               否则拷进PBO, 各平面从PBO偏移处上传, 再插入栅栏
+ */
+bool GLESVideoSource::update() {
+    GLES_TRACE_SCOPE("videoUpdate");
+    if (!_file) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_filled == 0) {
+            ++_stats.starved;
+            return false;
+        }
+    }
+
+    PixelBuffer &pixelBuffer = _pixelBuffers[_nextPixelBuffer];
+    if (pixelBuffer.fence) {
+        if (glClientWaitSync(pixelBuffer.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            ++_stats.pboBusy;
+            return false;
+        }
+        glDeleteSync(pixelBuffer.fence);
+        pixelBuffer.fence = 0;
+    }
+
+    // 栅栏已经通过, 驱动不再读这块缓冲, 可以不同步直接写
+    _stateCache.bindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.buffer);
+    void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr) _frameBytes,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (!mapped) {
+        _stateCache.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+    memcpy(mapped, _frames[_readIndex].data(), _frameBytes);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _readIndex = (_readIndex + 1) % RING_SIZE;
+        --_filled;
+    }
+    _condition.notify_one();
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < _planeCount; ++i) {
+        const Plane &plane = _planes[i];
+        _stateCache.bindTexture(GL_TEXTURE_2D, plane.texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, plane.width, plane.height, plane.format, GL_UNSIGNED_BYTE,
+                        (const void *) plane.offset);
+    }
+    _stateCache.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    pixelBuffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _nextPixelBuffer = (_nextPixelBuffer + 1) % RING_SIZE;
+
+    ++_stats.uploadedFrames;
+    _stats.uploadedBytes += _frameBytes;
+    return true;
+}
+
+bool GLESVideoSource::isOpen() const {
+    return _file != NULL;
+}
+
+bool GLESVideoSource::isEnded() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _ended && _filled == 0;
+}
+
+int GLESVideoSource::getWidth() const {
+    return _width;
+}
+
+int GLESVideoSource::getHeight() const {
+    return _height;
+}
+
+GLESVideoSource::Format GLESVideoSource::getFormat() const {
+    return _format;
+}
+
+int GLESVideoSource::getPlaneCount() const {
+    return _planeCount;
+}
+
+GLuint GLESVideoSource::getPlaneTexture(int plane) const {
+    return plane >= 0 && plane < _planeCount ? _planes[plane].texture : 0;
+}
+
+size_t GLESVideoSource::getFrameBytes() const {
+    return _frameBytes;
+}
+
+void GLESVideoSource::getColorMatrix(GLfloat matrix[16]) const {
+    double kr = _height >= 720 ? 0.2126 : 0.299;
+    double kb = _height >= 720 ? 0.0722 : 0.114;
+    double kg = 1.0 - kr - kb;
+    // 有限范围: Y为16~235, UV为16~240
+    double ys = 255.0 / 219.0;
+    double cs = 255.0 / 224.0;
+    double rv = cs * 2.0 * (1.0 - kr);
+    double gu = cs * 2.0 * (1.0 - kb) * kb / kg;
+    double gv = cs * 2.0 * (1.0 - kr) * kr / kg;
+    double bu = cs * 2.0 * (1.0 - kb);
+    double y0 = 16.0 / 255.0;
+    double c0 = 128.0 / 255.0;
+
+    const double columns[16] = {
+            ys, ys, ys, 0.0,
+            0.0, -gu, bu, 0.0,
+            rv, -gv, 0.0, 0.0,
+            -ys * y0 - rv * c0, -ys * y0 + (gu + gv) * c0, -ys * y0 - bu * c0, 1.0
+    };
+    for (int i = 0; i < 16; ++i) {
+        matrix[i] = (GLfloat) columns[i];
+    }
+}
+
+const GLESVideoStats &GLESVideoSource::getStats() const {
+    return _stats;
+}
+
+void GLESVideoSource::resetStats() {
+    _stats = GLESVideoStats();
+}
+
+/**
+ * @MethodName: release
+ * @Description: 停止读取线程并释放纹理、PBO和栅栏. 管道上的读取阻塞在fread时会等到有数据或写端关闭
+ */
+void GLESVideoSource::release() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_all();
+    if (_reader.joinable()) {
+        _reader.join();
+    }
+    if (_file && _file != stdin) {
+        fclose(_file);
+    }
+    _file = NULL;
+
+    for (PixelBuffer &pixelBuffer : _pixelBuffers) {
+        if (pixelBuffer.fence) {
+            glDeleteSync(pixelBuffer.fence);
+            pixelBuffer.fence = 0;
+        }
+        if (pixelBuffer.buffer) {
+            _stateCache.deleteBuffers(1, &pixelBuffer.buffer);
+            pixelBuffer.buffer = 0;
+        }
+    }
+    for (Plane &plane : _planes) {
+        if (plane.texture) {
+            _stateCache.deleteTextures(1, &plane.texture);
+        }
+        plane = Plane();
+    }
+    _planeCount = 0;
+    for (std::vector<unsigned char> &frame : _frames) {
+        std::vector<unsigned char>().swap(frame);
+    }
+}
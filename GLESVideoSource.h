@@ -0,0 +1,138 @@
+//
+// Created by sean on 2026/10/17.
+//
+
+#ifndef GLES_DEMO_GLESVIDEOSOURCE_H
+#define GLES_DEMO_GLESVIDEOSOURCE_H
+
+#include <GLES3/gl32.h>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GLESStateCache.h"
+
+// 上传统计: busy为PBO的栅栏还没通过而推迟上传的次数, starved为没有新帧可用的次数
+struct GLESVideoStats {
+    uint64_t uploadedFrames = 0;
+    uint64_t uploadedBytes = 0;
+    uint64_t pboBusy = 0;
+    uint64_t starved = 0;
+};
+
+/**
+ * 原始视频帧输入: 读取Y4M(4:2:0)或裸I420/NV12帧, 文件和管道都可以, "-"表示标准输入.
+ * 读取线程把帧读进3个预分配的内存帧, GL线程把帧拷进3个PBO轮流使用,
+ * 每个PBO上传后插入栅栏, 再次使用前只做不等待的检查, CPU从不阻塞在GPU上.
+ * 各平面上传到单通道(NV12的UV为双通道)纹理, 由着色器做YUV到RGB的转换.
+ * 需要GLES3, 除构造外的方法都必须在GL线程调用.
+ */
+class GLESVideoSource {
+public:
+    enum Format {
+        FORMAT_I420 = 0,
+        // Y平面之后是交错的UV平面
+        FORMAT_NV12
+    };
+
+    static const int RING_SIZE = 3;
+
+    explicit GLESVideoSource(GLESStateCache &stateCache);
+
+    ~GLESVideoSource();
+
+    GLESVideoSource(const GLESVideoSource &) = delete;
+
+    GLESVideoSource &operator=(const GLESVideoSource &) = delete;
+
+    static bool parseFormat(const std::string &name, Format &format);
+
+    bool openY4m(const std::string &path);
+
+    bool openRaw(const std::string &path, int width, int height, Format format);
+
+    // 读到文件末尾时从第一帧重新开始, 管道无效
+    void setLoop(bool loop);
+
+    bool update();
+
+    bool isOpen() const;
+
+    bool isEnded();
+
+    int getWidth() const;
+
+    int getHeight() const;
+
+    Format getFormat() const;
+
+    int getPlaneCount() const;
+
+    GLuint getPlaneTexture(int plane) const;
+
+    size_t getFrameBytes() const;
+
+    // 列主序的YUV->RGB矩阵(含偏移), 高度不小于720时用BT.709, 否则BT.601, 均为有限范围
+    void getColorMatrix(GLfloat matrix[16]) const;
+
+    const GLESVideoStats &getStats() const;
+
+    void resetStats();
+
+    void release();
+
+private:
+    struct Plane {
+        GLuint texture = 0;
+        int width = 0;
+        int height = 0;
+        GLenum format = GL_RED;
+        size_t offset = 0;
+        size_t bytes = 0;
+    };
+
+    struct PixelBuffer {
+        GLuint buffer = 0;
+        GLsync fence = 0;
+    };
+
+    bool open(const std::string &path, bool y4m, int width, int height, Format format);
+
+    bool parseY4mHeader();
+
+    bool readFrame(std::vector<unsigned char> &frame);
+
+    void readerLoop();
+
+    GLESStateCache &_stateCache;
+    FILE *_file = NULL;
+    bool _y4m = false;
+    bool _loop = false;
+    long _firstFrameOffset = 0;
+    int _width = 0;
+    int _height = 0;
+    Format _format = FORMAT_I420;
+    size_t _frameBytes = 0;
+    Plane _planes[3];
+    int _planeCount = 0;
+
+    PixelBuffer _pixelBuffers[RING_SIZE];
+    int _nextPixelBuffer = 0;
+    GLESVideoStats _stats;
+
+    // 读取线程写满的内存帧环, _readIndex/_filled由_mutex保护
+    std::vector<unsigned char> _frames[RING_SIZE];
+    int _readIndex = 0;
+    int _filled = 0;
+    bool _ended = false;
+    bool _stop = false;
+    std::thread _reader;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+};
+
+
+#endif //GLES_DEMO_GLESVIDEOSOURCE_H
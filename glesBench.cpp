@@ -0,0 +1,891 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GLESUtils.h"
+#include "GLESCompositor.h"
+#include "GLESTrace.h"
+
+#define DYNAMICGLES_NO_NAMESPACE
+#define DYNAMICEGL_NO_NAMESPACE
+
+#include <DynamicGles.h>
+
+// 一个基准场景: 纹理个数、分辨率、测量帧数和过渡效果
+struct BenchScenario {
+    std::string name;
+    int textures;
+    int width;
+    int height;
+    int frames;
+    std::string shader;
+    // 图块墙的列数和行数, 0表示单个全屏四边形
+    int columns = 0;
+    int rows = 0;
+    // 以图片目录作为播放列表流式播放
+    bool playlist = false;
+    // 视频输入格式(i420为Y4M, nv12为裸帧), 空表示不用视频
+    std::string video;
+};
+
+// 一个场景的测量结果
+struct BenchResult {
+    BenchScenario scenario;
+    std::string renderer;
+    bool ok = false;
+    // 启动各阶段, 均从创建GLESUtils开始计时
+    double eglMs = 0.0;
+    double initMs = 0.0;
+    double programMs = 0.0;
+    bool programCached = false;
+    double firstFrameMs = 0.0;
+    double texturesReadyMs = 0.0;
+    int loadingFrames = 0;
+    double fps = 0.0;
+    GLESTimingSummary frameMs;
+    GLESTimingSummary cpuMs;
+    GLESTimingSummary gpuMs;
+    // 开启动态分辨率时每帧的渲染比例
+    GLESTimingSummary scale;
+    uint64_t steadyAllocs = 0;
+    // 整个运行期间检测到的GL错误数, 非0时场景失败
+    uint64_t glErrors = 0;
+    // 测量帧内经过状态缓存的GL调用总数
+    uint64_t glCallsIssued = 0;
+    uint64_t glCallsElided = 0;
+    // 播放列表场景测量期间切换到的图片数
+    uint64_t slidesShown = 0;
+    // 视频场景测量期间的上传统计
+    GLESVideoStats video;
+    double videoFps = 0.0;
+    double videoMBps = 0.0;
+    // 开启截帧时的读回统计
+    GLESCaptureStats capture;
+    // 开启后处理时渲染目标池的用量
+    GLESRenderTargetStats renderTargets;
+    // 测量结束的时刻, 多实例时用来计算总吞吐
+    double measureEnd = 0.0;
+};
+
+// 多实例扩展性: threads个实例各用一个线程、各自的上下文和离屏surface同时渲染同一场景
+struct BenchScaling {
+    std::string scenario;
+    std::string renderer;
+    int threads = 0;
+    bool ok = false;
+    // 所有实例的测量帧数除以共同的测量窗口(从同时开始到最后一个结束)
+    double totalFps = 0.0;
+    double instanceFps = 0.0;
+    // 相对单实例总吞吐的倍数
+    double speedup = 0.0;
+    uint64_t steadyAllocs = 0;
+};
+
+// GL读回与CPU参考合成的逐帧对比, 以及两者的速度
+struct BenchVerify {
+    std::string scenario;
+    std::string effect;
+    bool ok = false;
+    int frames = 0;
+    // 通道值的最大差, 以及差超过容差的通道数
+    int maxDiff = 0;
+    uint64_t overTolerance = 0;
+    // GL为渲染加读回写文件; CPU为线程池所有线程和单线程(最优指令集与标量)
+    double glFps = 0.0;
+    double cpuFps = 0.0;
+    double cpuSingleFps = 0.0;
+    double cpuScalarFps = 0.0;
+    std::string isa;
+    unsigned cpuThreads = 0;
+};
+
+// 多实例的起跑线: 所有实例启动并预热完成后同时开始测量. 启动失败的实例也要到达, 否则其他实例会一直等待
+struct BenchGate {
+    std::mutex mutex;
+    std::condition_variable condition;
+    int expected = 0;
+    int arrived = 0;
+    double openedAt = 0.0;
+};
+
+// 预置场景, 帧数按llvmpipe的速度取值, 保证整套跑完在一两分钟内
+const std::vector<BenchScenario> bench_scenarios = {
+        {"default",   3, 1600, 900, 120, "fade"},
+        {"small",     3, 640,  360, 240, "fade"},
+        {"textures8", 8, 1600, 900, 120, "fade"},
+        {"wipe",      3, 1600, 900, 120, "wipe"},
+        {"tiles",     3, 1600, 900, 120, "tiles", 48, 27},
+        {"playlist",  3, 1600, 900, 240, "fade", 0, 0, true},
+        {"video",     0, 1920, 1080, 120, "video", 0, 0, false, "i420"},
+        {"video_nv12", 0, 1920, 1080, 120, "video", 0, 0, false, "nv12"},
+};
+
+// 测试视频的帧数, 播放时循环
+const int bench_video_frames = 8;
+
+// 运行参数
+std::string bench_assets = "../..";
+int bench_warmup = 5;
+bool bench_sync = true;
+bool bench_cache = true;
+std::string bench_playlist;
+// 截帧格式, 空表示不截帧
+std::string bench_capture;
+// 扩展性测试的最大线程数, 0表示不测
+int bench_threads = 0;
+// 与CPU参考合成对比: 帧数(均匀覆盖整个过渡)和每个通道允许的差
+bool bench_verify = false;
+int bench_verify_frames = 16;
+int bench_tolerance = 2;
+// 动态分辨率的目标帧耗时(毫秒), 0表示按窗口大小渲染
+double bench_target_ms = 0.0;
+// 帧内GL错误检查策略, 空为构建的默认值
+std::string bench_gl_errors;
+// 后处理pass, 按顺序执行
+std::vector<std::string> bench_post;
+
+static double nowMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string shaderPath(const std::string &shader) {
+    if (shader.size() > 5 && shader.compare(shader.size() - 5, 5, ".frag") == 0) {
+        return shader;
+    }
+    if (shader == "tiles" || shader == "video") {
+        return bench_assets + "/shader/" + shader + "/" + shader + ".frag";
+    }
+    return bench_assets + (shader == "fade" ? "/shader/test/fsh.frag" : "/shader/test/" + shader + ".frag");
+}
+
+/**
+ * @MethodName: prepareVideo
+ * @Return: 测试视频路径, 生成失败时返回空
+ * @Description: 在运行目录生成移动渐变的测试视频, i420为Y4M, nv12为裸帧; 已存在且大小正确时直接使用
+ */
+static std::string prepareVideo(const std::string &format, int width, int height) {
+    bool nv12 = format == "nv12";
+    std::string path = "bench_" + std::to_string(width) + "x" + std::to_string(height) + (nv12 ? ".nv12" : ".y4m");
+    std::string header = "YUV4MPEG2 W" + std::to_string(width) + " H" + std::to_string(height) +
+                         " F30:1 Ip A1:1 C420jpeg\n";
+    int chromaWidth = (width + 1) / 2;
+    int chromaHeight = (height + 1) / 2;
+    size_t frameBytes = (size_t) width * height + (size_t) chromaWidth * chromaHeight * 2;
+    size_t expected = (nv12 ? 0 : header.size() + 6 * bench_video_frames) + frameBytes * bench_video_frames;
+
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file) {
+        fseek(file, 0, SEEK_END);
+        bool valid = (size_t) ftell(file) == expected;
+        fclose(file);
+        if (valid) {
+            return path;
+        }
+    }
+
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        printf("Failed to write %s\n", path.c_str());
+        return "";
+    }
+    if (!nv12) {
+        fwrite(header.data(), 1, header.size(), file);
+    }
+    std::vector<unsigned char> frame(frameBytes);
+    for (int f = 0; f < bench_video_frames; ++f) {
+        unsigned char *y = frame.data();
+        unsigned char *chroma = y + (size_t) width * height;
+        for (int row = 0; row < height; ++row) {
+            for (int column = 0; column < width; ++column) {
+                y[(size_t) row * width + column] = (unsigned char) (16 + (column + row + f * 32) % 220);
+            }
+        }
+        for (int row = 0; row < chromaHeight; ++row) {
+            for (int column = 0; column < chromaWidth; ++column) {
+                auto u = (unsigned char) (16 + (column * 224 / chromaWidth + f * 8) % 224);
+                auto v = (unsigned char) (16 + row * 224 / chromaHeight);
+                size_t index = (size_t) row * chromaWidth + column;
+                if (nv12) {
+                    chroma[index * 2] = u;
+                    chroma[index * 2 + 1] = v;
+                } else {
+                    chroma[index] = u;
+                    chroma[(size_t) chromaWidth * chromaHeight + index] = v;
+                }
+            }
+        }
+        if (!nv12) {
+            fwrite("FRAME\n", 1, 6, file);
+        }
+        fwrite(frame.data(), 1, frame.size(), file);
+    }
+    fclose(file);
+    return path;
+}
+
+static void passGate(BenchGate *gate) {
+    if (!gate) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(gate->mutex);
+    if (++gate->arrived == gate->expected) {
+        gate->openedAt = nowMs();
+        gate->condition.notify_all();
+        return;
+    }
+    gate->condition.wait(lock, [gate] { return gate->arrived >= gate->expected; });
+}
+
+// 离屏pbuffer交换时不等待渲染完成, 每帧glFinish使帧时间包含GPU执行时间
+static bool renderFrame(GLESUtils &gles) {
+    bool result = gles.renderScene();
+    if (bench_sync) {
+        glFinish();
+    }
+    return result;
+}
+
+/**
+ * @MethodName: runScenario
+ * @Return: 测量结果, 初始化或绘制失败时ok为false
+ * @Description: 先渲染到所有纹理上传完毕, 再跑预热帧, 之后清空计时样本开始测量.
+ *               动画按固定步长推进, 每次运行画面一致
+ */
+static BenchResult runScenario(const BenchScenario &scenario, int instance = 0, BenchGate *gate = NULL) {
+    BenchResult result;
+    result.scenario = scenario;
+
+    GLESSceneConfig config;
+    config.vshPath = bench_assets + "/shader/test/vsh.vert";
+    config.fshPath = shaderPath(scenario.shader);
+    config.textureSize = scenario.textures;
+    config.tileColumns = scenario.columns;
+    config.tileRows = scenario.rows;
+    config.tileVshPath = bench_assets + "/shader/tiles/tiles.vert";
+    // 图块墙只能用纹理数组版本的着色器, 内置的fade/wipe都换成tiles
+    config.tileFshPath = shaderPath(shaderPath(scenario.shader) == scenario.shader ? scenario.shader : "tiles");
+    config.programCacheDir = bench_cache ? "program_cache" : "";
+    config.textureCacheDir = bench_cache ? "texture_cache" : "";
+    config.imageFiles = {bench_assets + "/pic/1.jpg", bench_assets + "/pic/2.jpg", bench_assets + "/pic/3.jpg"};
+    // 停留时间取得较短, 测量期间会有多次切换
+    if (scenario.playlist) {
+        config.playlistPaths.push_back(bench_playlist.empty() ? bench_assets + "/pic" : bench_playlist);
+    }
+    config.playlistHold = 0.25;
+    // 测量的是每帧的绘制开销, 画面静止时也要绘制
+    config.idleSkip = false;
+    config.dynamicResolution = bench_target_ms > 0.0;
+    config.targetFrameMs = bench_target_ms;
+    config.glErrorMode = bench_gl_errors;
+    config.postPasses = bench_post;
+    config.postVshPath = bench_assets + "/shader/post/post.vert";
+    config.blurFshPath = bench_assets + "/shader/post/blur.frag";
+    config.gradeFshPath = bench_assets + "/shader/post/grade.frag";
+    if (!bench_capture.empty()) {
+        GLESFrameCapture::Format format;
+        GLESFrameCapture::parseFormat(bench_capture, format);
+        // 多实例同时运行时各写各的文件
+        config.capturePath = "bench_capture_" + scenario.name + (instance > 0 ? "_" + std::to_string(instance) : "") +
+                             GLESFrameCapture::getExtension(format);
+        config.captureFormat = bench_capture;
+    }
+    if (!scenario.video.empty()) {
+        config.videoPath = prepareVideo(scenario.video, scenario.width, scenario.height);
+        if (config.videoPath.empty()) {
+            passGate(gate);
+            return result;
+        }
+        config.videoVshPath = bench_assets + "/shader/video/video.vert";
+        config.videoFshPath = shaderPath(shaderPath(scenario.shader) == scenario.shader ? scenario.shader : "video");
+        config.videoFormat = scenario.video;
+        if (scenario.video != "i420") {
+            config.videoWidth = scenario.width;
+            config.videoHeight = scenario.height;
+        }
+    }
+
+    double begin = nowMs();
+    std::unique_ptr<GLESUtils> gles(new GLESUtils());
+    gles->setWindowWH((unsigned) scenario.width, (unsigned) scenario.height);
+    gles->setAppName("GLES Bench");
+    gles->setSceneConfig(config);
+    GLESFrameTimer &frameTimer = gles->getFrameTimer();
+    frameTimer.setFixedTimeStep(1.0 / 60.0);
+    // 与正常启动一样按任务图初始化, 图片解码与EGL初始化重叠
+    if (!gles->initStartup()) {
+        printf("%s: failed to start\n", scenario.name.c_str());
+        passGate(gate);
+        return result;
+    }
+    result.initMs = nowMs() - begin;
+    GLESStartupGraph &startup = gles->getStartupGraph();
+    result.eglMs = result.initMs - startup.getElapsedMs() + startup.getEndMs("initNativeAndEGL");
+    result.renderer = (const char *) glGetString(GL_RENDERER);
+    result.programMs = gles->getProgramSetupMs();
+    result.programCached = gles->isProgramFromCache();
+
+    /* 启动: 绘制占位纹理直到全部上传完成 */
+    bool ok = true;
+    GLESPlaylist &playlist = gles->getPlaylist();
+    GLESVideoSource &video = gles->getVideoSource();
+    while (ok && (result.loadingFrames == 0 || gles->getTextureLoader().getPendingCount() > 0 ||
+                  (playlist.isActive() && !playlist.isReady()) ||
+                  (video.isOpen() && video.getStats().uploadedFrames == 0 && !video.isEnded()))) {
+        ok = renderFrame(*gles);
+        if (++result.loadingFrames == 1) {
+            result.firstFrameMs = nowMs() - begin;
+        }
+    }
+    result.texturesReadyMs = nowMs() - begin;
+    // 未命中缓存时后台还在编码ETC2, 等它结束再测量, 避免抢占CPU
+    gles->getThreadPool().waitIdle();
+
+    for (int i = 0; ok && i < bench_warmup; ++i) {
+        ok = renderFrame(*gles);
+    }
+
+    /* 稳态测量, 多实例时等所有实例都预热完一起开始 */
+    passGate(gate);
+    frameTimer.reset();
+    uint64_t shownBefore = playlist.getShownCount();
+    video.resetStats();
+    double measureBegin = nowMs();
+    for (int i = 0; ok && i < scenario.frames; ++i) {
+        ok = renderFrame(*gles);
+        const GLESFrameStats &frameStats = gles->getFrameStats();
+        result.steadyAllocs += frameStats.allocCount;
+        result.glCallsIssued += frameStats.glCallsIssued;
+        result.glCallsElided += frameStats.glCallsElided;
+    }
+    result.measureEnd = nowMs();
+    double measureMs = result.measureEnd - measureBegin;
+    result.slidesShown = playlist.getShownCount() - shownBefore;
+    // 截帧统计包含加载和预热帧, 先等在途的帧写完
+    gles->getFrameCapture().finish();
+    result.capture = gles->getFrameCapture().getStats();
+    result.video = video.getStats();
+    if (measureMs > 0.0) {
+        result.videoFps = result.video.uploadedFrames * 1000.0 / measureMs;
+        result.videoMBps = result.video.uploadedBytes / 1048576.0 * 1000.0 / measureMs;
+    }
+
+    result.ok = ok;
+    result.fps = measureMs > 0.0 ? scenario.frames * 1000.0 / measureMs : 0.0;
+    result.frameMs = frameTimer.summarize(&GLESFrameSample::frameMs);
+    result.cpuMs = frameTimer.summarize(&GLESFrameSample::cpuMs);
+    result.gpuMs = frameTimer.summarize(&GLESFrameSample::gpuMs);
+    result.scale = frameTimer.summarize(&GLESFrameSample::scale);
+    result.renderTargets = gles->getRenderTargetPool().getStats();
+
+    // 非strict模式下错误不中止帧, 释放时取出剩余的错误后再判断
+    gles->deInitGLState();
+    result.glErrors = gles->getErrorMonitor().getErrorCount();
+    result.ok = result.ok && result.glErrors == 0;
+    gles->cleanProc();
+    return result;
+}
+
+/**
+ * @MethodName: runVerify
+ * @Return: 对比结果, 没有CPU实现的场景effect为空
+ * @Description: GL离屏渲染并经截帧不丢帧地读回到文件(不用有损的ETC2缓存), 再用GLESCompositor按相同的帧时间合成,
+ *               逐帧逐通道对比; 读回的文件自上而下, CPU结果自下而上. 通过时删除读回文件, 失败时保留以便查看
+ */
+static BenchVerify runVerify(const BenchScenario &scenario) {
+    BenchVerify verify;
+    verify.scenario = scenario.name;
+    verify.frames = std::max(2, bench_verify_frames);
+
+    GLESSceneConfig config;
+    config.vshPath = bench_assets + "/shader/test/vsh.vert";
+    config.fshPath = shaderPath(scenario.shader);
+    config.textureSize = scenario.textures;
+    config.programCacheDir = bench_cache ? "program_cache" : "";
+    config.textureCacheDir = bench_cache ? "texture_cache" : "";
+    config.imageFiles = {bench_assets + "/pic/1.jpg", bench_assets + "/pic/2.jpg", bench_assets + "/pic/3.jpg"};
+    config.capturePath = "bench_verify_" + scenario.name + ".rgba";
+    config.captureFormat = "raw";
+    config.captureLossless = true;
+    GLESCompositor::Effect effect;
+    int easing;
+    if (scenario.columns > 0 || scenario.playlist || !scenario.video.empty() || scenario.textures < 1 ||
+        !GLESCompositor::getEffectForShader(config.fshPath, effect) ||
+        !GLESCompositor::parseEasing(config.easing, easing)) {
+        return verify;
+    }
+    verify.effect = GLESCompositor::getEffectName(effect);
+    // 帧时间步长使第一帧和最后一帧分别是过渡的起点和终点
+    double step = 1.0 / (config.speed * (verify.frames - 1));
+
+    /* GL: 纹理全部上传后再画第一帧 */
+    std::unique_ptr<GLESUtils> gles(new GLESUtils());
+    gles->setWindowWH((unsigned) scenario.width, (unsigned) scenario.height);
+    gles->setAppName("GLES Bench");
+    gles->setOffscreen(true);
+    gles->setSceneConfig(config);
+    if (!gles->initNativeAndEGL()) {
+        printf("%s: failed to create EGL context\n", scenario.name.c_str());
+        return verify;
+    }
+    gles->getTextureLoader().setTextureCache(NULL);
+    gles->getFrameTimer().setFixedTimeStep(step);
+    if (!gles->initShaders()) {
+        printf("%s: failed to init shaders\n", scenario.name.c_str());
+        gles->deInitGLState();
+        gles->cleanProc();
+        return verify;
+    }
+    gles->getTextureLoader().finish();
+    glFinish();
+    bool ok = true;
+    double begin = nowMs();
+    for (int i = 0; ok && i < verify.frames; ++i) {
+        ok = renderFrame(*gles);
+    }
+    gles->getFrameCapture().finish();
+    double glMs = nowMs() - begin;
+    verify.glFps = glMs > 0.0 ? verify.frames * 1000.0 / glMs : 0.0;
+    ok = ok && gles->getFrameCapture().getStats().written == (uint64_t) verify.frames;
+    gles->deInitGLState();
+    gles->cleanProc();
+
+    /* CPU: 与着色器相同, s_texture[0]和s_texture[1]分别是第一张和第二张图 */
+    GLESThreadPool pool;
+    GLESImage images[2];
+    for (int i = 0; i < 2; ++i) {
+        ok = GLESTextureLoader::decodeImage(config.imageFiles[i % config.imageFiles.size()], images[i], &pool) && ok;
+    }
+    size_t frameBytes = (size_t) scenario.width * scenario.height * 4;
+    std::vector<unsigned char> frames((size_t) verify.frames * frameBytes);
+    GLESCompositor compositor(&pool);
+    auto compositeAll = [&]() {
+        double compositeBegin = nowMs();
+        for (int i = 0; ok && i < verify.frames; ++i) {
+            float transition = std::min(std::max((float) (i * step) * config.speed, 0.0f), 1.0f);
+            ok = compositor.composite(effect, images[0], images[1], transition,
+                                      GLESCompositor::ease(easing, transition), &frames[i * frameBytes],
+                                      scenario.width, scenario.height);
+        }
+        double compositeMs = nowMs() - compositeBegin;
+        return compositeMs > 0.0 ? verify.frames * 1000.0 / compositeMs : 0.0;
+    };
+    GLESPixelConvert::Isa isa;
+    GLESCompositor::getKernel(GLESPixelConvert::ISA_AVX2, &isa);
+    verify.isa = GLESPixelConvert::getIsaName(isa);
+    verify.cpuThreads = pool.getThreadCount();
+    compositor.setThreadPool(NULL);
+    compositor.setIsa(GLESPixelConvert::ISA_SCALAR);
+    verify.cpuScalarFps = compositeAll();
+    compositor.setIsa(GLESPixelConvert::ISA_AVX2);
+    verify.cpuSingleFps = compositeAll();
+    compositor.setThreadPool(&pool);
+    verify.cpuFps = compositeAll();
+
+    /* 逐帧对比 */
+    FILE *file = ok ? fopen(config.capturePath.c_str(), "rb") : NULL;
+    size_t pitch = (size_t) scenario.width * 4;
+    std::vector<unsigned char> row(pitch);
+    for (int i = 0; file && i < verify.frames; ++i) {
+        for (int y = scenario.height - 1; y >= 0; --y) {
+            if (fread(row.data(), 1, pitch, file) != pitch) {
+                ok = false;
+                break;
+            }
+            const unsigned char *expected = &frames[i * frameBytes + y * pitch];
+            for (size_t c = 0; c < pitch; ++c) {
+                int diff = std::abs((int) row[c] - (int) expected[c]);
+                verify.maxDiff = std::max(verify.maxDiff, diff);
+                verify.overTolerance += diff > bench_tolerance;
+            }
+        }
+    }
+    if (file) {
+        fclose(file);
+    }
+    verify.ok = ok && file && verify.overTolerance == 0;
+    if (verify.ok) {
+        remove(config.capturePath.c_str());
+    }
+    return verify;
+}
+
+/**
+ * @MethodName: runScaling
+ * @Return: threads个实例同时运行的总吞吐
+ * @Description: 每个实例在自己的线程里完成创建上下文、加载和预热, 然后一起开始测量
+ */
+static BenchScaling runScaling(const BenchScenario &scenario, int threads) {
+    BenchScaling scaling;
+    scaling.scenario = scenario.name;
+    scaling.threads = threads;
+    // 测试视频在启动线程前生成, 避免多个实例同时写同一个文件
+    if (!scenario.video.empty() && prepareVideo(scenario.video, scenario.width, scenario.height).empty()) {
+        return scaling;
+    }
+
+    BenchGate gate;
+    gate.expected = threads;
+    std::vector<BenchResult> results((size_t) threads);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&scenario, &results, &gate, i] {
+            GLES_TRACE_THREAD_NAME("bench instance");
+            results[i] = runScenario(scenario, i + 1, &gate);
+        });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    scaling.ok = true;
+    double measureEnd = gate.openedAt;
+    for (const BenchResult &result : results) {
+        scaling.ok = scaling.ok && result.ok;
+        scaling.steadyAllocs += result.steadyAllocs;
+        scaling.instanceFps += result.fps / threads;
+        measureEnd = std::max(measureEnd, result.measureEnd);
+        if (scaling.renderer.empty()) {
+            scaling.renderer = result.renderer;
+        }
+    }
+    if (measureEnd > gate.openedAt) {
+        scaling.totalFps = (double) threads * scenario.frames * 1000.0 / (measureEnd - gate.openedAt);
+    }
+    return scaling;
+}
+
+static double perFrame(const BenchResult &result, uint64_t total) {
+    return result.scenario.frames > 0 ? (double) total / result.scenario.frames : 0.0;
+}
+
+// 图块墙场景显示网格大小, 播放列表场景显示playlist
+static std::string modeLabel(const BenchScenario &scenario) {
+    if (scenario.playlist) {
+        return "playlist ";
+    }
+    if (!scenario.video.empty()) {
+        return scenario.video + " ";
+    }
+    if (scenario.columns <= 0 || scenario.rows <= 0) {
+        return "";
+    }
+    return std::to_string(scenario.columns) + "x" + std::to_string(scenario.rows) + " tiles ";
+}
+
+static void printResult(FILE *file, const BenchResult &result) {
+    const BenchScenario &scenario = result.scenario;
+    fprintf(file, "%-10s %2d tex %4dx%-4d %-5s %s| egl %7.1f program %6.1f%s init %7.1f first %7.1f ready %7.1f ms | "
+            "%7.1f fps  p50 %6.2f p95 %6.2f p99 %6.2f max %6.2f ms | gl %.1f/%.1f | allocs %llu%s\n",
+            scenario.name.c_str(), scenario.textures, scenario.width, scenario.height, scenario.shader.c_str(),
+            modeLabel(scenario).c_str(), result.eglMs, result.programMs, result.programCached ? "*" : " ",
+            result.initMs, result.firstFrameMs, result.texturesReadyMs, result.fps,
+            result.frameMs.p50, result.frameMs.p95, result.frameMs.p99, result.frameMs.max,
+            perFrame(result, result.glCallsIssued), perFrame(result, result.glCallsElided),
+            (unsigned long long) result.steadyAllocs, result.ok ? "" : "  FAILED");
+    if (!scenario.video.empty()) {
+        fprintf(file, "%-10s upload %.1f frames/s %.1f MB/s, pbo busy %llu, starved %llu\n", "", result.videoFps,
+                result.videoMBps, (unsigned long long) result.video.pboBusy,
+                (unsigned long long) result.video.starved);
+    }
+    if (bench_target_ms > 0.0) {
+        fprintf(file, "%-10s scale for %.1f ms target: mean %.3f p50 %.3f max %.3f\n", "", bench_target_ms,
+                result.scale.mean, result.scale.p50, result.scale.max);
+    }
+    if (result.capture.captured > 0) {
+        fprintf(file, "%-10s capture %llu written %llu, dropped gpu %llu queue %llu, max queue %d\n", "",
+                (unsigned long long) result.capture.captured, (unsigned long long) result.capture.written,
+                (unsigned long long) result.capture.droppedGpu, (unsigned long long) result.capture.droppedQueue,
+                result.capture.maxQueueDepth);
+    }
+    if (result.renderTargets.acquires > 0) {
+        const GLESRenderTargetStats &targets = result.renderTargets;
+        fprintf(file, "%-10s post: %d render targets %.1f MB (peak %d in use), %llu acquires %llu reused, "
+                      "%llu invalidations\n", "", targets.targets, (double) targets.peakBytes / 1048576.0,
+                targets.peakInUse, (unsigned long long) targets.acquires,
+                (unsigned long long) targets.reuses, (unsigned long long) targets.invalidations);
+    }
+}
+
+static void printScaling(FILE *file, const BenchScaling &scaling) {
+    fprintf(file, "%-10s %2d threads | %8.1f fps total %8.1f per instance | speedup %5.2fx efficiency %5.1f%% | "
+                  "allocs %llu%s\n", scaling.scenario.c_str(), scaling.threads, scaling.totalFps, scaling.instanceFps,
+            scaling.speedup, scaling.threads > 0 ? scaling.speedup * 100.0 / scaling.threads : 0.0,
+            (unsigned long long) scaling.steadyAllocs, scaling.ok ? "" : "  FAILED");
+}
+
+static void printVerify(FILE *file, const BenchVerify &verify) {
+    if (verify.effect.empty()) {
+        fprintf(file, "%-10s no CPU reference, skipped\n", verify.scenario.c_str());
+        return;
+    }
+    fprintf(file, "%-10s %-4s %2d frames | max diff %d, %llu over tolerance %d | gl+readback %7.1f fps | "
+                  "cpu %s x%u %7.1f fps, x1 %7.1f fps, scalar x1 %7.1f fps%s\n", verify.scenario.c_str(),
+            verify.effect.c_str(), verify.frames, verify.maxDiff, (unsigned long long) verify.overTolerance,
+            bench_tolerance, verify.glFps, verify.isa.c_str(), verify.cpuThreads, verify.cpuFps, verify.cpuSingleFps,
+            verify.cpuScalarFps, verify.ok ? "" : "  FAILED");
+}
+
+static void writeSummary(FILE *file, const char *name, const GLESTimingSummary &summary) {
+    fprintf(file, "\"%s\": {\"count\": %zu, \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, "
+                  "\"max\": %.4f}", name, summary.count, summary.mean, summary.p50, summary.p95, summary.p99,
+            summary.max);
+}
+
+/**
+ * @MethodName: writeJson
+ * @Return: 写文件是否成功
+ * @Description: 机器可读的结果, path为"-"时输出到标准输出
+ */
+static bool writeJson(const std::string &path, const std::vector<BenchResult> &results,
+                      const std::vector<BenchScaling> &scalings, const std::vector<BenchVerify> &verifies) {
+    FILE *file = path == "-" ? stdout : fopen(path.c_str(), "w");
+    if (!file) {
+        printf("Failed to write %s\n", path.c_str());
+        return false;
+    }
+    fprintf(file, "{\n  \"renderer\": \"%s\",\n  \"sync\": %s,\n  \"warmup\": %d,\n  \"alloc_stats\": %s,\n",
+            !results.empty() ? results[0].renderer.c_str() : !scalings.empty() ? scalings[0].renderer.c_str() : "",
+            bench_sync ? "true" : "false", bench_warmup,
+            isAllocStatsEnabled() ? "true" : "false");
+    fprintf(file, "  \"scenarios\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &result = results[i];
+        const BenchScenario &scenario = result.scenario;
+        fprintf(file, "    {\"name\": \"%s\", \"textures\": %d, \"width\": %d, \"height\": %d, \"frames\": %d, "
+                      "\"shader\": \"%s\", \"tiles\": [%d, %d], \"ok\": %s,\n", scenario.name.c_str(), scenario.textures,
+                scenario.width, scenario.height, scenario.frames, scenario.shader.c_str(), scenario.columns,
+                scenario.rows, result.ok ? "true" : "false");
+        fprintf(file, "     \"startup_ms\": {\"egl\": %.3f, \"program\": %.3f, \"init\": %.3f, \"first_frame\": %.3f, "
+                      "\"textures_ready\": %.3f, \"loading_frames\": %d},\n", result.eglMs, result.programMs,
+                result.initMs, result.firstFrameMs, result.texturesReadyMs, result.loadingFrames);
+        fprintf(file, "     \"program_cached\": %s, \"slides_shown\": %llu,\n", result.programCached ? "true" : "false",
+                (unsigned long long) result.slidesShown);
+        fprintf(file, "     \"fps\": %.3f, \"steady_allocs\": %llu, \"gl_errors\": %llu,\n", result.fps,
+                (unsigned long long) result.steadyAllocs, (unsigned long long) result.glErrors);
+        fprintf(file, "     \"video\": {\"format\": \"%s\", \"frames_per_sec\": %.3f, \"mb_per_sec\": %.3f, "
+                      "\"uploaded\": %llu, \"pbo_busy\": %llu, \"starved\": %llu},\n", scenario.video.c_str(),
+                result.videoFps, result.videoMBps, (unsigned long long) result.video.uploadedFrames,
+                (unsigned long long) result.video.pboBusy, (unsigned long long) result.video.starved);
+        fprintf(file, "     \"capture\": {\"captured\": %llu, \"written\": %llu, \"dropped_gpu\": %llu, "
+                      "\"dropped_queue\": %llu, \"max_queue_depth\": %d},\n",
+                (unsigned long long) result.capture.captured, (unsigned long long) result.capture.written,
+                (unsigned long long) result.capture.droppedGpu, (unsigned long long) result.capture.droppedQueue,
+                result.capture.maxQueueDepth);
+        fprintf(file, "     \"render_targets\": {\"count\": %d, \"peak_bytes\": %zu, \"peak_in_use\": %d, "
+                      "\"acquires\": %llu, \"reuses\": %llu, \"allocations\": %llu, \"invalidations\": %llu},\n",
+                result.renderTargets.targets, result.renderTargets.peakBytes, result.renderTargets.peakInUse,
+                (unsigned long long) result.renderTargets.acquires, (unsigned long long) result.renderTargets.reuses,
+                (unsigned long long) result.renderTargets.allocations,
+                (unsigned long long) result.renderTargets.invalidations);
+        fprintf(file, "     \"gl_calls_per_frame\": {\"issued\": %.2f, \"elided\": %.2f},\n     ",
+                perFrame(result, result.glCallsIssued), perFrame(result, result.glCallsElided));
+        writeSummary(file, "frame_ms", result.frameMs);
+        fprintf(file, ",\n     ");
+        writeSummary(file, "cpu_ms", result.cpuMs);
+        fprintf(file, ",\n     ");
+        writeSummary(file, "gpu_ms", result.gpuMs);
+        fprintf(file, ",\n     ");
+        writeSummary(file, "scale", result.scale);
+        fprintf(file, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ],\n  \"hardware_threads\": %u,\n  \"scaling\": [\n", std::thread::hardware_concurrency());
+    for (size_t i = 0; i < scalings.size(); ++i) {
+        const BenchScaling &scaling = scalings[i];
+        fprintf(file, "    {\"name\": \"%s\", \"threads\": %d, \"ok\": %s, \"total_fps\": %.3f, "
+                      "\"instance_fps\": %.3f, \"speedup\": %.3f, \"steady_allocs\": %llu}%s\n",
+                scaling.scenario.c_str(), scaling.threads, scaling.ok ? "true" : "false", scaling.totalFps,
+                scaling.instanceFps, scaling.speedup, (unsigned long long) scaling.steadyAllocs,
+                i + 1 < scalings.size() ? "," : "");
+    }
+    fprintf(file, "  ],\n  \"verify\": [\n");
+    for (size_t i = 0; i < verifies.size(); ++i) {
+        const BenchVerify &verify = verifies[i];
+        fprintf(file, "    {\"name\": \"%s\", \"effect\": \"%s\", \"ok\": %s, \"frames\": %d, \"max_diff\": %d, "
+                      "\"over_tolerance\": %llu, \"tolerance\": %d, \"gl_fps\": %.3f, \"cpu_isa\": \"%s\", "
+                      "\"cpu_threads\": %u, \"cpu_fps\": %.3f, \"cpu_single_fps\": %.3f, \"cpu_scalar_fps\": %.3f}%s\n",
+                verify.scenario.c_str(), verify.effect.c_str(), verify.ok ? "true" : "false", verify.frames,
+                verify.maxDiff, (unsigned long long) verify.overTolerance, bench_tolerance, verify.glFps,
+                verify.isa.c_str(), verify.cpuThreads, verify.cpuFps, verify.cpuSingleFps, verify.cpuScalarFps,
+                i + 1 < verifies.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return file == stdout || fclose(file) == 0;
+}
+
+static void printUsage(const char *name) {
+    printf("Usage: %s [--scenario NAME|all] [--textures N] [--size WxH] [--frames N] [--shader fade|wipe|FILE.frag]\n"
+           "       [--tiles CxR] [--playlist DIR] [--capture raw|png|y4m] [--threads N] [--verify [--tolerance N]] [--dynamic-resolution MS] [--post blur|grade] [--trace FILE] [--gl-errors strict|deferred|callback] [--warmup N] [--no-sync] [--no-cache] [--assets DIR] [--json FILE|-] [--list]\n"
+           "program time marked with * was loaded from the program binary cache, gl is state calls issued/elided per frame\n"
+           "--threads N runs 1, 2, 4 .. N instances concurrently, one EGL context per thread, and reports total throughput\n"
+           "--verify renders --frames N (default 16) across the transition, diffs the read back frames against the CPU\n"
+           "reference compositor and compares their speed\n"
+           "--dynamic-resolution MS renders into a scaled offscreen target adjusted to hit MS per frame, then upscales\n"
+           "--post NAME adds a post processing pass (repeatable, run in order) through the render target pool\n"
+           "--gl-errors selects how GL errors are checked in frames (default: strict in debug, callback in release builds)\n"
+           "--trace FILE writes init and per-frame phase timings as Chrome trace JSON (or set GLES_TRACE=FILE)\n",
+           name);
+}
+
+/**
+ * 主函数
+ * 默认跑default场景; --textures等参数覆盖所选场景的对应值
+ * --threads N时改为测多实例扩展性: 线程数从1倍增到N, 每个线程一个独立的GLESUtils
+ * --verify时改为与CPU参考合成对比, 任一通道差超过--tolerance(默认2)即失败
+ * 任一场景失败或稳态帧有堆分配时返回1
+ */
+int main(int argc, char **argv) {
+    std::string scenarioName = "default";
+    std::string jsonPath;
+    std::string tracePath;
+    int textures = 0, width = 0, height = 0, frames = 0, columns = 0, rows = 0;
+    std::string shader;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--scenario" && hasValue) {
+            scenarioName = argv[++i];
+        } else if (arg == "--textures" && hasValue) {
+            textures = atoi(argv[++i]);
+        } else if (arg == "--size" && hasValue) {
+            sscanf(argv[++i], "%dx%d", &width, &height);
+        } else if (arg == "--frames" && hasValue) {
+            frames = atoi(argv[++i]);
+        } else if (arg == "--tiles" && hasValue) {
+            sscanf(argv[++i], "%dx%d", &columns, &rows);
+        } else if (arg == "--capture" && hasValue) {
+            GLESFrameCapture::Format format;
+            bench_capture = argv[++i];
+            if (!GLESFrameCapture::parseFormat(bench_capture, format)) {
+                printUsage(argv[0]);
+                return 2;
+            }
+        } else if (arg == "--verify") {
+            bench_verify = true;
+        } else if (arg == "--tolerance" && hasValue) {
+            bench_tolerance = atoi(argv[++i]);
+        } else if (arg == "--dynamic-resolution" && hasValue) {
+            bench_target_ms = atof(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            bench_threads = atoi(argv[++i]);
+        } else if (arg == "--playlist" && hasValue) {
+            bench_playlist = argv[++i];
+        } else if (arg == "--shader" && hasValue) {
+            shader = argv[++i];
+        } else if (arg == "--warmup" && hasValue) {
+            bench_warmup = atoi(argv[++i]);
+        } else if (arg == "--assets" && hasValue) {
+            bench_assets = argv[++i];
+        } else if (arg == "--json" && hasValue) {
+            jsonPath = argv[++i];
+        } else if (arg == "--gl-errors" && hasValue) {
+            GLESErrorMonitor::Mode mode;
+            bench_gl_errors = argv[++i];
+            if (!GLESErrorMonitor::parseMode(bench_gl_errors, mode)) {
+                printUsage(argv[0]);
+                return 2;
+            }
+        } else if (arg == "--post" && hasValue) {
+            bench_post.push_back(argv[++i]);
+        } else if (arg == "--trace" && hasValue) {
+            tracePath = argv[++i];
+        } else if (arg == "--no-sync") {
+            bench_sync = false;
+        } else if (arg == "--no-cache") {
+            bench_cache = false;
+        } else if (arg == "--list") {
+            for (const BenchScenario &scenario : bench_scenarios) {
+                printf("%-10s %2d textures %dx%d %d frames %s %s\n", scenario.name.c_str(), scenario.textures,
+                       scenario.width, scenario.height, scenario.frames, scenario.shader.c_str(),
+                       modeLabel(scenario).c_str());
+            }
+            return 0;
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<BenchScenario> scenarios;
+    for (const BenchScenario &scenario : bench_scenarios) {
+        if (scenarioName == "all" || scenario.name == scenarioName) {
+            scenarios.push_back(scenario);
+        }
+    }
+    if (scenarios.empty()) {
+        printf("Unknown scenario: %s\n", scenarioName.c_str());
+        return 2;
+    }
+    for (BenchScenario &scenario : scenarios) {
+        if (textures > 0) { scenario.textures = textures; }
+        if (width > 0 && height > 0) {
+            scenario.width = width;
+            scenario.height = height;
+        }
+        if (frames > 0) { scenario.frames = frames; }
+        if (!shader.empty()) { scenario.shader = shader; }
+        if (columns > 0 && rows > 0) {
+            scenario.columns = columns;
+            scenario.rows = rows;
+        }
+    }
+
+    GLES_TRACE_THREAD_NAME("main");
+    if (!tracePath.empty()) {
+        GLESTrace::start(tracePath);
+    } else {
+        GLESTrace::startFromEnvironment();
+    }
+
+    // JSON输出到标准输出时, 可读的结果改写到标准错误
+    FILE *log = jsonPath == "-" ? stderr : stdout;
+    std::vector<BenchResult> results;
+    std::vector<BenchScaling> scalings;
+    std::vector<BenchVerify> verifies;
+    bool ok = true;
+    if (bench_verify && frames > 0) {
+        bench_verify_frames = frames;
+    }
+    for (const BenchScenario &scenario : scenarios) {
+        if (bench_verify) {
+            verifies.push_back(runVerify(scenario));
+            printVerify(log, verifies.back());
+            ok = ok && (verifies.back().ok || verifies.back().effect.empty());
+            continue;
+        }
+        if (bench_threads > 0) {
+            fprintf(log, "%s scaling, %u hardware threads\n", scenario.name.c_str(),
+                    std::thread::hardware_concurrency());
+            double baseFps = 0.0;
+            // 1, 2, 4 .. 直到N, N本身总会测到
+            for (int threads = 1; threads <= bench_threads; threads = threads == bench_threads ? threads + 1 :
+                                                                       std::min(threads * 2, bench_threads)) {
+                BenchScaling scaling = runScaling(scenario, threads);
+                if (threads == 1) {
+                    baseFps = scaling.totalFps;
+                }
+                scaling.speedup = baseFps > 0.0 ? scaling.totalFps / baseFps : 0.0;
+                scalings.push_back(scaling);
+                printScaling(log, scaling);
+                ok = ok && scaling.ok && scaling.steadyAllocs == 0;
+            }
+            continue;
+        }
+        results.push_back(runScenario(scenario));
+        printResult(log, results.back());
+        ok = ok && results.back().ok && results.back().steadyAllocs == 0;
+    }
+
+    if (!jsonPath.empty()) {
+        writeJson(jsonPath, results, scalings, verifies);
+    }
+    GLESTrace::finish();
+    return ok ? 0 : 1;
+}
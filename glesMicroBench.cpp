@@ -0,0 +1,375 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "GLESCompositor.h"
+#include "GLESPixelConvert.h"
+#include "GLESThreadPool.h"
+#include "GLESTextureCache.h"
+#include "GLESTextureLoader.h"
+#include "GLESUtils.h"
+
+// 微基准参数
+int bench_width = 1600;
+int bench_height = 900;
+int bench_iterations = 30;
+// 着色器和图片所在的目录(相对运行目录)
+std::string bench_assets = "../..";
+
+static double nowMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void fillRandom(std::vector<unsigned char> &data, unsigned seed) {
+    std::mt19937 rng(seed);
+    for (unsigned char &c : data) {
+        c = (unsigned char) (rng() & 0xFF);
+    }
+}
+
+/**
+ * @MethodName: verifyKernel
+ * @Return: 与标量实现是否逐位一致
+ * @Description: 覆盖各种尾部长度, 以及允许原地转换的情形
+ */
+static bool verifyKernel(GLESPixelConvert::Conversion conversion, GLESPixelConvert::Isa isa) {
+    GLESPixelConvert::Kernel reference = GLESPixelConvert::getKernel(conversion, GLESPixelConvert::ISA_SCALAR);
+    GLESPixelConvert::Kernel kernel = GLESPixelConvert::getKernel(conversion, isa);
+    int srcBpp = GLESPixelConvert::getSrcBytesPerPixel(conversion);
+    int dstBpp = GLESPixelConvert::getDstBytesPerPixel(conversion);
+    bool inPlace = srcBpp == dstBpp;
+
+    std::vector<size_t> counts;
+    for (size_t n = 0; n <= 70; ++n) { counts.push_back(n); }
+    counts.push_back(1023);
+    counts.push_back(4097);
+    counts.push_back((size_t) bench_width * 3 + 1);
+
+    for (size_t n : counts) {
+        std::vector<unsigned char> src(n * srcBpp + 64);
+        fillRandom(src, (unsigned) n * 31 + conversion);
+        // 目标多留出一段, 检查不会越界写
+        std::vector<unsigned char> expected(n * dstBpp + 64, 0xCD), actual(n * dstBpp + 64, 0xCD);
+        reference(src.data(), expected.data(), n);
+        kernel(src.data(), actual.data(), n);
+        if (expected != actual) {
+            printf("MISMATCH %s/%s pixels=%zu\n", GLESPixelConvert::getConversionName(conversion),
+                   GLESPixelConvert::getIsaName(isa), n);
+            return false;
+        }
+        if (inPlace) {
+            std::vector<unsigned char> buffer(src);
+            kernel(buffer.data(), buffer.data(), n);
+            if (memcmp(buffer.data(), expected.data(), n * dstBpp) != 0) {
+                printf("MISMATCH in-place %s/%s pixels=%zu\n", GLESPixelConvert::getConversionName(conversion),
+                       GLESPixelConvert::getIsaName(isa), n);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @MethodName: verifyImage
+ * @Return: 带行距、多线程的整图转换是否与逐行标量转换一致
+ */
+static bool verifyImage(GLESPixelConvert::Conversion conversion, GLESThreadPool &pool) {
+    int width = 1023, height = 517;
+    int srcBpp = GLESPixelConvert::getSrcBytesPerPixel(conversion);
+    int dstBpp = GLESPixelConvert::getDstBytesPerPixel(conversion);
+    size_t srcPitch = ((size_t) width * srcBpp + 3) & ~(size_t) 3;
+    size_t dstPitch = (size_t) width * dstBpp + 8;
+
+    std::vector<unsigned char> src(srcPitch * height);
+    fillRandom(src, 7u + conversion);
+    std::vector<unsigned char> expected(dstPitch * height, 0xCD), actual(dstPitch * height, 0xCD);
+    GLESPixelConvert::Kernel reference = GLESPixelConvert::getKernel(conversion, GLESPixelConvert::ISA_SCALAR);
+    for (int y = 0; y < height; ++y) {
+        reference(&src[y * srcPitch], &expected[y * dstPitch], width);
+    }
+    GLESPixelConvert::convertImage(conversion, src.data(), srcPitch, actual.data(), dstPitch, width, height, &pool);
+    if (expected != actual) {
+        printf("MISMATCH image %s\n", GLESPixelConvert::getConversionName(conversion));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @MethodName: benchKernel
+ * @Description: 单线程整图转换, 输出最好和中位数耗时
+ */
+static void benchKernel(GLESPixelConvert::Conversion conversion, GLESPixelConvert::Isa isa) {
+    size_t pixels = (size_t) bench_width * bench_height;
+    std::vector<unsigned char> src(pixels * GLESPixelConvert::getSrcBytesPerPixel(conversion));
+    std::vector<unsigned char> dst(pixels * GLESPixelConvert::getDstBytesPerPixel(conversion));
+    fillRandom(src, 1);
+    GLESPixelConvert::Kernel kernel = GLESPixelConvert::getKernel(conversion, isa);
+
+    std::vector<double> times;
+    for (int i = 0; i < bench_iterations; ++i) {
+        double begin = nowMs();
+        kernel(src.data(), dst.data(), pixels);
+        times.push_back(nowMs() - begin);
+    }
+    std::sort(times.begin(), times.end());
+    double median = times[times.size() / 2];
+    printf("%-18s %-7s %8.3f ms  %8.3f ms  %8.1f MPix/s\n", GLESPixelConvert::getConversionName(conversion),
+           GLESPixelConvert::getIsaName(isa), times[0], median, pixels / median / 1000.0);
+}
+
+static void benchImage(GLESPixelConvert::Conversion conversion, GLESThreadPool &pool) {
+    size_t pixels = (size_t) bench_width * bench_height;
+    int srcBpp = GLESPixelConvert::getSrcBytesPerPixel(conversion);
+    int dstBpp = GLESPixelConvert::getDstBytesPerPixel(conversion);
+    std::vector<unsigned char> src(pixels * srcBpp), dst(pixels * dstBpp);
+    fillRandom(src, 2);
+
+    std::vector<double> times;
+    for (int i = 0; i < bench_iterations; ++i) {
+        double begin = nowMs();
+        GLESPixelConvert::convertImage(conversion, src.data(), (size_t) bench_width * srcBpp, dst.data(),
+                                       (size_t) bench_width * dstBpp, bench_width, bench_height, &pool);
+        times.push_back(nowMs() - begin);
+    }
+    std::sort(times.begin(), times.end());
+    double median = times[times.size() / 2];
+    printf("%-18s %-7s %8.3f ms  %8.3f ms  %8.1f MPix/s  (%u threads)\n",
+           GLESPixelConvert::getConversionName(conversion), "image", times[0], median, pixels / median / 1000.0,
+           pool.getThreadCount());
+}
+
+// 中位数耗时, 单位毫秒
+template<typename F>
+static double medianMs(int iterations, F &&body) {
+    std::vector<double> times;
+    for (int i = 0; i < iterations; ++i) {
+        double begin = nowMs();
+        body();
+        times.push_back(nowMs() - begin);
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+/**
+ * @MethodName: verifyBlend
+ * @Return: 混合核与标量实现是否逐位一致
+ * @Description: 权重覆盖0、1和随机值, 以及各种尾部长度
+ */
+static bool verifyBlend(GLESPixelConvert::Isa isa) {
+    GLESCompositor::BlendKernel reference = GLESCompositor::getKernel(GLESPixelConvert::ISA_SCALAR);
+    GLESCompositor::BlendKernel kernel = GLESCompositor::getKernel(isa);
+    std::vector<size_t> counts;
+    for (size_t n = 0; n <= 40; ++n) { counts.push_back(n); }
+    counts.push_back((size_t) bench_width + 3);
+
+    for (size_t n : counts) {
+        std::vector<unsigned char> first(n * 4), second(n * 4);
+        fillRandom(first, (unsigned) n * 17);
+        fillRandom(second, (unsigned) n * 17 + 1);
+        std::vector<float> weights(n);
+        std::mt19937 rng((unsigned) n);
+        for (size_t i = 0; i < n; ++i) {
+            weights[i] = i % 5 == 0 ? 0.0f : i % 5 == 1 ? 1.0f : (float) (rng() % 100001) / 100000.0f;
+        }
+        std::vector<unsigned char> expected(n * 4 + 64, 0xCD), actual(n * 4 + 64, 0xCD);
+        reference(first.data(), second.data(), weights.data(), expected.data(), n);
+        kernel(first.data(), second.data(), weights.data(), actual.data(), n);
+        if (expected != actual) {
+            printf("MISMATCH blend/%s pixels=%zu\n", GLESPixelConvert::getIsaName(isa), n);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @MethodName: verifyComposite
+ * @Return: 分图块多线程合成是否与单线程标量合成一致
+ * @Description: 输出尺寸不是图块的整数倍, 源图尺寸与输出不同且一张为RGBA
+ */
+static bool verifyComposite(GLESThreadPool &pool) {
+    GLESImage first, second;
+    first.width = 517;
+    first.height = 301;
+    first.pixels.resize((size_t) first.width * first.height * 3);
+    second.width = 211;
+    second.height = 97;
+    second.format = GL_RGBA;
+    second.pixels.resize((size_t) second.width * second.height * 4);
+    fillRandom(first.pixels, 11);
+    fillRandom(second.pixels, 12);
+
+    int width = 1023, height = 517;
+    std::vector<unsigned char> expected((size_t) width * height * 4), actual(expected.size());
+    GLESCompositor reference;
+    reference.setIsa(GLESPixelConvert::ISA_SCALAR);
+    GLESCompositor compositor(&pool);
+    compositor.setTileSize(100, 30);
+    for (int e = 0; e < GLESCompositor::EFFECT_COUNT; ++e) {
+        auto effect = (GLESCompositor::Effect) e;
+        reference.composite(effect, first, second, 0.4f, 0.3f, expected.data(), width, height);
+        compositor.composite(effect, first, second, 0.4f, 0.3f, actual.data(), width, height);
+        if (expected != actual) {
+            printf("MISMATCH composite %s\n", GLESCompositor::getEffectName(effect));
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @MethodName: benchComposite
+ * @Description: 整帧合成: 各指令集单线程, 以及最优指令集加线程池
+ */
+static void benchComposite(GLESThreadPool &pool) {
+    GLESImage first, second;
+    for (GLESImage *image : {&first, &second}) {
+        image->width = bench_width;
+        image->height = bench_height;
+        image->pixels.resize((size_t) bench_width * bench_height * 3);
+        fillRandom(image->pixels, (unsigned) image->width + (image == &second));
+    }
+    std::vector<unsigned char> dst((size_t) bench_width * bench_height * 4);
+    size_t pixels = (size_t) bench_width * bench_height;
+    GLESCompositor compositor;
+
+    printf("\n%-18s %-7s %11s  %14s\n", "composite", "isa", "median", "throughput");
+    for (int isa = GLESPixelConvert::ISA_SCALAR; isa <= GLESPixelConvert::detectIsa(); ++isa) {
+        GLESPixelConvert::Isa actual;
+        GLESCompositor::getKernel((GLESPixelConvert::Isa) isa, &actual);
+        if (actual != isa) {
+            continue;
+        }
+        compositor.setIsa(actual);
+        double median = medianMs(bench_iterations, [&]() {
+            compositor.composite(GLESCompositor::EFFECT_MIX, first, second, 0.5f, 0.5f, dst.data(), bench_width,
+                                 bench_height);
+        });
+        printf("%-18s %-7s %8.3f ms  %8.1f MPix/s\n", "mix", GLESPixelConvert::getIsaName(actual), median,
+               pixels / median / 1000.0);
+    }
+    compositor.setIsa(GLESPixelConvert::ISA_AVX2);
+    compositor.setThreadPool(&pool);
+    for (int e = 0; e < GLESCompositor::EFFECT_COUNT; ++e) {
+        auto effect = (GLESCompositor::Effect) e;
+        double median = medianMs(bench_iterations, [&]() {
+            compositor.composite(effect, first, second, 0.5f, 0.5f, dst.data(), bench_width, bench_height);
+        });
+        printf("%-18s %-7s %8.3f ms  %8.1f MPix/s  (%u threads)\n", GLESCompositor::getEffectName(effect), "tiles",
+               median, pixels / median / 1000.0, pool.getThreadCount());
+    }
+}
+
+/**
+ * @MethodName: benchAssets
+ * @Description: 启动路径上的CPU侧函数: readShader, loadTexture的解码部分(单线程/线程池)和ETC2编码
+ */
+static bool benchAssets(GLESThreadPool &pool) {
+    GLESUtils glesUtils;
+    std::string vshPath = bench_assets + "/shader/test/vsh.vert";
+    std::string fshPath = bench_assets + "/shader/test/fsh.frag";
+    std::string imagePath = bench_assets + "/pic/1.jpg";
+
+    GLESImage image;
+    if (glesUtils.readShader(fshPath).empty() || !GLESTextureLoader::decodeImage(imagePath, image)) {
+        printf("assets not found under %s, use --assets DIR\n", bench_assets.c_str());
+        return false;
+    }
+
+    printf("\n%-18s %11s\n", "function", "median");
+    double readMs = medianMs(bench_iterations, [&]() {
+        glesUtils.readShader(vshPath);
+        glesUtils.readShader(fshPath);
+    });
+    printf("%-18s %8.3f ms  (2 files)\n", "readShader", readMs);
+
+    double decodeMs = medianMs(std::max(1, bench_iterations / 5), [&]() {
+        GLESTextureLoader::decodeImage(imagePath, image);
+    });
+    printf("%-18s %8.3f ms  (%dx%d)\n", "decodeImage", decodeMs, image.width, image.height);
+
+    double decodePoolMs = medianMs(std::max(1, bench_iterations / 5), [&]() {
+        GLESTextureLoader::decodeImage(imagePath, image, &pool);
+    });
+    printf("%-18s %8.3f ms  (%u threads)\n", "decodeImage pool", decodePoolMs, pool.getThreadCount());
+
+    std::vector<unsigned char> blocks;
+    double encodeMs = medianMs(std::max(1, bench_iterations / 10), [&]() {
+        GLESTextureCache::encodeEtc2(image, blocks, &pool);
+    });
+    printf("%-18s %8.3f ms  (%u threads)\n", "encodeEtc2", encodeMs, pool.getThreadCount());
+    return true;
+}
+
+/**
+ * 主函数
+ * 用法: gles_microbench [--verify] [--size WxH] [--iterations N] [--assets DIR]
+ * --verify 只做逐位校验; 校验失败时返回1
+ */
+int main(int argc, char **argv) {
+    bool verifyOnly = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--verify") {
+            verifyOnly = true;
+        } else if (arg == "--size" && i + 1 < argc) {
+            sscanf(argv[++i], "%dx%d", &bench_width, &bench_height);
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            bench_iterations = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--assets" && i + 1 < argc) {
+            bench_assets = argv[++i];
+        } else {
+            printf("Usage: %s [--verify] [--size WxH] [--iterations N] [--assets DIR]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    GLESThreadPool pool;
+    GLESPixelConvert::Isa best = GLESPixelConvert::detectIsa();
+    printf("cpu isa: %s\n", GLESPixelConvert::getIsaName(best));
+
+    /* 逐位校验 */
+    bool ok = true;
+    for (int c = 0; c < GLESPixelConvert::CONVERSION_COUNT; ++c) {
+        auto conversion = (GLESPixelConvert::Conversion) c;
+        for (int isa = GLESPixelConvert::ISA_SCALAR + 1; isa <= best; ++isa) {
+            ok = verifyKernel(conversion, (GLESPixelConvert::Isa) isa) && ok;
+        }
+        ok = verifyImage(conversion, pool) && ok;
+    }
+    for (int isa = GLESPixelConvert::ISA_SCALAR + 1; isa <= best; ++isa) {
+        ok = verifyBlend((GLESPixelConvert::Isa) isa) && ok;
+    }
+    ok = verifyComposite(pool) && ok;
+    printf("verify: %s\n", ok ? "ok" : "FAILED");
+    if (verifyOnly || !ok) {
+        return ok ? 0 : 1;
+    }
+
+    /* 吞吐 */
+    printf("\n%-18s %-7s %11s  %11s  %14s\n", "kernel", "isa", "best", "median", "throughput");
+    for (int c = 0; c < GLESPixelConvert::CONVERSION_COUNT; ++c) {
+        auto conversion = (GLESPixelConvert::Conversion) c;
+        for (int isa = GLESPixelConvert::ISA_SCALAR; isa <= best; ++isa) {
+            // 只测有专门实现的指令集
+            GLESPixelConvert::Isa actual;
+            GLESPixelConvert::getKernel(conversion, (GLESPixelConvert::Isa) isa, &actual);
+            if (actual == isa) {
+                benchKernel(conversion, (GLESPixelConvert::Isa) isa);
+            }
+        }
+        benchImage(conversion, pool);
+    }
+    benchComposite(pool);
+
+    /* 启动路径 */
+    return benchAssets(pool) ? 0 : 1;
+}
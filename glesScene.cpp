@@ -0,0 +1,599 @@
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "GLESUtils.h"
+#include "GLESCompositor.h"
+#include "GLESTrace.h"
+
+#define DYNAMICGLES_NO_NAMESPACE
+#define DYNAMICEGL_NO_NAMESPACE
+
+#include <DynamicGles.h>
+
+// 每个图块的切换周期(秒)在这个范围内变化, 避免整面墙同时切换
+static const float TILE_PERIOD_MIN = 2.0f;
+static const float TILE_PERIOD_MAX = 5.0f;
+
+/**
+ * @MethodName: initShaders
+ * @Return: 初始化是否成功
+ * @Description: 初始化shaders
+ */
+bool GLESUtils::initShaders() {
+    GLES_TRACE_SCOPE("initShaders");
+    const GLESSceneConfig &config = _sceneConfig;
+    // 纹理数组和实例化绘制都需要GLES3
+    bool tiles = config.tileColumns > 0 && config.tileRows > 0;
+    if (tiles && _glesVersion < 3) {
+        printf("Tile wall needs OpenGL ES 3, drawing a single quad instead\n");
+        tiles = false;
+    }
+    // 视频输入优先于图块墙和图片
+    bool video = !config.videoPath.empty();
+    if (video && _glesVersion < 3) {
+        printf("Video input needs OpenGL ES 3\n");
+        return false;
+    }
+
+    // 帧内的错误检查策略, 回调模式需要GL_KHR_debug
+    GLESErrorMonitor::Mode errorMode;
+    if (!GLESErrorMonitor::parseMode(config.glErrorMode, errorMode)) {
+        printf("Unknown GL error mode: %s\n", config.glErrorMode.c_str());
+        return false;
+    }
+    if (_errorMonitor.init(errorMode, config.glErrorInterval, _caps.khrDebug) != errorMode) {
+        printf("GL_KHR_debug not supported, checking GL errors every %d frames\n", config.glErrorInterval);
+    }
+
+    // 截帧用PBO和栅栏, 同样需要GLES3
+    if (!config.capturePath.empty() && !_capture.isActive()) {
+        GLESFrameCapture::Format format;
+        if (!GLESFrameCapture::parseFormat(config.captureFormat, format)) {
+            printf("Unknown capture format: %s\n", config.captureFormat.c_str());
+            return false;
+        }
+        if (_glesVersion < 3 ||
+            !_capture.start(config.capturePath, format, (int) _winWidth, (int) _winHeight, config.captureFps)) {
+            printf("Failed to start frame capture\n");
+            return false;
+        }
+        _capture.setLossless(config.captureLossless);
+    }
+
+    // 动态分辨率的离屏颜色纹理和放大着色器同样需要GLES3; 不支持时按窗口大小绘制
+    if (config.dynamicResolution && !_resolution.isEnabled()) {
+        _resolution.setTarget(config.targetFrameMs, config.minScale, config.maxScale, config.scaleHysteresis);
+        if (_glesVersion < 3) {
+            printf("Dynamic resolution needs OpenGL ES 3, rendering at full size\n");
+        } else if (_resolution.init((int) _winWidth, (int) _winHeight)) {
+            printf("Dynamic resolution: target %.1f ms, scale %.2f~%.2f\n", config.targetFrameMs, config.minScale,
+                   config.maxScale);
+        }
+    }
+
+    // 后处理的离屏目标同样需要GLES3; pass名字写错时不启动
+    if (!config.postPasses.empty() && !_postProcess.isEnabled()) {
+        if (_glesVersion < 3) {
+            printf("Post processing needs OpenGL ES 3, presenting the scene directly\n");
+        } else if (!_postProcess.init(config, _shaderPreprocessor, (int) _winWidth, (int) _winHeight)) {
+            return false;
+        }
+    }
+
+    /* 读取shader文件, 纹理个数、缓动曲线、精度和视频格式作为宏注入, 同一份源码按组合特化成不同的变体 */
+    std::string vshPath, fshPath;
+    GLESShaderPreprocessor::Defines defines;
+    if (!getShaderVariant(tiles, video, vshPath, fshPath, defines, _easing)) {
+        return false;
+    }
+    // 擦除效果交换时只提交边缘一带; 后处理(模糊)会把变化扩散出去, 不计算
+    GLESCompositor::Effect effect;
+    _wipeEffect = !video && !tiles && !_postProcess.isEnabled() &&
+                  GLESCompositor::getEffectForShader(config.fshPath, effect) && effect == GLESCompositor::EFFECT_WIPE;
+    _presentedTransition = -1.0f;
+    _redrawPending = true;
+    std::string vshStr, fshStr;
+    if (!_shaderPreprocessor.load(vshPath, defines, vshStr)) {
+        return false;
+    }
+    std::vector<std::string> vshFiles = _shaderPreprocessor.getFiles();
+    if (!_shaderPreprocessor.load(fshPath, defines, fshStr)) {
+        return false;
+    }
+
+    // 编译链接并反射(有程序二进制缓存时直接加载), 固定属性位置与全屏四边形网格和图块实例数据的布局对应
+    std::vector<std::pair<GLuint, std::string> > attribBindings = {
+            {0, "a_position"},
+            {1, "a_texCoord"},
+            {2, "a_rect"},
+            {3, "a_timing"}
+    };
+    _programCache.setCacheDir(config.programCacheDir);
+    if (!buildProgram(vshStr, fshStr, attribBindings)) {
+        // 编译错误中的源串号对应展开时包含的文件
+        for (size_t i = 0; i < vshFiles.size(); ++i) {
+            printf("  vertex source %zu: %s\n", i, vshFiles[i].c_str());
+        }
+        for (size_t i = 0; i < _shaderPreprocessor.getFiles().size(); ++i) {
+            printf("  fragment source %zu: %s\n", i, _shaderPreprocessor.getFiles()[i].c_str());
+        }
+        return false;
+    }
+    printf("Shader program ready in %.2f ms (%s)\n", getProgramSetupMs(),
+           isProgramFromCache() ? "binary cache" : "compiled");
+
+    // 帧内使用的uniform句柄
+    _progressUniform = _program.findUniform("progress");
+    _speedUniform = _program.findUniform("speed");
+    _transitionUniform = _program.findUniform("transition");
+    _easedTransitionUniform = _program.findUniform("easedTransition");
+    _samplerUniform = _program.findUniform(tiles ? "s_tiles" : "s_texture");
+    _layerCountUniform = _program.findUniform("layerCount");
+    _videoSamplerUniforms[0] = _program.findUniform("s_y");
+    _videoSamplerUniforms[1] = _program.findUniform("s_u");
+    _videoSamplerUniforms[2] = _program.findUniform("s_v");
+    _colorMatrixUniform = _program.findUniform("colorMatrix");
+    setSamplerLoc(_program.getUniformLocation(tiles ? "s_tiles" : "s_texture"));
+    // 启动任务图已经设置时后台可能正在读缓存, 不再改动
+    if (_textureCache.getCacheDir() != config.textureCacheDir) {
+        _textureCache.setCacheDir(config.textureCacheDir);
+    }
+
+    /* 上传全屏四边形, 之后每帧直接使用显存中的数据 */
+    GLfloat vVertices[] = {-1.0f, 1.0f, 0.0f,  // Position 0
+                           0.0f, 1.0f,        // TexCoord 0
+                           -1.0f, -1.0f, 0.0f,  // Position 1
+                           0.0f, 0.0f,        // TexCoord 1
+                           1.0f, -1.0f, 0.0f,  // Position 2
+                           1.0f, 0.0f,        // TexCoord 2
+                           1.0f, 1.0f, 0.0f,  // Position 3
+                           1.0f, 1.0f         // TexCoord 3
+    };
+    GLushort indices[] = {0, 1, 2, 0, 2, 3};
+    std::vector<GLESVertexAttrib> attribs = {
+            {0, 3, GL_FLOAT, GL_FALSE, 0},                   // a_position
+            {1, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat)}  // a_texCoord
+    };
+    _quadMesh = _geometry.registerMesh("quad", vVertices, sizeof(vVertices), 5 * sizeof(GLfloat), attribs,
+                                       indices, 6);
+    if (_quadMesh < 0) {
+        return false;
+    }
+
+    _stateCache.clearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    if (video) {
+        return initVideo();
+    }
+    if (tiles) {
+        return initTiles();
+    }
+
+    /* 加载贴图 */
+
+    // 播放列表: 纹理槽位按窗口大小一次分配, 图片在后台解码后逐张替换槽位内容
+    if (!config.playlistPaths.empty()) {
+        for (const std::string &path : config.playlistPaths) {
+            _playlist.addPath(path);
+        }
+        // 着色器在progress * speed达到1时完成渐变
+        _playlist.setTiming(config.playlistHold, 1.0 / config.speed);
+        if (!_playlist.start(config.playlistSlots, (int) _winWidth, (int) _winHeight)) {
+            printf("Failed to start playlist\n");
+            return false;
+        }
+        setTextureSize(config.textureSize);
+        printf("Playlist: %zu images, %d texture slots\n", _playlist.getSize(), config.playlistSlots);
+        return true;
+    }
+
+    // 贴图个数设置, 纹理对象由loadMoreTexture生成
+    setTextureSize(config.textureSize);
+
+    // 异步加载: 先用占位纹理开始绘制, 解码完成后在renderScene中逐帧上传; 有ETC2缓存时直接上传压缩数据.
+    // 启动任务图预取的图片直接使用, 之后不再需要预取表
+    std::vector<GLESTextureHandle> handles = loadMoreTextureAsync(getImageFiles());
+    _textureLoader.clearPrefetched();
+    std::vector<GLuint> vectorTextureID(handles.size());
+    for (size_t i = 0; i < handles.size(); ++i) {
+        vectorTextureID[i] = handles[i].textureID;
+    }
+    setVectorTextureID(vectorTextureID);
+
+    return true;
+}
+
+/**
+ * @MethodName: getShaderVariant
+ * @Return: 配置是否有效
+ * @Description: 视频输入优先于图块墙, 图块墙优先于单个全屏四边形; 图块墙使用自己的缓动曲线
+ */
+bool GLESUtils::getShaderVariant(bool tiles, bool video, std::string &vshPath, std::string &fshPath,
+                                 GLESShaderPreprocessor::Defines &defines, int &easing) const {
+    const GLESSceneConfig &config = _sceneConfig;
+    const std::string &easingName = tiles ? config.tileEasing : config.easing;
+    if (!GLESCompositor::parseEasing(easingName, easing)) {
+        printf("Unknown easing: %s\n", easingName.c_str());
+        return false;
+    }
+    defines = {
+            {"TEXTURE_COUNT", std::to_string(std::max(1, config.textureSize))},
+            {"EASING",        std::to_string(easing)},
+            {"PRECISION",     config.precision}
+    };
+    GLESVideoSource::Format videoFormat = GLESVideoSource::FORMAT_I420;
+    if (video && config.videoWidth > 0 && config.videoHeight > 0 &&
+        GLESVideoSource::parseFormat(config.videoFormat, videoFormat) && videoFormat == GLESVideoSource::FORMAT_NV12) {
+        defines.emplace_back("VIDEO_NV12", "1");
+    }
+    defines.insert(defines.end(), config.shaderDefines.begin(), config.shaderDefines.end());
+    vshPath = video ? config.videoVshPath : tiles ? config.tileVshPath : config.vshPath;
+    fshPath = video ? config.videoFshPath : tiles ? config.tileFshPath : config.fshPath;
+    return true;
+}
+
+std::vector<std::string> GLESUtils::getImageFiles() const {
+    std::vector<std::string> files;
+    for (int i = 0; i < _sceneConfig.textureSize && !_sceneConfig.imageFiles.empty(); ++i) {
+        files.push_back(_sceneConfig.imageFiles[i % _sceneConfig.imageFiles.size()]);
+    }
+    return files;
+}
+
+/**
+ * @MethodName: initVideo
+ * @Return: 初始化是否成功
+ * @Description: 设置了视频宽高时按裸帧读取, 否则按Y4M解析
+ */
+bool GLESUtils::initVideo() {
+    const GLESSceneConfig &config = _sceneConfig;
+    bool opened;
+    if (config.videoWidth > 0 && config.videoHeight > 0) {
+        GLESVideoSource::Format format;
+        if (!GLESVideoSource::parseFormat(config.videoFormat, format)) {
+            printf("Unknown video format: %s\n", config.videoFormat.c_str());
+            return false;
+        }
+        opened = _video.openRaw(config.videoPath, config.videoWidth, config.videoHeight, format);
+    } else {
+        opened = _video.openY4m(config.videoPath);
+    }
+    if (!opened) {
+        return false;
+    }
+    _video.setLoop(config.videoLoop);
+    printf("Video: %dx%d %s, %zu bytes per frame\n", _video.getWidth(), _video.getHeight(),
+           _video.getFormat() == GLESVideoSource::FORMAT_NV12 ? "NV12" : "I420", _video.getFrameBytes());
+    return true;
+}
+
+/**
+ * @MethodName: initTiles
+ * @Return: 初始化是否成功
+ * @Description: 图片全部放进一个纹理数组, 每个图块的位置、起始层和切换节奏作为逐实例数据只上传一次;
+ *               之后每帧只更新时间uniform, 整面墙一次实例化绘制
+ */
+bool GLESUtils::initTiles() {
+    const GLESSceneConfig &config = _sceneConfig;
+    _tileTexture = _textureLoader.loadTextureArray(config.imageFiles, _tileLayers);
+    if (!_tileTexture) {
+        printf("Failed to load tile images\n");
+        return false;
+    }
+
+    // 每个实例: 中心和半宽高(NDC, 留出缝隙), 起始层, 相位, 周期
+    const int floatsPerTile = 7;
+    _tileCount = config.tileColumns * config.tileRows;
+    std::vector<GLfloat> instances((size_t) _tileCount * floatsPerTile);
+    float halfWidth = 1.0f / config.tileColumns;
+    float halfHeight = 1.0f / config.tileRows;
+    for (int i = 0; i < _tileCount; ++i) {
+        int column = i % config.tileColumns;
+        int row = i / config.tileColumns;
+        // 整数哈希得到可复现的伪随机节奏, 同样的网格每次运行画面一致
+        uint32_t hash = (uint32_t) i * 2654435761u;
+        hash ^= hash >> 16;
+        GLfloat *tile = &instances[(size_t) i * floatsPerTile];
+        tile[0] = -1.0f + (2 * column + 1) * halfWidth;
+        tile[1] = 1.0f - (2 * row + 1) * halfHeight;
+        tile[2] = halfWidth * 0.94f;
+        tile[3] = halfHeight * 0.94f;
+        tile[4] = (GLfloat) (hash % (uint32_t) _tileLayers);
+        tile[5] = (GLfloat) ((hash >> 8) & 0xFF) / 256.0f;
+        tile[6] = TILE_PERIOD_MIN + (TILE_PERIOD_MAX - TILE_PERIOD_MIN) * (GLfloat) (hash & 0xFF) / 255.0f;
+    }
+    std::vector<GLESVertexAttrib> instanceAttribs = {
+            {2, 4, GL_FLOAT, GL_FALSE, 0},                   // a_rect
+            {3, 3, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat)}  // a_timing
+    };
+    if (!_geometry.setInstanceData(_quadMesh, instances.data(), (GLsizeiptr) (instances.size() * sizeof(GLfloat)),
+                                   floatsPerTile * sizeof(GLfloat), instanceAttribs, _tileCount)) {
+        printf("Failed to upload tile instances\n");
+        return false;
+    }
+    printf("Tile wall: %dx%d tiles, %d layers\n", config.tileColumns, config.tileRows, (int) _tileLayers);
+    return true;
+}
+
+/**
+ * @MethodName: renderScene
+ * @Return: 绘制是否要结束
+ * @Description: 绘制一帧并统计帧内的堆分配; 画面没有变化时跳过这一帧, 在帧外等待窗口消息或定时器
+ */
+bool GLESUtils::renderScene() {
+    GLES_TRACE_SCOPE("frame");
+    beginFrame();
+    bool result = drawScene();
+    endFrame();
+    if (result && !_frameStats.presented) {
+        result = waitNativeEvents(_sceneConfig.idleWaitMs);
+    }
+    return result;
+}
+
+/**
+ * @MethodName: needsRedraw
+ * @Return: 本帧是否要绘制
+ * @Description: 在提交完本帧的状态之后调用; 状态缓存实际发出了调用(程序、纹理绑定、uniform值)就说明画面变了.
+ *               截帧要每帧都有画面, 不跳过
+ */
+bool GLESUtils::needsRedraw(bool changed) {
+    if (!_sceneConfig.idleSkip || _redrawPending || changed || _capture.isActive() ||
+        _stateCache.getCounters().issued > 0) {
+        return true;
+    }
+    // 画面静止时不再受帧耗时限制, 按最高比例重画一次
+    return _resolution.restoreMaxScale();
+}
+
+/**
+ * @MethodName: skipFrame
+ * @Return: 绘制是否要结束
+ * @Description: 后台缓冲和显示的内容都不变, 不绘制也不交换
+ */
+bool GLESUtils::skipFrame() {
+    GLES_TRACE_SCOPE("skipFrame");
+    _frameTimer.endGpuFrame();
+    return handleNativeEvents();
+}
+
+/**
+ * @MethodName: clearSceneTarget
+ * @Description: 开启动态分辨率时场景画到FBO中缩小的区域, 交换前再放大; 有后处理时场景的输出是池中的离屏目标
+ */
+void GLESUtils::clearSceneTarget() {
+    GLuint output = _postProcess.isEnabled() ? _postProcess.beginScene() : 0;
+    if (_resolution.isEnabled()) {
+        _resolution.bind(output);
+    }
+
+    //	Clears the color buffer.
+    //	glClear is used here with the Color Buffer to clear the color. It can also be used to clear the depth or stencil buffer using
+    //	GL_DEPTH_BUFFER_BIT or GL_STENCIL_BUFFER_BIT, respectively.
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+/**
+ * @MethodName: drawScene
+ * @Return: 绘制是否要结束
+ * @Description: 绘制, 帧内不做堆分配, 临时数据放在帧内存池
+ */
+bool GLESUtils::drawScene() {
+    GLES_TRACE_SCOPE("drawScene");
+    // 上传已解码完成的纹理, 每帧最多一张, 避免单帧卡顿
+    bool uploaded = _textureLoader.pumpUploads(1) > 0;
+    // 按上一帧的帧间隔调整渲染比例, 比例变了要整屏重画
+    bool rescaled = _resolution.update(_frameTimer.getFrameInterval());
+
+    //	Use the Program
+    //	Calling glUseProgram tells OpenGL ES that the application intends to use this program for rendering. Now that it's installed into
+    //	the current state, any further glDraw* calls will use the shaders contained within it to process scene data. Only one program can
+    //	be active at once, so in a multi-program application this function would be called in the render loop. Since this application only
+    //	uses one program it can be installed in the current state and left there.
+    // 程序不变时状态缓存会省掉这次调用
+    _program.use();
+
+    if (!testGLError("glUseProgram")) { return false; }
+
+    // 进度控制, 使用本帧开始时的墙钟时间
+    double progress = _frameTimer.getFrameTime();
+
+    // 图块墙: 纹理数组固定在0号单元, 所有图块一次绘制
+    if (_tileTexture) {
+        _stateCache.bindTextureUnit(0, GL_TEXTURE_2D_ARRAY, _tileTexture);
+        _program.setUniform1f(_progressUniform, (GLfloat) progress);
+        _program.setUniform1f(_speedUniform, (GLfloat) _sceneConfig.speed);
+        _program.setUniform1f(_layerCountUniform, (GLfloat) _tileLayers);
+        _program.setUniform1i(_samplerUniform, 0);
+        if (!needsRedraw(uploaded || rescaled)) {
+            return skipFrame();
+        }
+        GLES_TRACE_SCOPE("draw");
+        clearSceneTarget();
+        _geometry.drawMeshInstanced(_quadMesh);
+        if (!testGLError("glDrawElementsInstanced")) { return false; }
+        return presentFrame();
+    }
+
+    // 视频: 有新帧时经PBO上传, 否则继续显示上一帧; 各平面依次放在0~2号单元
+    if (_video.isOpen()) {
+        bool newFrame = _video.update();
+        for (int i = 0; i < _video.getPlaneCount(); ++i) {
+            _stateCache.bindTextureUnit((GLuint) i, GL_TEXTURE_2D, _video.getPlaneTexture(i));
+            _program.setUniform1i(_videoSamplerUniforms[i], i);
+        }
+        GLfloat colorMatrix[16];
+        _video.getColorMatrix(colorMatrix);
+        _program.setUniformMatrix4fv(_colorMatrixUniform, colorMatrix);
+        if (!needsRedraw(newFrame || uploaded || rescaled)) {
+            return skipFrame();
+        }
+        GLES_TRACE_SCOPE("draw");
+        clearSceneTarget();
+        _geometry.drawMesh(_quadMesh);
+        if (!testGLError("glDrawElements")) { return false; }
+        return presentFrame();
+    }
+
+    // Bind the texture, 各单元已绑定的纹理不会重复提交
+    const std::vector<GLuint> &vectorTextureID = _vectorTextureID;
+    auto textureCount = (GLsizei) vectorTextureID.size();
+    for (GLsizei i = 0; i < textureCount; ++i) {
+        _stateCache.bindTextureUnit((GLuint) i, GL_TEXTURE_2D, vectorTextureID[i]);
+    }
+
+    // 播放列表: 当前图片在0号单元, 下一张在1号单元, 进度为本次渐变已进行的时间
+    if (_playlist.isActive()) {
+        _playlist.update(progress);
+        _stateCache.bindTextureUnit(0, GL_TEXTURE_2D, _playlist.getCurrentTexture());
+        _stateCache.bindTextureUnit(1, GL_TEXTURE_2D, _playlist.getNextTexture());
+        textureCount = (GLsizei) getTextureSize();
+        progress = _playlist.getTransitionTime();
+    }
+
+    // 采样器对应的纹理单元, 放在帧内存池里
+    GLint *values = _frameArena.allocArray<GLint>(textureCount);
+    for (GLsizei i = 0; i < textureCount; ++i) {
+        values[i] = i;
+    }
+
+    /* 传参 */
+    _program.setUniform1f(_progressUniform, (GLfloat) progress);
+    _program.setUniform1f(_speedUniform, (GLfloat) _sceneConfig.speed);
+
+    // 设置采样器变量
+    _program.setUniform1iv(_samplerUniform, textureCount, values);
+
+    // 到这里为止的变化影响整个画面, 之后只有过渡进度
+    bool fullChange = _redrawPending || uploaded || rescaled || _stateCache.getCounters().issued > 0;
+
+    // 只依赖uniform的过渡进度每帧在CPU上算一次, 不在每个片元里重复计算
+    float transition = std::min(std::max((float) progress * _sceneConfig.speed, 0.0f), 1.0f);
+    _program.setUniform1f(_transitionUniform, transition);
+    _program.setUniform1f(_easedTransitionUniform, GLESCompositor::ease(_easing, transition));
+
+    // 过渡结束后uniform的值不再变化, 状态缓存不会发出调用, 画面静止
+    float scale = _resolution.getScale();
+    if (!needsRedraw(uploaded || rescaled)) {
+        return skipFrame();
+    }
+    fullChange = fullChange || scale != _resolution.getScale();
+
+    // 擦除: 只有新旧两条边缘之间(各外扩软化宽度)的列会变化, 与wipe.frag中的edge一致
+    EGLint *damage = NULL;
+    if (_wipeEffect && !fullChange && _presentedTransition >= 0.0f) {
+        float previousEdge = _presentedTransition * 1.2f - 0.1f;
+        float edge = transition * 1.2f - 0.1f;
+        auto width = (int) _winWidth;
+        // 缩小渲染时放大的线性过滤会把变化扩散到相邻的一个源像素
+        int padding = (_resolution.isEnabled() ? (int) (1.0f / _resolution.getScale()) : 0) + 2;
+        int x0 = std::max(0, (int) ((std::min(previousEdge, edge) - 0.1f) * (float) width) - padding);
+        int x1 = std::min(width, (int) ((std::max(previousEdge, edge) + 0.1f) * (float) width) + padding);
+        if (x1 > x0) {
+            damage = _frameArena.allocArray<EGLint>(4);
+            damage[0] = x0;
+            damage[1] = 0;
+            damage[2] = x1 - x0;
+            damage[3] = (EGLint) _winHeight;
+        }
+    }
+
+    GLES_TRACE_SCOPE("draw");
+    clearSceneTarget();
+
+    //	Draw the triangle
+    //	glDrawArrays is a draw call, and executes the shader program using the vertices and other state set by the user. Draw calls are the
+    //	functions which tell OpenGL ES when to actually draw something to the framebuffer given the current state.
+    //	glDrawArrays causes the vertices to be submitted sequentially from the position given by the "first" argument until it has processed
+    //	"count" vertices. Other draw calls exist, notably glDrawElements which also accepts index data to allow the user to specify that
+    //	some vertices are accessed multiple times, without copying the vertex multiple times.
+    //	Others include versions of the above that allow the user to draw the same object multiple times with slightly different data, and
+    //	a version of glDrawElements which allows a user to restrict the actual indices accessed.
+
+    _geometry.drawMesh(_quadMesh);
+
+    if (!testGLError("glDrawElements")) { return false; }
+
+    if (!presentFrame(damage)) { return false; }
+    _presentedTransition = transition;
+    return true;
+}
+
+/**
+ * @MethodName: presentFrame
+ * @Return: 绘制是否要结束
+ * @Description: 丢弃不再需要的缓冲内容, 交换并处理窗口消息. 后台缓冲总是整屏重画, damage只告诉窗口系统哪些区域
+ *               与上一帧不同, 合成器可以只更新这些区域
+ */
+bool GLESUtils::presentFrame(const EGLint *damage) {
+    GLES_TRACE_SCOPE("presentFrame");
+    // 缩小画好的场景放大到整个surface, 有后处理时放大到场景目标
+    if (_resolution.isEnabled()) {
+        GLES_TRACE_SCOPE("upscale");
+        _resolution.resolve(_postProcess.getSceneFramebuffer());
+        if (!testGLError("upscale")) { return false; }
+    }
+
+    // 依次执行后处理pass, 最后一个画到surface
+    if (_postProcess.isEnabled()) {
+        GLES_TRACE_SCOPE("postProcess");
+        if (!_postProcess.run()) {
+            printf("Post processing failed\n");
+            return false;
+        }
+        if (!testGLError("postProcess")) { return false; }
+    }
+
+    // Invalidate the contents of the specified buffers for the framebuffer to allow the implementation further optimization opportunities.
+    // The following is taken from https://www.khronos.org/registry/OpenGL/extensions/EXT/EXT_discard_framebuffer.txt
+    // Some OpenGL ES implementations cache framebuffer images in a small pool of fast memory.  Before rendering, these implementations must load the
+    // existing contents of one or more of the logical buffers (color, depth, stencil, etc.) into this memory.  After rendering, some or all of these
+    // buffers are likewise stored back to external memory so their contents can be used again in the future.  In many applications, some or all of the
+    // logical buffers  are cleared at the start of rendering.  If so, the effort to load or store those buffers is wasted.
+
+    // Even without this extension, if a frame of rendering begins with a full-screen Clear, an OpenGL ES implementation may optimize away the loading
+    // of framebuffer contents prior to rendering the frame.  With this extension, an application can use DiscardFramebufferEXT to signal that framebuffer
+    // contents will no longer be needed.  In this case an OpenGL ES implementation may also optimize away the storing back of framebuffer contents after rendering the frame.
+    // GLES3的glInvalidateFramebuffer是同一机制, 还适用于离屏帧缓冲; 渲染目标池按能力选择入口
+    if (_caps.invalidateFramebuffer || _caps.discardFramebuffer) {
+        GLenum invalidateAttachments[2];
+        invalidateAttachments[0] = GL_DEPTH;
+        invalidateAttachments[1] = GL_STENCIL;
+
+        _renderTargets.invalidate(2, &invalidateAttachments[0]);
+        if (!testGLError("invalidateFramebuffer")) { return false; }
+    }
+
+    // GPU计时在交换前结束, 只统计本帧的绘制命令
+    _frameTimer.endGpuFrame();
+
+    // 交换后后台缓冲内容不再有效, 截帧要在交换前发起读回
+    _capture.capture();
+
+    //	Present the display data to the screen.
+    //	When rendering to a Window surface, OpenGL ES is double buffered. This means that OpenGL ES renders directly to one frame buffer,
+    //	known as the back buffer, whilst the display reads from another - the front buffer. eglSwapBuffers signals to the windowing system
+    //	that OpenGL ES 2.0 has finished rendering a scene, and that the display should now draw to the screen from the new data. At the same
+    //	time, the front buffer is made available for OpenGL ES 2.0 to start rendering to. In effect, this call swaps the front and back
+    //	buffers.
+    // 交换可能阻塞等待显示, 单独计时
+    bool withDamage = damage && _swapBuffersWithDamage;
+    EGLBoolean swapped;
+    {
+        GLES_TRACE_SCOPE("eglSwapBuffers");
+        swapped = withDamage ? _swapBuffersWithDamage(_eglDisplay, _eglSurface, damage, 1)
+                             : eglSwapBuffers(_eglDisplay, _eglSurface);
+    }
+    if (!swapped) {
+        testEGLError(withDamage ? "eglSwapBuffersWithDamage" : "eglSwapBuffers");
+        return false;
+    }
+    _frameStats.presented = true;
+    _frameTimer.setScale(_resolution.isEnabled() ? _resolution.getScale() : 1.0);
+    _redrawPending = false;
+
+    // 处理窗口系统消息(离屏模式下为空操作)
+    return handleNativeEvents();
+}
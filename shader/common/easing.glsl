@@ -0,0 +1,17 @@
+// 缓动曲线, 由预处理注入的EASING选择; 取值与GLESSceneConfig::easing的解析一致
+#define EASING_LINEAR 0
+#define EASING_POW5 1
+#define EASING_SMOOTHSTEP 2
+#ifndef EASING
+#define EASING EASING_POW5
+#endif
+
+float ease(float t) {
+#if EASING == EASING_LINEAR
+    return t;
+#elif EASING == EASING_SMOOTHSTEP
+    return t * t * (3.0 - 2.0 * t);
+#else
+    return pow(t, 5.0);
+#endif
+}
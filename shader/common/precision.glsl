@@ -0,0 +1,5 @@
+// 片元着色器的默认浮点精度, 由预处理注入的PRECISION选择
+#ifndef PRECISION
+#define PRECISION mediump
+#endif
+precision PRECISION float;
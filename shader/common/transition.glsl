@@ -0,0 +1,17 @@
+// 两张图片之间的过渡效果共用的输入
+#include "precision.glsl"
+
+#ifndef TEXTURE_COUNT
+#define TEXTURE_COUNT 3
+#endif
+
+varying vec2 v_texCoord;
+uniform float progress;
+uniform float speed;
+uniform sampler2D s_texture[TEXTURE_COUNT];
+
+// 只依赖uniform的表达式不在每个片元里重复计算, 由CPU每帧算一次后传入:
+// transition = clamp(progress * speed, 0.0, 1.0)
+// easedTransition = ease(transition), 缓动曲线与easing.glsl中EASING选中的一致
+uniform float transition;
+uniform float easedTransition;
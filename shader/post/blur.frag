@@ -0,0 +1,18 @@
+#version 300 es
+#include "../common/precision.glsl"
+
+uniform sampler2D s_input;
+// 沿模糊方向的一个步长: 纹素大小 * 半径, 水平和竖直各画一次
+uniform vec2 direction;
+in vec2 v_texCoord;
+out vec4 fragColor;
+
+void main() {
+    // 9抽头高斯核, 相邻两个抽头借线性过滤合成一次采样, 共5次
+    vec2 offset1 = direction * 1.3846153846;
+    vec2 offset2 = direction * 3.2307692308;
+    vec4 color = texture(s_input, v_texCoord) * 0.2270270270;
+    color += (texture(s_input, v_texCoord + offset1) + texture(s_input, v_texCoord - offset1)) * 0.3162162162;
+    color += (texture(s_input, v_texCoord + offset2) + texture(s_input, v_texCoord - offset2)) * 0.0702702703;
+    fragColor = color;
+}
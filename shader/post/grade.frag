@@ -0,0 +1,18 @@
+#version 300 es
+#include "../common/precision.glsl"
+
+uniform sampler2D s_input;
+// 曝光(档), 对比度和饱和度, 1为不变
+uniform float exposure;
+uniform float contrast;
+uniform float saturation;
+in vec2 v_texCoord;
+out vec4 fragColor;
+
+void main() {
+    vec3 color = texture(s_input, v_texCoord).rgb * exp2(exposure);
+    color = (color - 0.5) * contrast + 0.5;
+    float luma = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    color = mix(vec3(luma), color, saturation);
+    fragColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
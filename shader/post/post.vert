@@ -0,0 +1,10 @@
+#version 300 es
+
+out vec2 v_texCoord;
+
+void main() {
+    // 用gl_VertexID生成覆盖全屏的三角形, 不需要顶点数据
+    vec2 position = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0;
+    v_texCoord = position;
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
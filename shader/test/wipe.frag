@@ -0,0 +1,11 @@
+#include "../common/transition.glsl"
+
+void main() {
+    vec4 firstColor = texture2D(s_texture[0], v_texCoord);
+    vec4 secondColor = texture2D(s_texture[1], v_texCoord);
+
+    // 从左到右擦除, 边缘留一段渐变; 只有边缘的软化与片元位置有关
+    float edge = transition * 1.2 - 0.1;
+    float time = smoothstep(edge - 0.1, edge + 0.1, v_texCoord.x);
+    gl_FragColor = mix(secondColor, firstColor, time);
+}
@@ -0,0 +1,14 @@
+#version 300 es
+#include "../common/precision.glsl"
+precision mediump sampler2DArray;
+
+in vec2 v_texCoord;
+flat in vec3 v_layers;
+uniform sampler2DArray s_tiles;
+out vec4 fragColor;
+
+void main() {
+    vec4 firstColor = texture(s_tiles, vec3(v_texCoord, v_layers.x));
+    vec4 secondColor = texture(s_tiles, vec3(v_texCoord, v_layers.y));
+    fragColor = mix(firstColor, secondColor, v_layers.z);
+}
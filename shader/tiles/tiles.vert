@@ -0,0 +1,28 @@
+#version 300 es
+precision highp float;
+#include "../common/easing.glsl"
+
+layout(location = 0) in vec4 a_position;
+layout(location = 1) in vec2 a_texCoord;
+// 逐实例: 图块中心和半宽高(NDC)
+layout(location = 2) in vec4 a_rect;
+// 逐实例: 起始层, 相位偏移, 周期(秒)
+layout(location = 3) in vec3 a_timing;
+
+uniform float progress;
+uniform float speed;
+uniform float layerCount;
+
+out vec2 v_texCoord;
+// 同一图块的四个顶点取值相同, 不需要插值
+flat out vec3 v_layers;
+
+void main() {
+    float t = progress * speed / a_timing.z + a_timing.y;
+    float cycle = floor(t);
+    float from = mod(a_timing.x + cycle, layerCount);
+    // 每个周期前半段停留, 后半段渐变到下一层
+    v_layers = vec3(from, mod(from + 1.0, layerCount), ease(clamp((t - cycle - 0.5) * 2.0, 0.0, 1.0)));
+    v_texCoord = a_texCoord;
+    gl_Position = vec4(a_rect.xy + a_position.xy * a_rect.zw, 0.0, 1.0);
+}
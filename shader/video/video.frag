@@ -0,0 +1,21 @@
+#version 300 es
+#include "../common/precision.glsl"
+
+in vec2 v_texCoord;
+uniform sampler2D s_y;
+// I420时分别为U和V平面; NV12(预处理注入VIDEO_NV12)时s_u为交错的UV平面, s_v不使用
+uniform sampler2D s_u;
+uniform sampler2D s_v;
+// YUV->RGB, 含有限范围的偏移
+uniform mat4 colorMatrix;
+out vec4 fragColor;
+
+void main() {
+    float y = texture(s_y, v_texCoord).r;
+#ifdef VIDEO_NV12
+    vec2 uv = texture(s_u, v_texCoord).rg;
+#else
+    vec2 uv = vec2(texture(s_u, v_texCoord).r, texture(s_v, v_texCoord).r);
+#endif
+    fragColor = vec4(clamp((colorMatrix * vec4(y, uv, 1.0)).rgb, 0.0, 1.0), 1.0);
+}
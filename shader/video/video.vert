@@ -0,0 +1,12 @@
+#version 300 es
+precision mediump float;
+
+layout(location = 0) in vec4 a_position;
+layout(location = 1) in vec2 a_texCoord;
+out vec2 v_texCoord;
+
+void main() {
+    // 视频帧按自上而下的行序上传, 纹理坐标上下翻转
+    v_texCoord = vec2(a_texCoord.x, 1.0 - a_texCoord.y);
+    gl_Position = a_position;
+}